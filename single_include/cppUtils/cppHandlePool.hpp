@@ -0,0 +1,273 @@
+/*
+ -------- QUICK_START --------
+ This is a header only library. It allocates through cppUtils.hpp, so make sure the implementation
+ for that is defined in *one* C++ file like the other libraries in this directory, then include it
+ anywhere you please:
+
+ #include <cppUtils/cppHandlePool.hpp>
+
+
+
+ -------- LICENSE --------
+
+ Open Source
+
+
+
+ -------- DOCUMENTATION --------
+
+ Requires C++17 or greater.
+
+ A handle based object pool. Instead of passing raw pointers around you pass a Handle<T>, which is a
+ 32 bit index plus a 32 bit generation. When an object is destroyed the generation of its slot is bumped,
+ so any old handles to it stop resolving instead of dangling.
+
+ The live objects are kept packed together in one array, so iterating the pool is a linear walk over
+ contiguous memory. Create, destroy and lookup are all O(1):
+
+   * create  -- Pops a slot off the free list (or appends one) and constructs the object at the end of
+				the dense array.
+   * destroy -- Moves the last object in the dense array into the hole left behind, so the array stays
+				packed. This means destroy *does* change iteration order and invalidates raw pointers
+				into the pool. Handles stay valid.
+   * get     -- Checks the generation and returns a pointer into the dense array, or nullptr.
+
+ All memory comes from g_memory_allocate (the objects from g_memory_allocateAligned, so any alignof(T)
+ works), so leaks and buffer corruption in the pool are tracked like everything else.
+
+ ------ Example ------
+
+ struct Entity { Vec3 position; };
+
+ HandlePool<Entity> entities = {};
+ Handle<Entity> player = entities.create(Entity{ { 0, 0, 0 } });
+
+ if (Entity* entity = entities.get(player))
+ {
+	 entity->position.x += 1.0f;
+ }
+
+ for (Entity& entity : entities)
+ {
+	 // Packed iteration over every live entity
+ }
+
+ entities.destroy(player);
+ g_logger_assert(entities.get(player) == nullptr, "Stale handles resolve to nullptr.");
+
+ entities.free();
+*/
+#ifndef GABE_CPP_HANDLE_POOL_H
+#define GABE_CPP_HANDLE_POOL_H
+
+#include <stdint.h>
+#include <new>
+#include <utility>
+#include <cppUtils/cppUtils.hpp>
+
+namespace CppUtils
+{
+
+template<typename T>
+struct Handle
+{
+	uint32_t index;
+	// Generations start at 1, so a zero initialized handle is always null
+	uint32_t generation;
+
+	[[nodiscard]]
+	constexpr inline bool isNull() const { return generation == 0; }
+
+	[[nodiscard]]
+	constexpr inline uint64_t toU64() const { return ((uint64_t)generation << 32) | (uint64_t)index; }
+
+	[[nodiscard]]
+	static constexpr inline Handle<T> fromU64(uint64_t raw) { return Handle<T>{ (uint32_t)(raw & 0xFFFFFFFF), (uint32_t)(raw >> 32) }; }
+
+	constexpr inline bool operator==(const Handle<T>& other) const { return index == other.index && generation == other.generation; }
+	constexpr inline bool operator!=(const Handle<T>& other) const { return !(*this == other); }
+};
+
+struct HandlePoolSlot
+{
+	// When the slot is live this is the index into the dense array. When the slot is free this is
+	// the next free slot plus one (0 means end of the free list).
+	uint32_t denseIndexOrNextFree;
+	uint32_t generation;
+	bool isLive;
+};
+
+// Zero initialize this (`HandlePool<T> pool = {};`) and call free() when you're done with it
+template<typename T>
+struct HandlePool
+{
+	T* dense;
+	uint32_t* denseToSlot;
+	uint32_t numLive;
+	uint32_t denseCapacity;
+
+	HandlePoolSlot* slots;
+	uint32_t numSlots;
+	uint32_t slotsCapacity;
+	// Head of the free list plus one, 0 means the free list is empty
+	uint32_t freeListHead;
+
+	template<typename...Args>
+	Handle<T> create(Args&&... args)
+	{
+		uint32_t denseIndex = numLive;
+		if (numLive >= denseCapacity)
+		{
+			growDense(denseCapacity == 0 ? 8 : denseCapacity * 2, std::forward<Args>(args)...);
+		}
+		else
+		{
+			new(dense + denseIndex)T(std::forward<Args>(args)...);
+		}
+		numLive++;
+
+		uint32_t slotIndex;
+		if (freeListHead != 0)
+		{
+			slotIndex = freeListHead - 1;
+			freeListHead = slots[slotIndex].denseIndexOrNextFree;
+		}
+		else
+		{
+			if (numSlots >= slotsCapacity)
+			{
+				slotsCapacity = slotsCapacity == 0 ? 8 : slotsCapacity * 2;
+				slots = (HandlePoolSlot*)g_memory_realloc(slots, sizeof(HandlePoolSlot) * slotsCapacity);
+			}
+
+			slotIndex = numSlots++;
+			slots[slotIndex].generation = 1;
+		}
+
+		denseToSlot[denseIndex] = slotIndex;
+
+		HandlePoolSlot& slot = slots[slotIndex];
+		slot.denseIndexOrNextFree = denseIndex;
+		slot.isLive = true;
+
+		return Handle<T>{ slotIndex, slot.generation };
+	}
+
+	bool destroy(Handle<T> handle)
+	{
+		if (!isValid(handle))
+		{
+			return false;
+		}
+
+		HandlePoolSlot& slot = slots[handle.index];
+		uint32_t denseIndex = slot.denseIndexOrNextFree;
+		uint32_t lastIndex = numLive - 1;
+
+		// Swap and pop so the live objects stay packed
+		if (denseIndex != lastIndex)
+		{
+			dense[denseIndex] = std::move(dense[lastIndex]);
+			denseToSlot[denseIndex] = denseToSlot[lastIndex];
+			slots[denseToSlot[denseIndex]].denseIndexOrNextFree = denseIndex;
+		}
+		dense[lastIndex].~T();
+		numLive--;
+
+		// Skip generation 0 on wrap around so a stale handle can never look like a null one
+		slot.generation = slot.generation + 1 == 0 ? 1 : slot.generation + 1;
+		slot.isLive = false;
+		slot.denseIndexOrNextFree = freeListHead;
+		freeListHead = handle.index + 1;
+
+		return true;
+	}
+
+	[[nodiscard]]
+	inline bool isValid(Handle<T> handle) const
+	{
+		return handle.index < numSlots
+			&& slots[handle.index].isLive
+			&& slots[handle.index].generation == handle.generation;
+	}
+
+	[[nodiscard]]
+	inline T* get(Handle<T> handle)
+	{
+		return isValid(handle) ? dense + slots[handle.index].denseIndexOrNextFree : nullptr;
+	}
+
+	[[nodiscard]]
+	inline const T* get(Handle<T> handle) const
+	{
+		return isValid(handle) ? dense + slots[handle.index].denseIndexOrNextFree : nullptr;
+	}
+
+	// Gets the handle for the object at `denseIndex` while iterating over the pool
+	[[nodiscard]]
+	inline Handle<T> handleAt(uint32_t denseIndex) const
+	{
+		uint32_t slotIndex = denseToSlot[denseIndex];
+		return Handle<T>{ slotIndex, slots[slotIndex].generation };
+	}
+
+	[[nodiscard]]
+	inline uint32_t size() const { return numLive; }
+
+	inline T* begin() { return dense; }
+	inline T* end() { return dense + numLive; }
+	inline const T* begin() const { return dense; }
+	inline const T* end() const { return dense + numLive; }
+
+	// Destroys every live object. All outstanding handles become stale, but the memory is kept around.
+	void clear()
+	{
+		while (numLive > 0)
+		{
+			destroy(handleAt(numLive - 1));
+		}
+	}
+
+	void free()
+	{
+		clear();
+
+		g_memory_freeAligned(dense);
+		g_memory_free(denseToSlot);
+		g_memory_free(slots);
+
+		dense = nullptr;
+		denseToSlot = nullptr;
+		slots = nullptr;
+		numLive = 0;
+		denseCapacity = 0;
+		numSlots = 0;
+		slotsCapacity = 0;
+		freeListHead = 0;
+	}
+
+private:
+	// Also constructs the object being created at the end of the new array. That happens before the old
+	// objects move, since args can still refer to one of them.
+	template<typename...Args>
+	void growDense(uint32_t newCapacity, Args&&... args)
+	{
+		// Can't realloc here since T may not be trivially relocatable
+		T* newDense = (T*)g_memory_allocateAligned(sizeof(T) * newCapacity, alignof(T));
+		new(newDense + numLive)T(std::forward<Args>(args)...);
+		for (uint32_t i = 0; i < numLive; i++)
+		{
+			new(newDense + i)T(std::move(dense[i]));
+			dense[i].~T();
+		}
+		g_memory_freeAligned(dense);
+
+		dense = newDense;
+		denseToSlot = (uint32_t*)g_memory_realloc(denseToSlot, sizeof(uint32_t) * newCapacity);
+		denseCapacity = newCapacity;
+	}
+};
+
+} // End CppUtils
+
+#endif // End GABE_CPP_HANDLE_POOL_H
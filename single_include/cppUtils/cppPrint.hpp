@@ -234,6 +234,10 @@ GABE_CPP_PRINT_API void printFormattedString(const char* content, size_t content
 
 GABE_CPP_PRINT_API void printf(const char* s);
 
+// Hands everything this thread prints to write instead of stdout, until it's called again with nullptr
+typedef void (*CaptureFn)(void* userData, const char* s, size_t length);
+GABE_CPP_PRINT_API void setCapture(CaptureFn write, void* userData);
+
 GABE_CPP_PRINT_API void setColor(ConsoleColor background, ConsoleColor foreground);
 GABE_CPP_PRINT_API void setBackgroundColor(ConsoleColor background);
 GABE_CPP_PRINT_API void setForegroundColor(ConsoleColor foreground);
@@ -409,6 +413,9 @@ Stream stdoutStream = {
 // NOTE: Big enough to hold 64 bits (for binary representation) plus an apostrophe every 4 bits (for clarity in reading)
 static constexpr size_t maxIntegerBufferSize = 81;
 
+static thread_local CaptureFn captureFn = nullptr;
+static thread_local void* captureUserData = nullptr;
+
 // ------ Internal functions ------
 static const char* getIntPrefix(const Stream& io);
 static size_t getIntPrefixSize(const Stream& io);
@@ -1271,6 +1278,12 @@ namespace CppUtils
 namespace IO
 {
 
+void setCapture(CaptureFn write, void* userData)
+{
+	captureFn = write;
+	captureUserData = userData;
+}
+
 // ------ Internal functions ------
 static const char* getIntPrefix(const Stream& io)
 {
@@ -1697,6 +1710,12 @@ void printf(const char* s)
 
 void _printfInternal(const char* s, size_t length)
 {
+	if (captureFn)
+	{
+		captureFn(captureUserData, s, length);
+		return;
+	}
+
 	initializeStdoutIfNecessary();
 	if (length <= MAXDWORD)
 	{
@@ -1889,11 +1908,17 @@ namespace IO
 
 void printf(const char* s)
 {
-	std::cout << s;
+	_printfInternal(s, std::strlen(s));
 }
 
 void _printfInternal(const char* s, size_t length)
 {
+	if (captureFn)
+	{
+		captureFn(captureUserData, s, length);
+		return;
+	}
+
 	if (length >= 0 && length <= INT32_MAX)
 	{
 		printf("%.*s", (int)length, s);
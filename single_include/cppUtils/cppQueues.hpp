@@ -0,0 +1,441 @@
+/*
+ -------- QUICK_START --------
+ This is a header only library. It allocates through cppUtils.hpp, so make sure the implementation
+ for that is defined in *one* C++ file like the other libraries in this directory, then include it
+ anywhere you please:
+
+ #include <cppUtils/cppQueues.hpp>
+
+
+
+ -------- LICENSE --------
+
+ Open Source
+
+
+
+ -------- DOCUMENTATION --------
+
+ Requires C++17 or greater.
+
+ Bounded lock free queues for handing things between threads. Both have a fixed capacity that's picked
+ in init() (rounded up to a power of two), never allocate after that, and return false instead of
+ blocking when they're full or empty.
+
+   * SpscQueue<T> -- One producer thread and one consumer thread. Wait free: push and pop are a
+					 handful of loads and stores with no retry loops. Each side keeps a cached copy of
+					 the other side's index, so they only touch each other's cache line when the cached
+					 copy says the queue looks full (or empty).
+   * MpmcQueue<T> -- Any number of producers and consumers. This is Dmitry Vyukov's bounded MPMC
+					 queue: every cell has a sequence number that says whose turn it is, so producers
+					 and consumers only contend on one CAS for their own end of the queue.
+
+ The producer index, the consumer index and the buffer all sit on their own cache lines, so producers
+ and consumers don't false share.
+
+ pushBatch() and popBatch() move up to `count` elements at once and return how many they moved. For
+ the MPMC queue that's one CAS for the whole batch instead of one per element.
+
+ All memory comes from g_memory_allocate, so leaks and buffer corruption are tracked like everything
+ else.
+
+ ------ Example ------
+
+ MpmcQueue<Message> queue = {};
+ queue.init(1024);
+
+ // Producers
+ if (!queue.push(Message{ ... }))
+ {
+	 // Full, try again later or drop it
+ }
+
+ // Consumers
+ Message message;
+ while (queue.pop(message))
+ {
+	 handle(message);
+ }
+
+ queue.free();
+*/
+#ifndef GABE_CPP_QUEUES_H
+#define GABE_CPP_QUEUES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include <atomic>
+#include <cppUtils/cppUtils.hpp>
+
+GABE_CPP_UTILS_ALLOW_PADDING_BEGIN
+
+namespace CppUtils
+{
+
+inline size_t queueRoundCapacity(size_t minCapacity)
+{
+	size_t rounded = 2;
+	while (rounded < minCapacity)
+	{
+		rounded *= 2;
+	}
+	return rounded;
+}
+
+// Zero initialize this (`SpscQueue<T> queue = {};`), call init() before using it and free() when
+// you're done with it. Only one thread may push and only one thread may pop.
+template<typename T>
+struct SpscQueue
+{
+	// Only the consumer writes these
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<size_t> head;
+	size_t cachedTail;
+
+	// Only the producer writes these
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<size_t> tail;
+	size_t cachedHead;
+
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) T* buffer;
+	size_t mask;
+
+	void init(size_t minCapacity)
+	{
+		size_t roundedCapacity = queueRoundCapacity(minCapacity);
+		buffer = (T*)g_memory_allocateAligned(sizeof(T) * roundedCapacity, GABE_CPP_UTILS_CACHE_LINE_SIZE);
+		mask = roundedCapacity - 1;
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+		cachedHead = 0;
+		cachedTail = 0;
+	}
+
+	// Destroys anything still in the queue. Neither side can be using it anymore.
+	void free()
+	{
+		size_t end = tail.load(std::memory_order_relaxed);
+		for (size_t i = head.load(std::memory_order_relaxed); i != end; i++)
+		{
+			buffer[i & mask].~T();
+		}
+
+		g_memory_freeAligned(buffer);
+		buffer = nullptr;
+		mask = 0;
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+		cachedHead = 0;
+		cachedTail = 0;
+	}
+
+	template<typename...Args>
+	bool push(Args&&... args)
+	{
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail - cachedHead > mask)
+		{
+			cachedHead = head.load(std::memory_order_acquire);
+			if (currentTail - cachedHead > mask)
+			{
+				return false;
+			}
+		}
+
+		new(buffer + (currentTail & mask))T(std::forward<Args>(args)...);
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& out)
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead == cachedTail)
+		{
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (currentHead == cachedTail)
+			{
+				return false;
+			}
+		}
+
+		T& element = buffer[currentHead & mask];
+		out = std::move(element);
+		element.~T();
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Copies as many of items as there's room for and returns how many that was
+	size_t pushBatch(const T* items, size_t count)
+	{
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (mask + 1 - (currentTail - cachedHead) < count)
+		{
+			cachedHead = head.load(std::memory_order_acquire);
+		}
+
+		size_t numFree = mask + 1 - (currentTail - cachedHead);
+		size_t numToPush = count < numFree ? count : numFree;
+		for (size_t i = 0; i < numToPush; i++)
+		{
+			new(buffer + ((currentTail + i) & mask))T(items[i]);
+		}
+
+		// One release for the whole batch
+		tail.store(currentTail + numToPush, std::memory_order_release);
+		return numToPush;
+	}
+
+	// Moves up to maxCount elements into out and returns how many that was
+	size_t popBatch(T* out, size_t maxCount)
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (cachedTail - currentHead < maxCount)
+		{
+			cachedTail = tail.load(std::memory_order_acquire);
+		}
+
+		size_t available = cachedTail - currentHead;
+		size_t numToPop = maxCount < available ? maxCount : available;
+		for (size_t i = 0; i < numToPop; i++)
+		{
+			T& element = buffer[(currentHead + i) & mask];
+			out[i] = std::move(element);
+			element.~T();
+		}
+
+		head.store(currentHead + numToPop, std::memory_order_release);
+		return numToPop;
+	}
+
+	// Only a snapshot, the other side can change it right after this returns
+	[[nodiscard]]
+	inline size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+
+	[[nodiscard]]
+	inline size_t capacity() const { return mask + 1; }
+};
+
+// Zero initialize this (`MpmcQueue<T> queue = {};`), call init() before using it and free() when
+// you're done with it. Any number of threads can push and pop at the same time.
+template<typename T>
+struct MpmcQueue
+{
+	struct Cell
+	{
+		// pos when the cell is free for the producer that gets position pos, pos + 1 once that producer
+		// filled it in, and pos + capacity after the consumer took it out again
+		std::atomic<size_t> sequence;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos;
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos;
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) Cell* cells;
+	size_t mask;
+
+	void init(size_t minCapacity)
+	{
+		size_t roundedCapacity = queueRoundCapacity(minCapacity);
+		cells = (Cell*)g_memory_allocateAligned(sizeof(Cell) * roundedCapacity, GABE_CPP_UTILS_CACHE_LINE_SIZE);
+		for (size_t i = 0; i < roundedCapacity; i++)
+		{
+			new(&cells[i].sequence)std::atomic<size_t>(i);
+		}
+		mask = roundedCapacity - 1;
+		enqueuePos.store(0, std::memory_order_relaxed);
+		dequeuePos.store(0, std::memory_order_relaxed);
+	}
+
+	// Destroys anything still in the queue. Nobody can be using it anymore.
+	void free()
+	{
+		size_t end = enqueuePos.load(std::memory_order_relaxed);
+		for (size_t pos = dequeuePos.load(std::memory_order_relaxed); pos != end; pos++)
+		{
+			element(cells[pos & mask]).~T();
+		}
+
+		g_memory_freeAligned(cells);
+		cells = nullptr;
+		mask = 0;
+		enqueuePos.store(0, std::memory_order_relaxed);
+		dequeuePos.store(0, std::memory_order_relaxed);
+	}
+
+	template<typename...Args>
+	bool push(Args&&... args)
+	{
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true)
+		{
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)pos;
+			if (difference == 0)
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// The consumer a full lap behind us hasn't taken this cell out yet
+				return false;
+			}
+			else
+			{
+				// Another producer got this position first
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		new(cell->storage)T(std::forward<Args>(args)...);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& out)
+	{
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true)
+		{
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)(pos + 1);
+			if (difference == 0)
+			{
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// Empty, or the producer for this position hasn't finished writing yet
+				return false;
+			}
+			else
+			{
+				pos = dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		T& value = element(*cell);
+		out = std::move(value);
+		value.~T();
+		cell->sequence.store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Claims as many free cells in a row as it can (up to count) with a single CAS, copies items into
+	// them and returns how many it pushed
+	size_t pushBatch(const T* items, size_t count)
+	{
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		size_t numClaimed;
+		while (true)
+		{
+			numClaimed = countReady(pos, count, 0);
+			if (numClaimed == 0)
+			{
+				// Either it's full or someone else moved the position, only the second is worth a retry
+				size_t currentPos = enqueuePos.load(std::memory_order_relaxed);
+				if (currentPos == pos)
+				{
+					return 0;
+				}
+				pos = currentPos;
+				continue;
+			}
+
+			if (enqueuePos.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+
+		for (size_t i = 0; i < numClaimed; i++)
+		{
+			Cell& cell = cells[(pos + i) & mask];
+			new(cell.storage)T(items[i]);
+			cell.sequence.store(pos + i + 1, std::memory_order_release);
+		}
+		return numClaimed;
+	}
+
+	// Claims as many filled cells in a row as it can (up to maxCount) with a single CAS, moves them into
+	// out and returns how many it popped
+	size_t popBatch(T* out, size_t maxCount)
+	{
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		size_t numClaimed;
+		while (true)
+		{
+			numClaimed = countReady(pos, maxCount, 1);
+			if (numClaimed == 0)
+			{
+				size_t currentPos = dequeuePos.load(std::memory_order_relaxed);
+				if (currentPos == pos)
+				{
+					return 0;
+				}
+				pos = currentPos;
+				continue;
+			}
+
+			if (dequeuePos.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+
+		for (size_t i = 0; i < numClaimed; i++)
+		{
+			Cell& cell = cells[(pos + i) & mask];
+			T& value = element(cell);
+			out[i] = std::move(value);
+			value.~T();
+			cell.sequence.store(pos + i + mask + 1, std::memory_order_release);
+		}
+		return numClaimed;
+	}
+
+	// Only a snapshot, other threads can change it right after this returns
+	[[nodiscard]]
+	inline size_t size() const
+	{
+		size_t end = enqueuePos.load(std::memory_order_acquire);
+		size_t start = dequeuePos.load(std::memory_order_acquire);
+		return end > start ? end - start : 0;
+	}
+
+	[[nodiscard]]
+	inline size_t capacity() const { return mask + 1; }
+
+private:
+	static inline T& element(Cell& cell) { return *std::launder((T*)cell.storage); }
+
+	// How many cells starting at pos have sequence == position + offset, stopping at the first one that
+	// doesn't. Those are ours to claim if the CAS on pos succeeds, nobody else can touch them first.
+	size_t countReady(size_t pos, size_t maxCount, size_t offset) const
+	{
+		size_t count = 0;
+		while (count < maxCount && count <= mask
+			&& cells[(pos + count) & mask].sequence.load(std::memory_order_acquire) == pos + count + offset)
+		{
+			count++;
+		}
+		return count;
+	}
+};
+
+} // End CppUtils
+
+GABE_CPP_UTILS_ALLOW_PADDING_END
+
+#endif // End GABE_CPP_QUEUES_H
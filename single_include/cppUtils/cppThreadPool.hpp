@@ -0,0 +1,1525 @@
+/*
+ -------- QUICK_START --------
+ This is a header only library. It allocates through cppUtils.hpp, so make sure the implementation
+ for that is defined in *one* C++ file like the other libraries in this directory, then include it
+ anywhere you please:
+
+ #include <cppUtils/cppThreadPool.hpp>
+
+
+
+ -------- LICENSE --------
+
+ Open Source
+
+
+
+ -------- DOCUMENTATION --------
+
+ Requires C++17 or greater.
+
+ A work stealing thread pool. Every worker owns a Chase-Lev deque. Tasks a worker submits go on the
+ bottom of its own deque and it pops them back off the bottom (LIFO, so the data it just touched is
+ still in cache). Workers that run out of work steal from the top of a randomly picked victim's deque
+ (FIFO, so they take the oldest and usually biggest pieces of work). None of this takes a lock.
+
+ Tasks submitted from threads that aren't part of the pool go into a small mutex protected queue that
+ the workers check before they go stealing.
+
+ Workers that can't find anything spin for a little bit and then park on a condition variable, so an
+ idle pool doesn't burn any CPU. Submitting only touches the condition variable when someone is
+ actually parked.
+
+ Submitting never allocates. The callable is constructed straight into a task slot that is
+ GABE_THREAD_POOL_TASK_SIZE (48) bytes big, and the slots are allocated up front in init(). A callable
+ that doesn't fit is a compile error, capture a pointer to your data instead of the data itself (or
+ define GABE_THREAD_POOL_TASK_SIZE before including this file). If every slot is in flight, submit()
+ runs the task right away on the calling thread instead of blocking.
+
+ parallelFor() and parallelReduce() are fork-join loops on top of the pool. The calling thread works
+ through the range itself and only splits off the back half of what it has left when its deque is
+ empty, which means some other thread is out of work and could steal it. Busy pools barely split at
+ all, idle ones split all the way down to the grain size.
+
+ TaskGraph is a DAG of tasks for things like per frame pipelines. Build it once with addNode() and
+ addEdge(), then run() it on a pool as many times as you want. Each node keeps an atomic count of the
+ dependencies it's still waiting on, and the thread that finishes the last of them runs it, so there's
+ no central lock. Re-running a graph that hasn't changed doesn't allocate anything.
+
+ async() runs a callback that returns a Maybe<T, E> (see cppMaybe.hpp) and hands back a Future<T, E>
+ for it. then() chains another callback onto a future. It runs on the pool with the value, and errors
+ skip it and pass straight through. whenAll() and whenAny() combine arrays of futures. Futures are
+ reference counted handles to a shared state. The state and any continuations live in fixed size
+ blocks (GABE_THREAD_POOL_FUTURE_SIZE, 112 bytes) from per thread free lists in the pool, and
+ resolving one is a single atomic exchange. No mutex is involved unless the future was created outside
+ the pool. Every Future has to be destroyed before the pool is freed.
+
+ All memory comes from g_memory_allocate, so leaks and buffer corruption in the pool are tracked like
+ everything else.
+
+ ------ Example ------
+
+ ThreadPool pool = {};
+ pool.init();
+
+ std::atomic<int> sum = 0;
+ for (int i = 0; i < 100; i++)
+ {
+	 pool.submit([&sum, i]() { sum += i; });
+ }
+
+ // Runs tasks on this thread too until everything submitted so far is done
+ pool.wait();
+ g_logger_assert(sum == 4950, "Every task ran.");
+
+ pool.parallelFor(0, records.size(), 0, [&](size_t i)
+ {
+	 process(records[i]);
+ });
+
+ float total = pool.parallelReduce(0, records.size(), 0, 0.0f,
+	 [&](size_t i) { return records[i].amount; },
+	 [](float a, float b) { return a + b; });
+
+ {
+	 Future<Image, LoadError> image = pool.async([path]() { return loadImage(path); });
+	 Future<Texture, LoadError> texture = image.then([](const Image& image) { return uploadTexture(image); });
+
+	 const Maybe<Texture, LoadError>& result = texture.get();
+	 if (!result.hasValue())
+	 {
+		 g_logger_error("Failed to load texture.");
+	 }
+ }
+
+ TaskGraph frame = {};
+ uint32_t input = frame.addNode([&]() { pollInput(); });
+ uint32_t physics = frame.addNode([&]() { stepPhysics(); });
+ uint32_t render = frame.addNode([&]() { render(); });
+ frame.addEdge(input, physics);
+ frame.addEdge(physics, render);
+
+ while (isRunning)
+ {
+	 frame.run(pool);
+ }
+
+ frame.free();
+ pool.free();
+*/
+#ifndef GABE_CPP_THREAD_POOL_H
+#define GABE_CPP_THREAD_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cppUtils/cppUtils.hpp>
+#include <cppUtils/cppMaybe.hpp>
+
+// Bytes of inline storage each task gets for its callable. With the task header that's one cache line.
+#ifndef GABE_THREAD_POOL_TASK_SIZE
+#define GABE_THREAD_POOL_TASK_SIZE 48
+#endif
+
+// Bytes each future state or continuation gets, they share one block size so they can share free lists
+#ifndef GABE_THREAD_POOL_FUTURE_SIZE
+#define GABE_THREAD_POOL_FUTURE_SIZE 112
+#endif
+
+GABE_CPP_UTILS_ALLOW_PADDING_BEGIN
+
+namespace CppUtils
+{
+
+struct ThreadPoolTask
+{
+	// Invokes the callable in storage and then destroys it
+	void (*run)(void* storage);
+	// While the slot is free this is the next free slot plus one (0 means end of the free list)
+	std::atomic<uint32_t> nextFree;
+	// Index of the task list this slot came from
+	uint32_t owner;
+	alignas(16) unsigned char storage[GABE_THREAD_POOL_TASK_SIZE];
+};
+
+// Fixed capacity Chase-Lev deque (the C11 version from "Correct and Efficient Work-Stealing for Weak
+// Memory Models", Le et al. 2013). Only the owning worker calls push and pop, anyone can call steal.
+struct ThreadPoolDeque
+{
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<int64_t> top;
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<int64_t> bottom;
+	std::atomic<ThreadPoolTask*>* buffer;
+	int64_t mask;
+
+	// The pool never pushes more tasks than the deque can hold, every task in here came out of the
+	// owner's task list and that has exactly as many slots as the deque.
+	inline void push(ThreadPoolTask* task)
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		buffer[b & mask].store(task, std::memory_order_relaxed);
+		bottom.store(b + 1, std::memory_order_release);
+	}
+
+	inline ThreadPoolTask* pop()
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			// Empty
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		ThreadPoolTask* task = buffer[b & mask].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			// Last one left, race the thieves for it
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				task = nullptr;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+
+		return task;
+	}
+
+	inline ThreadPoolTask* steal()
+	{
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+		{
+			return nullptr;
+		}
+
+		// The owner may be overwriting this slot if it wrapped around, but then top moved and the
+		// CAS below fails, so the value never gets used
+		ThreadPoolTask* task = buffer[t & mask].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			// Lost the race to the owner or another thief
+			return nullptr;
+		}
+
+		return task;
+	}
+
+	[[nodiscard]]
+	inline bool isEmpty() const
+	{
+		return bottom.load(std::memory_order_acquire) <= top.load(std::memory_order_acquire);
+	}
+};
+
+// Memory for future states and their continuations, see Future below
+struct ThreadPoolFutureBlock
+{
+	// While the block is free this is the next free block plus one (0 means end of the free list)
+	std::atomic<uint32_t> nextFree;
+	// Index of the list this block came from
+	uint32_t owner;
+	alignas(16) unsigned char storage[GABE_THREAD_POOL_FUTURE_SIZE];
+};
+
+// The task slots (or future blocks) one thread allocates from. Only the owner takes slots out, but any
+// thread can give them back once it's done with them.
+template<typename Slot>
+struct ThreadPoolSlotList
+{
+	Slot* slots;
+	// Free list only the owner touches, holds the first free slot plus one
+	uint32_t localFree;
+	// Slots other threads gave back. They push with a CAS and the owner takes the whole list at once
+	// with an exchange, so there's no ABA problem.
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<uint32_t> remoteFree;
+};
+
+struct ThreadPoolWorker
+{
+	ThreadPoolDeque deque;
+	ThreadPoolSlotList<ThreadPoolTask> tasks;
+	ThreadPoolSlotList<ThreadPoolFutureBlock> futureBlocks;
+	std::thread thread;
+	uint32_t rng;
+};
+
+template<typename T, typename E>
+struct Future;
+
+template<typename T, typename E>
+struct FutureState;
+
+struct FutureStateBase;
+
+// Pulls T and E back out of the Maybe<T, E> a callback returns
+template<typename R>
+struct FutureMaybeTraits
+{
+	static constexpr bool isMaybe = false;
+};
+
+template<typename T, typename E>
+struct FutureMaybeTraits<Maybe<T, E>>
+{
+	static constexpr bool isMaybe = true;
+	using Value = T;
+	using Error = E;
+};
+
+// Zero initialize this (`ThreadPool pool = {};`), call init() before using it and free() when you're
+// done with it
+struct ThreadPool
+{
+	// numThreads of 0 means one worker per hardware thread minus one, since the thread that waits on
+	// the pool helps run tasks. tasksPerThread is how many tasks each thread can have in flight before
+	// submit() starts running them inline, it gets rounded up to a power of two.
+	void init(uint32_t numThreads = 0, uint32_t tasksPerThread = 1024)
+	{
+		if (numThreads == 0)
+		{
+			uint32_t hardwareThreads = (uint32_t)std::thread::hardware_concurrency();
+			numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		taskCapacity = 1;
+		while (taskCapacity < tasksPerThread)
+		{
+			taskCapacity *= 2;
+		}
+
+		numWorkers = numThreads;
+		stopping.store(false, std::memory_order_relaxed);
+		numPending.store(0, std::memory_order_relaxed);
+		numSleeping.store(0, std::memory_order_relaxed);
+		wakeEpoch = 0;
+
+		// Threads outside the pool share the lists at index numWorkers
+		initSlotList(externalTasks, numWorkers);
+		initSlotList(externalFutureBlocks, numWorkers);
+		injected = (ThreadPoolTask**)g_memory_allocateAligned(sizeof(ThreadPoolTask*) * taskCapacity, GABE_CPP_UTILS_CACHE_LINE_SIZE);
+		injectedHead = 0;
+		numInjected.store(0, std::memory_order_relaxed);
+
+		workers = (ThreadPoolWorker*)g_memory_allocateAligned(sizeof(ThreadPoolWorker) * numWorkers, GABE_CPP_UTILS_CACHE_LINE_SIZE);
+		for (uint32_t i = 0; i < numWorkers; i++)
+		{
+			ThreadPoolWorker* worker = new(workers + i)ThreadPoolWorker();
+			worker->deque.top.store(0, std::memory_order_relaxed);
+			worker->deque.bottom.store(0, std::memory_order_relaxed);
+			worker->deque.buffer = (std::atomic<ThreadPoolTask*>*)g_memory_allocateAligned(sizeof(std::atomic<ThreadPoolTask*>) * taskCapacity, GABE_CPP_UTILS_CACHE_LINE_SIZE);
+			for (uint32_t j = 0; j < taskCapacity; j++)
+			{
+				new(worker->deque.buffer + j)std::atomic<ThreadPoolTask*>(nullptr);
+			}
+			worker->deque.mask = (int64_t)taskCapacity - 1;
+			initSlotList(worker->tasks, i);
+			initSlotList(worker->futureBlocks, i);
+			// Any non zero seed works for xorshift
+			worker->rng = 0x9E3779B9u * (i + 1);
+		}
+
+		// Start the threads last so they never see a half initialized pool
+		for (uint32_t i = 0; i < numWorkers; i++)
+		{
+			workers[i].thread = std::thread([this, i]() { workerMain(i); });
+		}
+	}
+
+	// Finishes every task that's been submitted, then stops and joins the workers
+	void free()
+	{
+		if (workers == nullptr)
+		{
+			return;
+		}
+
+		wait();
+
+		{
+			std::lock_guard<std::mutex> lock(parkMutex);
+			stopping.store(true, std::memory_order_release);
+			wakeEpoch++;
+		}
+		parkCv.notify_all();
+
+		for (uint32_t i = 0; i < numWorkers; i++)
+		{
+			workers[i].thread.join();
+			for (uint32_t j = 0; j < taskCapacity; j++)
+			{
+				workers[i].deque.buffer[j].~atomic();
+			}
+			g_memory_freeAligned(workers[i].deque.buffer);
+			g_memory_freeAligned(workers[i].tasks.slots);
+			g_memory_freeAligned(workers[i].futureBlocks.slots);
+			workers[i].~ThreadPoolWorker();
+		}
+		g_memory_freeAligned(workers);
+		g_memory_freeAligned(externalTasks.slots);
+		g_memory_freeAligned(externalFutureBlocks.slots);
+		g_memory_freeAligned(injected);
+
+		workers = nullptr;
+		injected = nullptr;
+		externalTasks.slots = nullptr;
+		externalFutureBlocks.slots = nullptr;
+		numWorkers = 0;
+		taskCapacity = 0;
+	}
+
+	template<typename F>
+	void submit(F&& fn)
+	{
+		using Fn = std::decay_t<F>;
+		static_assert(sizeof(Fn) <= GABE_THREAD_POOL_TASK_SIZE,
+			"This callable is too big to store inline in a task. Capture a pointer to your data instead, or define a bigger GABE_THREAD_POOL_TASK_SIZE.");
+		static_assert(alignof(Fn) <= 16, "Tasks can't hold callables that need more than 16 byte alignment.");
+
+		ThreadPoolTask* task = allocateSlot(&ThreadPoolWorker::tasks, externalTasks);
+		if (task == nullptr)
+		{
+			// Every slot is in flight, run it here instead of blocking until one frees up
+			fn();
+			return;
+		}
+
+		new(task->storage)Fn(std::forward<F>(fn));
+		task->run = [](void* storage)
+		{
+			Fn* callable = (Fn*)storage;
+			(*callable)();
+			callable->~Fn();
+		};
+
+		numPending.fetch_add(1, std::memory_order_relaxed);
+		pushTask(task);
+	}
+
+	// Runs fn() on the pool and returns a Future for the Maybe<T, E> it returns. Every Future has to be
+	// gone before the pool is freed.
+	template<typename F>
+	auto async(F&& fn)
+	{
+		using Fn = std::decay_t<F>;
+		using Result = std::invoke_result_t<Fn&>;
+		static_assert(FutureMaybeTraits<Result>::isMaybe, "ThreadPool::async() callbacks have to return a Maybe.");
+		using T = typename FutureMaybeTraits<Result>::Value;
+		using E = typename FutureMaybeTraits<Result>::Error;
+
+		// One reference for the Future we hand back and one for the task that resolves it
+		FutureState<T, E>* state = FutureState<T, E>::create(this, 2);
+		submit([state, callable = Fn(std::forward<F>(fn))]() mutable
+		{
+			state->resolve(callable());
+			state->release();
+		});
+
+		return Future<T, E>(state);
+	}
+
+	// Future states and continuations come out of per thread block lists just like tasks do, and only
+	// fall back to the heap when those run dry. Used by Future, you shouldn't need to call these.
+	void* allocateFutureBlock()
+	{
+		ThreadPoolFutureBlock* block = allocateSlot(&ThreadPoolWorker::futureBlocks, externalFutureBlocks);
+		if (block == nullptr)
+		{
+			block = new(g_memory_allocateAligned(sizeof(ThreadPoolFutureBlock), GABE_CPP_UTILS_CACHE_LINE_SIZE))ThreadPoolFutureBlock();
+			block->owner = UINT32_MAX;
+		}
+
+		return block->storage;
+	}
+
+	void releaseFutureBlock(void* memory)
+	{
+		ThreadPoolFutureBlock* block = (ThreadPoolFutureBlock*)((uint8_t*)memory - offsetof(ThreadPoolFutureBlock, storage));
+		if (block->owner == UINT32_MAX)
+		{
+			block->~ThreadPoolFutureBlock();
+			g_memory_freeAligned(block);
+			return;
+		}
+
+		releaseSlot(block, &ThreadPoolWorker::futureBlocks, externalFutureBlocks);
+	}
+
+	// Runs tasks on the calling thread until everything submitted so far has finished. Don't call this
+	// from inside a task, the task calling it counts as unfinished so it would never return.
+	void wait()
+	{
+		g_logger_assert(currentPool != this, "ThreadPool::wait() can't be called from inside one of the pool's own tasks.");
+		helpUntil([this]() { return numPending.load(std::memory_order_acquire) == 0; });
+	}
+
+	// Runs the pool's tasks on the calling thread until done() returns true. Works from workers and
+	// from outside threads.
+	template<typename Predicate>
+	void helpUntil(Predicate&& done)
+	{
+		while (!done())
+		{
+			ThreadPoolTask* task = currentPool == this
+				? findTask(currentWorker)
+				: stealTask(numWorkers, externalRng);
+			if (task != nullptr)
+			{
+				execute(task);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	[[nodiscard]]
+	inline uint32_t size() const { return numWorkers; }
+
+	// True when called from one of this pool's workers
+	[[nodiscard]]
+	inline bool isWorkerThread() const { return currentPool == this; }
+
+	// Calls fn(i) for every i in [begin, end) and returns once they've all run. The calling thread
+	// works through the range too. Ranges are split in half lazily, only when it looks like another
+	// thread could pick up the other half, and never into pieces smaller than grain. A grain of 0
+	// picks one based on the number of threads. Safe to call from inside tasks.
+	template<typename Fn>
+	void parallelFor(size_t begin, size_t end, size_t grain, const Fn& fn)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+
+		ParallelForContext<Fn> context = { this, &fn, pickGrain(begin, end, grain), { 0 } };
+		parallelForRange(&context, begin, end);
+		helpUntil([&context]() { return context.numPending.load(std::memory_order_acquire) == 0; });
+	}
+
+	// Returns combine(...combine(combine(identity, map(begin)), map(begin + 1))..., map(end - 1)). Splits
+	// the range like parallelFor(), so combine has to be associative, but the pieces are always combined
+	// left to right so it doesn't have to be commutative. identity gets combined in once per piece.
+	template<typename T, typename Map, typename Combine>
+	T parallelReduce(size_t begin, size_t end, size_t grain, const T& identity, const Map& map, const Combine& combine)
+	{
+		ParallelReduceContext<T, Map, Combine> context = { this, &identity, &map, &combine, pickGrain(begin, end, grain) };
+		return parallelReduceRange(&context, begin, end);
+	}
+
+private:
+	template<typename Fn>
+	struct ParallelForContext
+	{
+		ThreadPool* pool;
+		const Fn* fn;
+		size_t grain;
+		std::atomic<uint32_t> numPending;
+	};
+
+	template<typename T, typename Map, typename Combine>
+	struct ParallelReduceContext
+	{
+		ThreadPool* pool;
+		const T* identity;
+		const Map* map;
+		const Combine* combine;
+		size_t grain;
+	};
+
+	// Where the split off half of a parallelReduce() range leaves its result. Lives on the stack of the
+	// thread that split it, which waits for it before returning.
+	template<typename T>
+	struct ParallelReduceJoin
+	{
+		T result;
+		std::atomic<bool> done;
+	};
+
+	[[nodiscard]]
+	inline size_t pickGrain(size_t begin, size_t end, size_t grain) const
+	{
+		if (grain != 0)
+		{
+			return grain;
+		}
+
+		// Enough pieces that every thread gets a few even if the work per index is uneven
+		size_t autoGrain = (end - begin) / ((size_t)(numWorkers + 1) * 8);
+		return autoGrain > 0 ? autoGrain : 1;
+	}
+
+	// Lazy binary splitting. It's only worth making another task when nothing is queued up for thieves
+	// already, otherwise everyone is busy and splitting is pure overhead.
+	[[nodiscard]]
+	inline bool shouldSplit() const
+	{
+		if (currentPool == this)
+		{
+			return workers[currentWorker].deque.isEmpty();
+		}
+
+		return numInjected.load(std::memory_order_relaxed) == 0;
+	}
+
+	template<typename Fn>
+	static void parallelForRange(ParallelForContext<Fn>* context, size_t begin, size_t end)
+	{
+		ThreadPool* pool = context->pool;
+		size_t grain = context->grain;
+		while (begin < end)
+		{
+			if (end - begin > grain && pool->shouldSplit())
+			{
+				size_t mid = begin + (end - begin) / 2;
+				context->numPending.fetch_add(1, std::memory_order_relaxed);
+				pool->submit([context, mid, end]()
+				{
+					parallelForRange(context, mid, end);
+					context->numPending.fetch_sub(1, std::memory_order_release);
+				});
+				end = mid;
+				continue;
+			}
+
+			size_t chunkEnd = end - begin > grain ? begin + grain : end;
+			const Fn& fn = *context->fn;
+			for (size_t i = begin; i < chunkEnd; i++)
+			{
+				fn(i);
+			}
+			begin = chunkEnd;
+		}
+	}
+
+	template<typename T, typename Map, typename Combine>
+	static T parallelReduceRange(ParallelReduceContext<T, Map, Combine>* context, size_t begin, size_t end)
+	{
+		ThreadPool* pool = context->pool;
+		const Map& map = *context->map;
+		const Combine& combine = *context->combine;
+		size_t grain = context->grain;
+
+		T result = *context->identity;
+		while (begin < end)
+		{
+			if (end - begin > grain && pool->shouldSplit())
+			{
+				size_t mid = begin + (end - begin) / 2;
+				ParallelReduceJoin<T> join = { *context->identity, { false } };
+				ParallelReduceJoin<T>* joinPtr = &join;
+				pool->submit([context, joinPtr, mid, end]()
+				{
+					joinPtr->result = parallelReduceRange(context, mid, end);
+					joinPtr->done.store(true, std::memory_order_release);
+				});
+
+				T left = parallelReduceRange(context, begin, mid);
+				pool->helpUntil([&join]() { return join.done.load(std::memory_order_acquire); });
+				return combine(combine(result, left), join.result);
+			}
+
+			size_t chunkEnd = end - begin > grain ? begin + grain : end;
+			for (size_t i = begin; i < chunkEnd; i++)
+			{
+				result = combine(result, map(i));
+			}
+			begin = chunkEnd;
+		}
+
+		return result;
+	}
+
+	ThreadPoolWorker* workers;
+	uint32_t numWorkers;
+	uint32_t taskCapacity;
+
+	// Tasks submitted from threads outside the pool. Everything in here is guarded by injectMutex, only
+	// numInjected is read without it so workers can skip the lock when there's nothing queued.
+	std::mutex injectMutex;
+	ThreadPoolSlotList<ThreadPoolTask> externalTasks;
+	ThreadPoolSlotList<ThreadPoolFutureBlock> externalFutureBlocks;
+	ThreadPoolTask** injected;
+	uint32_t injectedHead;
+	std::atomic<uint32_t> numInjected;
+
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<uint32_t> numPending;
+	alignas(GABE_CPP_UTILS_CACHE_LINE_SIZE) std::atomic<uint32_t> numSleeping;
+	std::atomic<bool> stopping;
+	// Bumped under parkMutex every time someone wakes the workers, parked workers wait for it to change
+	uint64_t wakeEpoch;
+	std::mutex parkMutex;
+	std::condition_variable parkCv;
+
+	static inline thread_local ThreadPool* currentPool = nullptr;
+	static inline thread_local uint32_t currentWorker = 0;
+	static inline thread_local uint32_t externalRng = 0;
+
+	// How many times an idle worker looks for work before it parks
+	static constexpr uint32_t spinCount = 64;
+
+	void workerMain(uint32_t index)
+	{
+		currentPool = this;
+		currentWorker = index;
+
+		while (true)
+		{
+			ThreadPoolTask* task = findTask(index);
+			if (task != nullptr)
+			{
+				execute(task);
+				continue;
+			}
+
+			// free() waits for every task before it sets this, so there's nothing left to miss
+			if (stopping.load(std::memory_order_acquire))
+			{
+				break;
+			}
+
+			park();
+		}
+
+		currentPool = nullptr;
+	}
+
+	void park()
+	{
+		for (uint32_t i = 0; i < spinCount; i++)
+		{
+			if (hasWork() || stopping.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+			std::this_thread::yield();
+		}
+
+		std::unique_lock<std::mutex> lock(parkMutex);
+		uint64_t epoch = wakeEpoch;
+		numSleeping.fetch_add(1, std::memory_order_seq_cst);
+		// Pairs with the fence in wakeOne(). Either we see the task that was just pushed, or the thread
+		// that pushed it sees us sleeping and bumps the epoch.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!hasWork() && !stopping.load(std::memory_order_relaxed))
+		{
+			parkCv.wait(lock, [this, epoch]() { return wakeEpoch != epoch; });
+		}
+		numSleeping.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void wakeOne()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (numSleeping.load(std::memory_order_relaxed) == 0)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(parkMutex);
+			wakeEpoch++;
+		}
+		parkCv.notify_one();
+	}
+
+	[[nodiscard]]
+	bool hasWork() const
+	{
+		if (numInjected.load(std::memory_order_acquire) > 0)
+		{
+			return true;
+		}
+
+		for (uint32_t i = 0; i < numWorkers; i++)
+		{
+			if (!workers[i].deque.isEmpty())
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	ThreadPoolTask* findTask(uint32_t workerIndex)
+	{
+		ThreadPoolTask* task = workers[workerIndex].deque.pop();
+		if (task != nullptr)
+		{
+			return task;
+		}
+
+		return stealTask(workerIndex, workers[workerIndex].rng);
+	}
+
+	// Checks the external queue first, then walks the workers starting from a random one
+	ThreadPoolTask* stealTask(uint32_t thiefIndex, uint32_t& rng)
+	{
+		if (numInjected.load(std::memory_order_acquire) > 0)
+		{
+			std::lock_guard<std::mutex> lock(injectMutex);
+			uint32_t count = numInjected.load(std::memory_order_relaxed);
+			if (count > 0)
+			{
+				ThreadPoolTask* task = injected[injectedHead];
+				injectedHead = (injectedHead + 1) & (taskCapacity - 1);
+				numInjected.store(count - 1, std::memory_order_release);
+				return task;
+			}
+		}
+
+		if (rng == 0)
+		{
+			rng = (uint32_t)(uintptr_t)&rng | 1;
+		}
+		// xorshift32
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+
+		uint32_t start = rng % numWorkers;
+		for (uint32_t i = 0; i < numWorkers; i++)
+		{
+			uint32_t victim = start + i < numWorkers ? start + i : start + i - numWorkers;
+			if (victim == thiefIndex)
+			{
+				continue;
+			}
+
+			ThreadPoolTask* task = workers[victim].deque.steal();
+			if (task != nullptr)
+			{
+				return task;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void execute(ThreadPoolTask* task)
+	{
+		task->run(task->storage);
+		releaseSlot(task, &ThreadPoolWorker::tasks, externalTasks);
+		numPending.fetch_sub(1, std::memory_order_release);
+	}
+
+	template<typename Slot>
+	Slot* allocateSlot(ThreadPoolSlotList<Slot> ThreadPoolWorker::* workerList, ThreadPoolSlotList<Slot>& externalList)
+	{
+		if (currentPool != this)
+		{
+			std::lock_guard<std::mutex> lock(injectMutex);
+			return popFree(externalList);
+		}
+
+		ThreadPoolSlotList<Slot>& list = workers[currentWorker].*workerList;
+		if (list.localFree == 0)
+		{
+			list.localFree = list.remoteFree.exchange(0, std::memory_order_acquire);
+		}
+		return popFree(list);
+	}
+
+	void pushTask(ThreadPoolTask* task)
+	{
+		if (currentPool == this)
+		{
+			workers[currentWorker].deque.push(task);
+		}
+		else
+		{
+			// Can't overflow, there are exactly as many external task slots as there's room in here
+			std::lock_guard<std::mutex> lock(injectMutex);
+			uint32_t count = numInjected.load(std::memory_order_relaxed);
+			injected[(injectedHead + count) & (taskCapacity - 1)] = task;
+			numInjected.store(count + 1, std::memory_order_release);
+		}
+
+		wakeOne();
+	}
+
+	template<typename Slot>
+	void releaseSlot(Slot* slot, ThreadPoolSlotList<Slot> ThreadPoolWorker::* workerList, ThreadPoolSlotList<Slot>& externalList)
+	{
+		if (slot->owner == numWorkers)
+		{
+			std::lock_guard<std::mutex> lock(injectMutex);
+			pushFree(externalList, slot);
+			return;
+		}
+
+		ThreadPoolSlotList<Slot>& list = workers[slot->owner].*workerList;
+		if (currentPool == this && currentWorker == slot->owner)
+		{
+			pushFree(list, slot);
+			return;
+		}
+
+		uint32_t index = (uint32_t)(slot - list.slots);
+		uint32_t head = list.remoteFree.load(std::memory_order_relaxed);
+		do
+		{
+			slot->nextFree.store(head, std::memory_order_relaxed);
+		} while (!list.remoteFree.compare_exchange_weak(head, index + 1, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	template<typename Slot>
+	void initSlotList(ThreadPoolSlotList<Slot>& list, uint32_t owner)
+	{
+		list.slots = (Slot*)g_memory_allocateAligned(sizeof(Slot) * taskCapacity, GABE_CPP_UTILS_CACHE_LINE_SIZE);
+		for (uint32_t i = 0; i < taskCapacity; i++)
+		{
+			Slot* slot = new(list.slots + i)Slot();
+			slot->owner = owner;
+			slot->nextFree.store(i + 1 < taskCapacity ? i + 2 : 0, std::memory_order_relaxed);
+		}
+		list.localFree = 1;
+		list.remoteFree.store(0, std::memory_order_relaxed);
+	}
+
+	template<typename Slot>
+	static inline Slot* popFree(ThreadPoolSlotList<Slot>& list)
+	{
+		if (list.localFree == 0)
+		{
+			return nullptr;
+		}
+
+		Slot* slot = list.slots + (list.localFree - 1);
+		list.localFree = slot->nextFree.load(std::memory_order_relaxed);
+		return slot;
+	}
+
+	template<typename Slot>
+	static inline void pushFree(ThreadPoolSlotList<Slot>& list, Slot* slot)
+	{
+		slot->nextFree.store(list.localFree, std::memory_order_relaxed);
+		list.localFree = (uint32_t)(slot - list.slots) + 1;
+	}
+};
+
+struct TaskGraphNode
+{
+	void (*invoke)(void* storage);
+	// Move constructs dst from src and destroys src, used when the node array grows
+	void (*relocate)(void* dst, void* src);
+	void (*destroy)(void* storage);
+	// Successors of this node are successors[firstSuccessor .. firstSuccessor + numSuccessors)
+	uint32_t firstSuccessor;
+	uint32_t numSuccessors;
+	uint32_t numDependencies;
+	// Dependencies left before this node can run, reset from numDependencies at the start of every run
+	std::atomic<uint32_t> remaining;
+	alignas(16) unsigned char storage[GABE_THREAD_POOL_TASK_SIZE];
+};
+
+// A DAG of tasks that runs on a ThreadPool. Add nodes and edges once, then call run() as often as you
+// like. Every node has an atomic count of the dependencies it's still waiting on, and whichever thread
+// finishes the last one of them runs it next, so there's no central lock or scheduler. Runs after the
+// first one don't allocate unless nodes or edges were added in between.
+//
+// Zero initialize this (`TaskGraph graph = {};`) and call free() when you're done with it
+struct TaskGraph
+{
+	TaskGraphNode* nodes;
+	uint32_t numNodes;
+	uint32_t nodesCapacity;
+
+	// Pairs of (before, after) as they were added. They get turned into per node successor lists the
+	// next time the graph runs.
+	uint32_t* edges;
+	uint32_t numEdges;
+	uint32_t edgesCapacity;
+
+	uint32_t* successors;
+	uint32_t* roots;
+	uint32_t numRoots;
+	bool isDirty;
+	bool hasCycle;
+
+	ThreadPool* pool;
+	std::atomic<uint32_t> numUnfinished;
+
+	// Returns the id of the new node. The callable has to fit in GABE_THREAD_POOL_TASK_SIZE bytes, just
+	// like with ThreadPool::submit().
+	template<typename F>
+	uint32_t addNode(F&& fn)
+	{
+		using Fn = std::decay_t<F>;
+		static_assert(sizeof(Fn) <= GABE_THREAD_POOL_TASK_SIZE,
+			"This callable is too big to store inline in a task graph node. Capture a pointer to your data instead, or define a bigger GABE_THREAD_POOL_TASK_SIZE.");
+		static_assert(alignof(Fn) <= 16, "Task graph nodes can't hold callables that need more than 16 byte alignment.");
+
+		if (numNodes >= nodesCapacity)
+		{
+			growNodes(nodesCapacity == 0 ? 16 : nodesCapacity * 2);
+		}
+
+		TaskGraphNode* node = new(nodes + numNodes)TaskGraphNode();
+		new(node->storage)Fn(std::forward<F>(fn));
+		node->invoke = [](void* storage) { (*(Fn*)storage)(); };
+		node->relocate = [](void* dst, void* src)
+		{
+			new(dst)Fn(std::move(*(Fn*)src));
+			((Fn*)src)->~Fn();
+		};
+		node->destroy = [](void* storage) { ((Fn*)storage)->~Fn(); };
+
+		isDirty = true;
+		return numNodes++;
+	}
+
+	// `after` won't start until `before` has finished
+	void addEdge(uint32_t before, uint32_t after)
+	{
+		g_logger_assert(before < numNodes && after < numNodes, "Task graph edges have to be between nodes that exist.");
+
+		if (numEdges >= edgesCapacity)
+		{
+			edgesCapacity = edgesCapacity == 0 ? 32 : edgesCapacity * 2;
+			edges = (uint32_t*)g_memory_realloc(edges, sizeof(uint32_t) * 2 * edgesCapacity);
+		}
+
+		edges[numEdges * 2] = before;
+		edges[numEdges * 2 + 1] = after;
+		numEdges++;
+		isDirty = true;
+	}
+
+	// Runs every node once, respecting the edges, and returns when they've all finished. The calling
+	// thread helps run nodes, and it's fine to call this from inside one of the pool's tasks. Returns
+	// false without running anything if the edges have a cycle.
+	bool run(ThreadPool& threadPool)
+	{
+		if (isDirty)
+		{
+			build();
+		}
+
+		if (hasCycle)
+		{
+			return false;
+		}
+
+		if (numNodes == 0)
+		{
+			return true;
+		}
+
+		pool = &threadPool;
+		for (uint32_t i = 0; i < numNodes; i++)
+		{
+			nodes[i].remaining.store(nodes[i].numDependencies, std::memory_order_relaxed);
+		}
+		numUnfinished.store(numNodes, std::memory_order_relaxed);
+
+		for (uint32_t i = 0; i < numRoots; i++)
+		{
+			submitNode(roots[i]);
+		}
+
+		pool->helpUntil([this]() { return numUnfinished.load(std::memory_order_acquire) == 0; });
+		return true;
+	}
+
+	void free()
+	{
+		for (uint32_t i = 0; i < numNodes; i++)
+		{
+			nodes[i].destroy(nodes[i].storage);
+			nodes[i].~TaskGraphNode();
+		}
+
+		g_memory_freeAligned(nodes);
+		g_memory_free(edges);
+		g_memory_free(successors);
+		g_memory_free(roots);
+
+		nodes = nullptr;
+		edges = nullptr;
+		successors = nullptr;
+		roots = nullptr;
+		numNodes = 0;
+		nodesCapacity = 0;
+		numEdges = 0;
+		edgesCapacity = 0;
+		numRoots = 0;
+		isDirty = false;
+		hasCycle = false;
+		pool = nullptr;
+	}
+
+private:
+	void submitNode(uint32_t nodeIndex)
+	{
+		TaskGraph* graph = this;
+		pool->submit([graph, nodeIndex]() { graph->runNode(nodeIndex); });
+	}
+
+	void runNode(uint32_t nodeIndex)
+	{
+		while (true)
+		{
+			TaskGraphNode& node = nodes[nodeIndex];
+			node.invoke(node.storage);
+
+			// The first successor that becomes ready runs right here instead of going through the pool,
+			// so chains of nodes stay on one thread with a warm cache
+			uint32_t next = UINT32_MAX;
+			for (uint32_t i = 0; i < node.numSuccessors; i++)
+			{
+				uint32_t successor = successors[node.firstSuccessor + i];
+				if (nodes[successor].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					if (next == UINT32_MAX)
+					{
+						next = successor;
+					}
+					else
+					{
+						submitNode(successor);
+					}
+				}
+			}
+
+			numUnfinished.fetch_sub(1, std::memory_order_release);
+			if (next == UINT32_MAX)
+			{
+				return;
+			}
+			nodeIndex = next;
+		}
+	}
+
+	// Turns the edge list into successor lists and finds the roots. Also checks for cycles with Kahn's
+	// algorithm, using `remaining` as scratch space.
+	void build()
+	{
+		isDirty = false;
+		hasCycle = false;
+
+		for (uint32_t i = 0; i < numNodes; i++)
+		{
+			nodes[i].numSuccessors = 0;
+			nodes[i].numDependencies = 0;
+		}
+		for (uint32_t i = 0; i < numEdges; i++)
+		{
+			nodes[edges[i * 2]].numSuccessors++;
+			nodes[edges[i * 2 + 1]].numDependencies++;
+		}
+
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < numNodes; i++)
+		{
+			nodes[i].firstSuccessor = offset;
+			offset += nodes[i].numSuccessors;
+			// Used as a fill cursor below, ends up back where it was
+			nodes[i].numSuccessors = 0;
+		}
+
+		successors = (uint32_t*)g_memory_realloc(successors, sizeof(uint32_t) * (numEdges > 0 ? numEdges : 1));
+		for (uint32_t i = 0; i < numEdges; i++)
+		{
+			TaskGraphNode& before = nodes[edges[i * 2]];
+			successors[before.firstSuccessor + before.numSuccessors++] = edges[i * 2 + 1];
+		}
+
+		roots = (uint32_t*)g_memory_realloc(roots, sizeof(uint32_t) * (numNodes > 0 ? numNodes : 1));
+		numRoots = 0;
+		for (uint32_t i = 0; i < numNodes; i++)
+		{
+			nodes[i].remaining.store(nodes[i].numDependencies, std::memory_order_relaxed);
+			if (nodes[i].numDependencies == 0)
+			{
+				roots[numRoots++] = i;
+			}
+		}
+
+		uint32_t* queue = (uint32_t*)g_memory_allocate(sizeof(uint32_t) * (numNodes > 0 ? numNodes : 1));
+		for (uint32_t i = 0; i < numRoots; i++)
+		{
+			queue[i] = roots[i];
+		}
+
+		uint32_t queueEnd = numRoots;
+		for (uint32_t queueStart = 0; queueStart < queueEnd; queueStart++)
+		{
+			const TaskGraphNode& node = nodes[queue[queueStart]];
+			for (uint32_t i = 0; i < node.numSuccessors; i++)
+			{
+				uint32_t successor = successors[node.firstSuccessor + i];
+				if (nodes[successor].remaining.fetch_sub(1, std::memory_order_relaxed) == 1)
+				{
+					queue[queueEnd++] = successor;
+				}
+			}
+		}
+		g_memory_free(queue);
+
+		if (queueEnd != numNodes)
+		{
+			hasCycle = true;
+			g_logger_error("Task graph has a cycle in it, so it can't run.");
+		}
+	}
+
+	void growNodes(uint32_t newCapacity)
+	{
+		// Can't realloc here since the callables may not be trivially relocatable
+		TaskGraphNode* newNodes = (TaskGraphNode*)g_memory_allocateAligned(sizeof(TaskGraphNode) * newCapacity, GABE_CPP_UTILS_CACHE_LINE_SIZE);
+		for (uint32_t i = 0; i < numNodes; i++)
+		{
+			TaskGraphNode* node = new(newNodes + i)TaskGraphNode();
+			node->invoke = nodes[i].invoke;
+			node->relocate = nodes[i].relocate;
+			node->destroy = nodes[i].destroy;
+			node->relocate(node->storage, nodes[i].storage);
+			nodes[i].~TaskGraphNode();
+		}
+		g_memory_freeAligned(nodes);
+
+		nodes = newNodes;
+		nodesCapacity = newCapacity;
+	}
+};
+
+// Something to run once a future resolves. These live in future blocks, and run() gives the block back.
+struct FutureContinuation
+{
+	FutureContinuation* next;
+	void (*run)(FutureContinuation* self, FutureStateBase* source);
+};
+
+struct FutureStateBase
+{
+	ThreadPool* pool;
+	std::atomic<uint32_t> refCount;
+	// Continuations waiting on this future. Swapped out for resolvedMarker() when the future resolves,
+	// so adding a continuation and resolving only ever race on this one pointer.
+	std::atomic<FutureContinuation*> continuations;
+	void (*destroyResult)(FutureStateBase* state);
+
+	static inline FutureContinuation* resolvedMarker() { return (FutureContinuation*)(uintptr_t)1; }
+
+	[[nodiscard]]
+	inline bool isResolved() const { return continuations.load(std::memory_order_acquire) == resolvedMarker(); }
+
+	inline void addRef() { refCount.fetch_add(1, std::memory_order_relaxed); }
+
+	void release()
+	{
+		if (refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		{
+			return;
+		}
+
+		if (isResolved())
+		{
+			destroyResult(this);
+		}
+		ThreadPool* owningPool = pool;
+		this->~FutureStateBase();
+		owningPool->releaseFutureBlock(this);
+	}
+
+	// Runs the continuation right away if this future already resolved
+	void addContinuation(FutureContinuation* continuation)
+	{
+		FutureContinuation* head = continuations.load(std::memory_order_acquire);
+		do
+		{
+			if (head == resolvedMarker())
+			{
+				continuation->run(continuation, this);
+				return;
+			}
+			continuation->next = head;
+		} while (!continuations.compare_exchange_weak(head, continuation, std::memory_order_acq_rel, std::memory_order_acquire));
+	}
+
+	// Call once the result has been constructed
+	void publish()
+	{
+		FutureContinuation* continuation = continuations.exchange(resolvedMarker(), std::memory_order_acq_rel);
+		while (continuation != nullptr)
+		{
+			FutureContinuation* next = continuation->next;
+			continuation->run(continuation, this);
+			continuation = next;
+		}
+	}
+};
+
+template<typename T, typename E>
+struct FutureState : FutureStateBase
+{
+	alignas(Maybe<T, E>) unsigned char resultStorage[sizeof(Maybe<T, E>)];
+
+	static FutureState<T, E>* create(ThreadPool* pool, uint32_t numRefs)
+	{
+		static_assert(sizeof(FutureState<T, E>) <= GABE_THREAD_POOL_FUTURE_SIZE,
+			"This Maybe<T, E> is too big to store inline in a future. Return a pointer or handle instead, or define a bigger GABE_THREAD_POOL_FUTURE_SIZE.");
+		static_assert(alignof(FutureState<T, E>) <= 16, "Futures can't hold values that need more than 16 byte alignment.");
+
+		FutureState<T, E>* state = new(pool->allocateFutureBlock())FutureState<T, E>();
+		state->pool = pool;
+		state->refCount.store(numRefs, std::memory_order_relaxed);
+		state->continuations.store(nullptr, std::memory_order_relaxed);
+		state->destroyResult = [](FutureStateBase* base) { ((FutureState<T, E>*)base)->result().~Maybe(); };
+		return state;
+	}
+
+	[[nodiscard]]
+	inline Maybe<T, E>& result() { return *(Maybe<T, E>*)resultStorage; }
+
+	void resolve(Maybe<T, E>&& value)
+	{
+		new(resultStorage)Maybe<T, E>(std::move(value));
+		publish();
+	}
+};
+
+// A Maybe<T, E> that some task on a ThreadPool is still working on. Get one from ThreadPool::async(),
+// then(), whenAll() or whenAny(). Copies share the same result. Resolving, waiting and chaining never
+// take a lock, and the shared state comes out of the pool's block lists instead of the heap.
+template<typename T, typename E>
+struct Future
+{
+	FutureState<T, E>* state;
+
+	Future() : state(nullptr) {}
+	// Takes over a reference the caller already holds
+	explicit Future(FutureState<T, E>* sharedState) : state(sharedState) {}
+	Future(const Future& other) : state(other.state) { if (state != nullptr) state->addRef(); }
+	Future(Future&& other) noexcept : state(other.state) { other.state = nullptr; }
+	~Future() { if (state != nullptr) state->release(); }
+
+	Future& operator=(Future other) noexcept
+	{
+		std::swap(state, other.state);
+		return *this;
+	}
+
+	[[nodiscard]]
+	inline bool isValid() const { return state != nullptr; }
+
+	[[nodiscard]]
+	inline bool isReady() const { return state->isResolved(); }
+
+	// Runs the pool's tasks on the calling thread until this resolves. Fine to call from inside a task.
+	[[nodiscard]]
+	const Maybe<T, E>& get() const
+	{
+		if (!state->isResolved())
+		{
+			FutureState<T, E>* waitingOn = state;
+			state->pool->helpUntil([waitingOn]() { return waitingOn->isResolved(); });
+		}
+
+		return state->result();
+	}
+
+	// Once this resolves, runs fn(value) on the pool and resolves the returned future with the
+	// Maybe<U, E> fn returns. Errors skip fn and pass straight through to the returned future.
+	template<typename F>
+	auto then(F&& fn) const
+	{
+		using Fn = std::decay_t<F>;
+		using Result = std::invoke_result_t<Fn&, const T&>;
+		static_assert(FutureMaybeTraits<Result>::isMaybe, "Future::then() callbacks have to return a Maybe.");
+		static_assert(std::is_same_v<typename FutureMaybeTraits<Result>::Error, E>,
+			"Future::then() callbacks have to return a Maybe with the same error type, so errors can pass through.");
+		using U = typename FutureMaybeTraits<Result>::Value;
+
+		struct ThenContinuation : FutureContinuation
+		{
+			FutureState<U, E>* target;
+			Fn callable;
+
+			ThenContinuation(FutureState<U, E>* targetState, F&& fn) : FutureContinuation(), target(targetState), callable(std::forward<F>(fn)) {}
+		};
+		static_assert(sizeof(ThenContinuation) <= GABE_THREAD_POOL_FUTURE_SIZE,
+			"This callable is too big to store inline in a continuation. Capture a pointer to your data instead, or define a bigger GABE_THREAD_POOL_FUTURE_SIZE.");
+		static_assert(alignof(ThenContinuation) <= 16, "Continuations can't hold callables that need more than 16 byte alignment.");
+
+		ThreadPool* pool = state->pool;
+		// One reference for the Future we hand back and one for the continuation
+		FutureState<U, E>* target = FutureState<U, E>::create(pool, 2);
+		ThenContinuation* continuation = new(pool->allocateFutureBlock())ThenContinuation(target, std::forward<F>(fn));
+		continuation->run = [](FutureContinuation* self, FutureStateBase* source)
+		{
+			// Whoever resolved the source might let go of it before the task runs
+			source->addRef();
+			source->pool->submit([self, source]()
+			{
+				ThenContinuation* thenContinuation = (ThenContinuation*)self;
+				ThreadPool* sourcePool = source->pool;
+				Maybe<T, E>& sourceResult = ((FutureState<T, E>*)source)->result();
+				if (sourceResult.hasValue())
+				{
+					thenContinuation->target->resolve(thenContinuation->callable(sourceResult.value()));
+				}
+				else
+				{
+					thenContinuation->target->resolve(Maybe<U, E>(sourceResult.error()));
+				}
+
+				thenContinuation->target->release();
+				source->release();
+				thenContinuation->~ThenContinuation();
+				sourcePool->releaseFutureBlock(thenContinuation);
+			});
+		};
+		state->addContinuation(continuation);
+
+		return Future<U, E>(target);
+	}
+};
+
+// Resolves once every future in the array has resolved. The value is numFutures if they all have
+// values, otherwise it's the first error that came in.
+template<typename T, typename E>
+Future<uint32_t, E> whenAll(const Future<T, E>* futures, uint32_t numFutures)
+{
+	g_logger_assert(numFutures > 0, "whenAll() needs at least one future.");
+
+	struct Join
+	{
+		FutureState<uint32_t, E>* target;
+		uint32_t numFutures;
+		std::atomic<uint32_t> remaining;
+		std::atomic<bool> failed;
+		E error;
+	};
+
+	struct JoinContinuation : FutureContinuation
+	{
+		Join* join;
+	};
+
+	ThreadPool* pool = futures[0].state->pool;
+	FutureState<uint32_t, E>* target = FutureState<uint32_t, E>::create(pool, 2);
+	Join* join = new(pool->allocateFutureBlock())Join();
+	join->target = target;
+	join->numFutures = numFutures;
+	join->remaining.store(numFutures, std::memory_order_relaxed);
+	join->failed.store(false, std::memory_order_relaxed);
+
+	for (uint32_t i = 0; i < numFutures; i++)
+	{
+		JoinContinuation* continuation = new(pool->allocateFutureBlock())JoinContinuation();
+		continuation->join = join;
+		continuation->run = [](FutureContinuation* self, FutureStateBase* source)
+		{
+			Join* sharedJoin = ((JoinContinuation*)self)->join;
+			ThreadPool* sourcePool = source->pool;
+			sourcePool->releaseFutureBlock(self);
+
+			Maybe<T, E>& result = ((FutureState<T, E>*)source)->result();
+			if (!result.hasValue() && !sharedJoin->failed.exchange(true, std::memory_order_relaxed))
+			{
+				sharedJoin->error = result.error();
+			}
+
+			if (sharedJoin->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			{
+				return;
+			}
+
+			FutureState<uint32_t, E>* joinTarget = sharedJoin->target;
+			if (sharedJoin->failed.load(std::memory_order_relaxed))
+			{
+				joinTarget->resolve(Maybe<uint32_t, E>(sharedJoin->error));
+			}
+			else
+			{
+				joinTarget->resolve(Maybe<uint32_t, E>(sharedJoin->numFutures));
+			}
+			sharedJoin->~Join();
+			sourcePool->releaseFutureBlock(sharedJoin);
+			joinTarget->release();
+		};
+		futures[i].state->addContinuation(continuation);
+	}
+
+	return Future<uint32_t, E>(target);
+}
+
+// Resolves as soon as any future in the array resolves, with that future's index as the value. Check
+// futures[index].get() for its result.
+template<typename T, typename E>
+Future<uint32_t, E> whenAny(const Future<T, E>* futures, uint32_t numFutures)
+{
+	g_logger_assert(numFutures > 0, "whenAny() needs at least one future.");
+
+	struct Join
+	{
+		FutureState<uint32_t, E>* target;
+		std::atomic<uint32_t> remaining;
+		std::atomic<bool> resolved;
+	};
+
+	struct AnyContinuation : FutureContinuation
+	{
+		Join* join;
+		uint32_t index;
+	};
+
+	ThreadPool* pool = futures[0].state->pool;
+	FutureState<uint32_t, E>* target = FutureState<uint32_t, E>::create(pool, 2);
+	Join* join = new(pool->allocateFutureBlock())Join();
+	join->target = target;
+	join->remaining.store(numFutures, std::memory_order_relaxed);
+	join->resolved.store(false, std::memory_order_relaxed);
+
+	for (uint32_t i = 0; i < numFutures; i++)
+	{
+		AnyContinuation* continuation = new(pool->allocateFutureBlock())AnyContinuation();
+		continuation->join = join;
+		continuation->index = i;
+		continuation->run = [](FutureContinuation* self, FutureStateBase* source)
+		{
+			Join* sharedJoin = ((AnyContinuation*)self)->join;
+			uint32_t index = ((AnyContinuation*)self)->index;
+			ThreadPool* sourcePool = source->pool;
+			sourcePool->releaseFutureBlock(self);
+
+			if (!sharedJoin->resolved.exchange(true, std::memory_order_acq_rel))
+			{
+				sharedJoin->target->resolve(Maybe<uint32_t, E>(index));
+				sharedJoin->target->release();
+			}
+
+			// The rest of the futures still point at the join, so the last one frees it
+			if (sharedJoin->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				sharedJoin->~Join();
+				sourcePool->releaseFutureBlock(sharedJoin);
+			}
+		};
+		futures[i].state->addContinuation(continuation);
+	}
+
+	return Future<uint32_t, E>(target);
+}
+
+} // End CppUtils
+
+GABE_CPP_UTILS_ALLOW_PADDING_END
+
+#endif // End GABE_CPP_THREAD_POOL_H
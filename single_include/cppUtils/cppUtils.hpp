@@ -42,7 +42,7 @@
 	// Run my app
 
 	g_memory_dumpMemoryLeaks(); // Get any memory leaks
-	g_memory_deinit(); // Release resources like mutexes
+	g_memory_deinit(); // Release resources like the padding buffer
  }
 
  -------- FUNCTIONS --------
@@ -79,6 +79,25 @@ g_memory_init_padding_zeroed(bool detectMemoryLeaks, uint16 bufferPadding, bool
  NOTE: Only call this on memory that was allocated using the above function
 	g_memory_realloc(void* memory, size_t newSize)
 
+ NOTE: For blocks that have to start on an alignment boundary (a power of two). Buffer padding is
+	   applied to the block underneath, so the returned pointer keeps its alignment either way.
+	g_memory_allocateAligned(size_t numBytes, size_t alignment)
+	g_memory_freeAligned(void* memory)
+
+ Crash reports:
+	g_memory_installCrashHandler(int fileDescriptor)
+	  - Opt-in. Installs a handler for SIGSEGV, SIGABRT, SIGBUS, SIGFPE and SIGILL that writes every
+		live allocation and the most recent heap corruption findings to fileDescriptor, then re-raises
+		the signal. Open the file yourself *before* calling this, the handler never opens files.
+	  - Calling it again only switches the report over to the new fileDescriptor.
+	  - The handler only uses async-signal-safe calls (write, sigaction, raise). It takes no locks and
+		allocates nothing, so it reads the allocation table as-is. If the crash happened in the middle
+		of an allocation the last entry may be stale, but everything else will be intact.
+	g_memory_uninstallCrashHandler()
+	  - Restores whatever signal handlers were installed before.
+	g_memory_writeCrashReport(int fileDescriptor)
+	  - Writes the same report on demand. Also async-signal-safe, so you can call it from your own handlers.
+
  Miscellaneous memory functions:
 	g_memory_compareMem(void* a, size_t aNumBytes, void* b, size_t bNumBytes)
 	g_memory_zeroMem(void* memory, size_t numBytes);
@@ -127,13 +146,54 @@ g_memory_init_padding_zeroed(bool detectMemoryLeaks, uint16 bufferPadding, bool
 	g_logger_free();
 
 	g_logger_setLogDirectory(const char* file)
+	g_logger_set_log_rotation(uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles)
+	g_logger_set_mapped_log_file(const char* filepath, uint64 segmentBytes, uint32 syncIntervalMs)
 	g_logger_set_level(g_logger_level level)
+	g_logger_set_channel_level(const char* channelName, g_logger_level level)
+	g_logger_get_channel_level(const char* channelName)
+	g_logger_configure_channels(const char* config)
+
+	g_logger_add_console_sink(g_logger_level level, uint32 format)
+	g_logger_add_file_sink(const char* filepath, g_logger_level level, uint32 format)
+	g_logger_add_rotating_file_sink(const char* filepath, g_logger_level level, uint32 format, uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles)
+	g_logger_add_memory_sink(size_t capacityBytes, g_logger_level level, uint32 format)
+	g_logger_add_callback_sink(g_logger_sink_callback callback, void* userData, g_logger_level level, uint32 format)
+	g_logger_read_memory_sink(g_logger_sink sink, char* buffer, size_t bufferSize)
+	g_logger_remove_sink(g_logger_sink sink)
+	g_logger_set_sink_level(g_logger_sink sink, g_logger_level level)
+	g_logger_set_sink_format(g_logger_sink sink, uint32 format)
+	g_logger_set_rate_limit(g_logger_level level, uint32 maxPerSecond)
+	g_logger_set_repeat_suppression(g_logger_level level, uint32 windowSeconds)
+	g_logger_set_timestamp_microseconds(bool enabled)
+	g_logger_set_clock(g_logger_clock clock)
+
+	g_logger_enable_async(uint32 numRecords, g_logger_overflow_policy policy)
+	g_logger_disable_async()
+	g_logger_flush()
+	g_logger_get_dropped_count()
+	g_logger_set_io_uring_writer(bool enabled, g_logger_fsync_policy fsyncPolicy, uint32 fsyncIntervalMs)
+	g_logger_set_deferred_formatting(bool enabled)
+	g_logger_set_binary_log_file(const char* filepath)
 
 	g_logger_log(const char* format, ...args)
 	g_logger_info(const char* format, ...args)
 	g_logger_warning(const char* format, ...args)
 	g_logger_error(const char* format, ...args)
 	g_logger_assert(bool condition, const char* failureFormat, ...args)
+	g_logger_check(bool condition, const char* failureFormat, ...args)
+	g_logger_verify(bool condition, const char* failureFormat, ...args)
+	g_logger_set_check_action(g_logger_check_action action, g_logger_check_callback callback, void* userData)
+	g_logger_get_check_failure_count()
+	g_logger_debug(const char* format, ...args)
+	g_logger_channel_info(const char* channelName, const char* format, ...args)
+	(and g_logger_channel_log, g_logger_channel_warning, g_logger_channel_error)
+
+	g_logger_enable_flight_recorder(uint32 numRecordsPerThread, int fileDescriptor)
+	g_logger_write_flight_recorder(int fileDescriptor)
+
+	g_logger_set_json_log_file(const char* filepath)
+	g_logger_info_kv(const g_logger_kv* fields, uint32 numFields, const char* format, ...args)
+	(and g_logger_log_kv, g_logger_warning_kv, g_logger_error_kv)
 
 	All these overridden in C++:
 	new
@@ -156,15 +216,307 @@ g_memory_init_padding_zeroed(bool detectMemoryLeaks, uint16 bufferPadding, bool
 
 	g_logger_assert(bool condition, const char* failureMessage, ...format)
 
+ Assertions always end the program. For invariants you want to keep checking in production there's:
+
+	g_logger_check(condition, const char* failureMessage, ...format)
+	g_logger_verify(condition, const char* failureMessage, ...format)
+
+ The condition is marked unlikely and everything past it lives in a cold, out of line function, so a
+ passing check costs one predicted branch. A failure is logged at g_logger_level_Error as
+ "Check 'condition' failed: message", but only the first time for each check, after that it just gets
+ counted (g_logger_get_check_failure_count). What happens after that is up to you:
+
+	g_logger_set_check_action(g_logger_check_action action, g_logger_check_callback callback, void* userData)
+
+	g_logger_check_Continue -- Keep going (the default).
+	g_logger_check_Abort    -- Flush, dump the flight recorder and abort() on every failure.
+	g_logger_check_Callback -- Call callback once per check, right after it's logged, then keep going.
+
+ Defining GABE_LOGGER_DISABLE_CHECKS compiles every g_logger_check out, condition and all. g_logger_verify
+ keeps evaluating its condition, so only use it when the condition has side effects you need.
+
  Set up logging to a file as well the standard output.
 
 	g_logger_setLogDirectory(const char* file)
 
+ Under the hood every record goes to a list of sinks, and each sink has its own level and format. The
+ console is sink 0 (g_logger_console_sink), and g_logger_set_log_directory just adds a file sink.
+ On Linux the console sink writes straight to the stdout file descriptor. g_logger_init flushes stdout
+ once, after that fflush(stdout) yourself if your own printf output has to stay in order with the log.
+ To add your own:
+
+	g_logger_add_console_sink(g_logger_level level, uint32 format)
+	g_logger_add_file_sink(const char* filepath, g_logger_level level, uint32 format)
+	g_logger_add_rotating_file_sink(const char* filepath, g_logger_level level, uint32 format, uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles)
+	g_logger_add_memory_sink(size_t capacityBytes, g_logger_level level, uint32 format)
+	g_logger_add_callback_sink(g_logger_sink_callback callback, void* userData, g_logger_level level, uint32 format)
+
+ A sink only gets records at its level or higher. The format is any combination of
+ g_logger_format_Location, g_logger_format_Timestamp and g_logger_format_Color, the message always gets
+ written. Every record is formatted once no matter how many sinks there are, the sinks just pick the
+ parts they want out of it. For example, everything to disk but only warnings and up on the console:
+
+	g_logger_add_file_sink("app.log", g_logger_level_All, g_logger_format_Location | g_logger_format_Timestamp);
+	g_logger_set_sink_level(g_logger_console_sink, g_logger_level_Warning);
+
+ A memory sink keeps the last capacityBytes of output in a ring buffer, g_logger_read_memory_sink copies
+ out the newest bytes that fit (oldest first) and can be called from any thread. A callback sink hands
+ you each record as a g_logger_sink_record. Callbacks run while the logger holds its lock (in async
+ mode too, where the writer thread calls them), so don't log from one. g_logger_set_sink_level and
+ g_logger_set_sink_format can be called whenever, but only add and remove sinks while nothing else is
+ logging. At most GABE_LOGGER_MAX_SINKS (8) sinks can exist at once.
+ g_logger_set_level still filters everything before it gets to any sink. With cppPrint style logging the
+ message is formatted once on the calling thread too and every sink gets it. Deferred records (see
+ g_logger_set_deferred_formatting) are the exception, the writer thread formats those with basic
+ formatting: a precision and f/e/g for floats, x/X/o for integers, and the defaults for everything else.
+
+ For log pipelines there's also a structured sink that writes every record as one JSON object per
+ line, next to the regular output:
+
+	g_logger_set_json_log_file(const char* filepath)
+
+	{"ts":1792370476.123456,"level":"info","file":"main.c","line":12,"thread":4242,"msg":"Served /index.html"}
+
+ ts is Unix time in seconds. The *_kv variants of the logging macros attach typed fields, which show up
+ under "fields" in the JSON and as {"key":value} after the message everywhere else:
+
+	g_logger_kv fields[] = { g_logger_kv_str("path", path), g_logger_kv_int("status", 200), g_logger_kv_float("ms", 1.5) };
+	g_logger_info_kv(fields, 3, "Served %s", path);
+
+ There are g_logger_log_kv, g_logger_info_kv, g_logger_warning_kv and g_logger_error_kv. With cppPrint
+ style logging the message never gets formatted into a buffer, so those records have the raw "format"
+ string instead of "msg".
+
+ By default the log file grows forever. To keep it bounded, turn on rotation:
+
+	g_logger_set_log_rotation(uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles)
+
+ This applies to the g_logger_set_log_directory file, g_logger_add_rotating_file_sink takes the same
+ settings for any other file.
+
+ The log file gets rotated once writing the next record would push it past maxBytes, or once the wall
+ clock crosses the next multiple of intervalSeconds (3600 rotates on the hour, 86400 at midnight UTC).
+ Pass 0 to turn either one off. The active file always keeps its name. Rotated files get renamed to
+ log_<date>.1.txt (the newest), log_<date>.2.txt and so on, and only numRetainedFiles of them are kept.
+ Every file is preallocated to maxBytes up front, so a full disk shows up at rotation instead of in the
+ middle of a line. Rotation swaps the file out from under the writers without closing it. In async
+ mode the writer thread rotates, otherwise a background rotation thread does, so log calls never wait
+ on it. Records logged while a rotation is underway still go to the old file.
+
+ If you care most about keeping the last few records when the process crashes, there's also a memory
+ mapped log file. It gets the same text as the regular log file, but writing a record is just a memcpy
+ into a mapped segment, so nothing ever sits in a stdio buffer waiting to get lost:
+
+	g_logger_set_mapped_log_file(const char* filepath, uint64 segmentBytes, uint32 syncIntervalMs)
+
+ Segments are named like filepath with a number before the extension (app.1.log, app.2.log, ...) and
+ each one is preallocated to segmentBytes (GABE_LOGGER_MAPPED_SEGMENT_SIZE, 64MB by default, if you
+ pass 0). When one fills up the logger moves on to the next and trims the finished one to its real
+ size. A background thread syncs the current segment to disk every syncIntervalMs, pass 0 to leave
+ that to the OS. If the process dies, the segment it was writing to keeps its full size and ends in
+ zeros after the last record. Pass NULL to turn it off.
+
  Use this to restrict the messages to a particular level. This will log anything
  at the preferred level or higher:
 
 	g_logger_set_level(g_logger_level level)
 
+ That check still runs on every call though, and the arguments still get evaluated. To strip the
+ lower levels out of a build entirely, define GABE_LOGGER_MIN_LEVEL before including this file:
+
+	#define GABE_LOGGER_MIN_LEVEL 3 // 1 Log, 2 Info, 3 Warning, 4 Error
+
+ Every g_logger_log/info/warning/error below that level then compiles to nothing, including its
+ arguments. g_logger_assert is never removed. The runtime level still filters everything that's left.
+ Any level above 0 also removes g_logger_debug (see the flight recorder below).
+
+ To turn one part of a program up or down without touching the rest, log through a named channel:
+
+	g_logger_channel_log("net", "Connected to %s", address);
+	g_logger_set_channel_level("net", g_logger_level_Log);
+
+ There are g_logger_channel_log, g_logger_channel_info, g_logger_channel_warning and
+ g_logger_channel_error, and the channel name has to be a string literal. A channel filters with its own
+ level instead of the g_logger_set_level one, until you give it one it just follows g_logger_set_level.
+ Each call site looks its channel up the first time it runs and keeps the pointer, so the check is still
+ a single load and compare. To set a bunch of levels at once, or reload them from a config file:
+
+	g_logger_configure_channels("warning,net=log,render=error")
+
+ Entries are separated by commas, a bare level (or *=level) sets the global level, and channels that
+ aren't mentioned go back to following it. Levels are all, log, info, warning, error, assert, none or
+ their number. g_logger_init also applies the GABE_LOGGER_LEVELS environment variable this way, so
+ levels can be changed without a rebuild. At most GABE_LOGGER_MAX_CHANNELS (64) channels can exist.
+
+ To keep one misbehaving line from flooding the output, every log call site can be throttled on its
+ own. Both of these take the level of the macros they apply to, or g_logger_level_All for every level,
+ and 0 turns them back off:
+
+	g_logger_set_rate_limit(g_logger_level level, uint32 maxPerSecond)
+	g_logger_set_repeat_suppression(g_logger_level level, uint32 windowSeconds)
+
+ The rate limit lets each call site log at most maxPerSecond times per second. Repeat suppression
+ lets each call site log once, then swallows everything else from that site for windowSeconds. In
+ both cases the first message that makes it through afterwards is preceded by a
+ "suppressed K messages from this site" line, and g_logger_free reports whatever is still pending
+ when the program shuts down. A throttled call costs one relaxed atomic add.
+
+ Every log macro expands to a static g_logger_site with the file, line and level in it, so a log call
+ only passes a pointer to that plus the format and arguments. The first time a call runs its site gets
+ interned: the file is trimmed down to its basename (that's what gets printed) and the site gets a
+ 4 byte id. Binary log files write that id with every record instead of the strings.
+
+ Timestamps are cached per thread, so localtime/strftime only run once a second per thread instead of
+ on every message. You can add microseconds to every timestamp with:
+
+	g_logger_set_timestamp_microseconds(bool enabled)
+
+ and pick where the time comes from with:
+
+	g_logger_set_clock(g_logger_clock clock)
+
+	g_logger_clock_System -- The wall clock (the default). One clock read per message.
+	g_logger_clock_Tsc    -- Reads the CPU timestamp counter instead (a monotonic clock on CPUs without
+							 one). It's calibrated against the wall clock when you select it, which
+							 blocks for about 10ms, and after that never jumps when the system clock
+							 gets adjusted. Selecting it again re-anchors it to the wall clock, and
+							 that's safe to do while other threads are logging.
+
+ By default every log call formats and writes the message on the calling thread while holding a
+ mutex. To take the I/O off your threads, switch the logger to async mode:
+
+	g_logger_enable_async(uint32 numRecords, g_logger_overflow_policy policy)
+
+ Callers then format the message straight into a slot of a lock-free multi-producer ring buffer
+ (numRecords is rounded up to a power of two) and a dedicated writer thread drains it to stdout and the
+ log file. Messages longer than GABE_LOGGER_ASYNC_MESSAGE_SIZE bytes are truncated, define it before
+ including this file to change that. Key/value fields get at most half of that, the ones that don't fit
+ are left out and the record gets a "_truncated":true field instead. The policy decides what happens when the ring is full:
+
+	g_logger_overflow_Block        -- Wait for the writer thread to make room. Nothing is lost.
+	g_logger_overflow_Drop         -- Throw the message away.
+	g_logger_overflow_DropAndCount -- Throw the message away and count it. The writer thread logs how
+									  many messages were dropped, and g_logger_get_dropped_count()
+									  returns the running total.
+
+ g_logger_flush() waits until everything logged so far has been written. g_logger_disable_async()
+ flushes, stops the writer thread and goes back to synchronous logging. g_logger_free() does this
+ for you. Assertion failures always flush before printing.
+
+ On Linux the writer thread can hand file sink writes to io_uring instead of calling write(2) once per
+ record. Turn it on before g_logger_enable_async:
+
+	g_logger_set_io_uring_writer(bool enabled, g_logger_fsync_policy fsyncPolicy, uint32 fsyncIntervalMs)
+
+ Records get copied into one of two registered buffers (GABE_LOGGER_URING_BUFFER_SIZE, 256KB each) and
+ each batch goes to the kernel in a single io_uring_enter, so the writer never blocks in write(2). It
+ only waits when the disk falls a whole buffer behind. The fsync policy decides when the files get an
+ fdatasync behind the writes:
+
+	g_logger_fsync_Never      -- Leave it to the OS.
+	g_logger_fsync_EveryBatch -- After every batch.
+	g_logger_fsync_Interval   -- At most once every fsyncIntervalMs.
+
+ This returns false, and the writer keeps using write(2), on anything but Linux 5.6 or newer, or when
+ io_uring is disabled. The console and every other output still get written the usual way.
+
+ With cppPrint style logging you can go one step further and skip formatting on the calling thread
+ entirely:
+
+	g_logger_set_deferred_formatting(bool enabled)
+
+ While async mode is on, every log call then only copies a site id plus the raw bytes of its arguments
+ into the ring buffer. Each call site registers itself once (file, line, level, format string, argument
+ types and a decode function generated from the argument types) the first time it runs. The writer
+ thread then does all of the formatting. Integers, floats, chars, bools, pointers, C strings and
+ std::strings are captured this way. Calls with anything else (types with a custom operator<<) are
+ formatted immediately like before.
+
+	g_logger_set_binary_log_file(const char* filepath)
+
+ goes further still. Deferred records are written to filepath untouched and never formatted in
+ process. Decode the file later with the CppUtilsLogDecoder tool (tools/logDecoder.cpp):
+
+	CppUtilsLogDecoder path/to/binary/log
+
+ cppPrint only builds on Windows for now, so deferred formatting and binary log files are Windows only
+ too. CMake only creates CppUtilsLogDecoder (and the CppUtilsLogBenchBinary benchmark) there.
+
+ When something crashes, the messages right before it are usually the interesting ones, and they're
+ often at a level you had filtered out. The flight recorder keeps the last numRecordsPerThread records
+ of every thread in memory, whatever the level, and writes them to fileDescriptor when an assertion fails:
+
+	g_logger_enable_flight_recorder(uint32 numRecordsPerThread, int fileDescriptor)
+
+ Records are never formatted while the program runs. Each one is the call site, a timestamp and a raw
+ copy of the arguments (strings get copied, up to GABE_LOGGER_FLIGHT_ARGS_SIZE bytes of arguments per
+ record), so recording is cheap enough to leave on. That also makes room for a level below g_logger_log
+ that only ever goes to the flight recorder:
+
+	g_logger_debug(const char* format, ...args)
+
+ The dump is async-signal-safe, and g_memory_installCrashHandler writes it too when the process gets a
+ fatal signal, so install that if you want the recorder on crashes as well (you can pass both the same
+ file descriptor). You can also dump it yourself, even from your own signal handlers:
+
+	g_logger_write_flight_recorder(int fileDescriptor)
+
+ The dump does its own formatting since it can't use printf. It handles the usual conversions and
+ precisions, but ignores widths and flags. Strings with a precision only get copied up to it.
+
+ Calling g_logger_enable_flight_recorder again with a different numRecordsPerThread starts over with
+ rings of the new size, which drops everything recorded so far.
+
+
+ -------- THREAD UTILS --------
+
+ g_thread_createMutex() heap allocates a platform mutex and hands back a pointer to it. When you can
+ embed the lock in whatever it protects, use one of these instead. They're plain structs, so zero
+ initializing them is all the setup they need and they never allocate. The _INIT macros zero every
+ field, in C++ `= {}` works too:
+
+	g_thread_mutex mtx = G_THREAD_MUTEX_INIT;
+	g_thread_mutexLock(&mtx);
+	// ...
+	g_thread_mutexUnlock(&mtx);
+
+	g_thread_spinlock lock = G_THREAD_SPINLOCK_INIT;
+	g_thread_spinlockLock(&lock);
+	g_thread_spinlockUnlock(&lock);
+
+ g_thread_mutex spins for a bit before it puts the thread to sleep, which is what you want almost
+ everywhere, and it's what the memory tracker and the logger use internally. g_thread_spinlock never
+ sleeps, so keep it for tiny critical sections on threads that have a core to themselves. Both have
+ lock(), try_lock() and unlock() in C++, so they work with std::lock_guard. CppUtilsLockBench
+ (tools/lockBench.cpp) compares them to the platform mutex under contention.
+
+ For data that's read far more often than it's written there are two more, set up the same way:
+
+	g_thread_rwlock rwlock = G_THREAD_RWLOCK_INIT;
+	g_thread_rwlockReadLock(&rwlock);    // Any number of readers at once
+	g_thread_rwlockReadUnlock(&rwlock);
+	g_thread_rwlockWriteLock(&rwlock);   // One writer, and no readers
+	g_thread_rwlockWriteUnlock(&rwlock);
+
+	g_thread_seqlock seqlock = G_THREAD_SEQLOCK_INIT;
+	g_thread_seqlockWriteBegin(&seqlock);
+	shared = newValue;
+	g_thread_seqlockWriteEnd(&seqlock);
+
+	uint32 sequence;
+	do
+	{
+		sequence = g_thread_seqlockReadBegin(&seqlock);
+		copy = shared;
+	} while (g_thread_seqlockReadRetry(&seqlock, sequence));
+
+ The rwlock prefers writers, once one is waiting new readers queue up behind it. Use it for lookup
+ tables and config that readers hold onto for a while. The seqlock is for small, plain values like a
+ timestamp or a couple of counters. Its readers never write anything, so they scale with the number of
+ cores, but they have to copy the value out and try again if a write overlapped. In C++ the rwlock
+ works with std::shared_lock, and g_thread_seqlockRead(&seqlock, shared) does the retry loop for you.
+ The logger keeps its tick clock calibration under a seqlock.
+
 
  -------- DLL STUFF --------
 
@@ -217,16 +569,40 @@ extern "C" {
 	GABE_CPP_UTILS_API void* _g_memory_realloc(const char* filename, int line, void* memory, size_t newSize);
 	GABE_CPP_UTILS_API void _g_memory_free(const char* filename, int line, void* memory);
 
+#define g_memory_allocateAligned(numBytes, alignment) _g_memory_allocateAligned(__FILE__, __LINE__, numBytes, alignment)
+#define g_memory_freeAligned(memory) _g_memory_freeAligned(__FILE__, __LINE__, memory)
+
+	GABE_CPP_UTILS_API void* _g_memory_allocateAligned(const char* filename, int line, size_t numBytes, size_t alignment);
+	GABE_CPP_UTILS_API void _g_memory_freeAligned(const char* filename, int line, void* memory);
+
 	GABE_CPP_UTILS_API void g_memory_init(bool detectMemoryLeaks);
 	GABE_CPP_UTILS_API void g_memory_init_padding(bool detectMemoryLeaks, uint16 bufferPadding);
 	GABE_CPP_UTILS_API void g_memory_init_padding_zeroed(bool detectMemoryLeaks, uint16 bufferPadding, bool zeroMemoryOnAllocate);
 	GABE_CPP_UTILS_API void g_memory_deinit(void);
 	GABE_CPP_UTILS_API void g_memory_dumpMemoryLeaks(void);
 
+	GABE_CPP_UTILS_API void g_memory_installCrashHandler(int fileDescriptor);
+	GABE_CPP_UTILS_API void g_memory_uninstallCrashHandler(void);
+	GABE_CPP_UTILS_API void g_memory_writeCrashReport(int fileDescriptor);
+
 	GABE_CPP_UTILS_API bool g_memory_compareMem(void* a, size_t aLength, void* b, size_t bLength);
 	GABE_CPP_UTILS_API void g_memory_zeroMem(void* memory, size_t numBytes);
 	GABE_CPP_UTILS_API void g_memory_copyMem(void* dst, size_t dstNumBytes, void* src, size_t srcNumBytes);
 
+// Keeps hot atomics that are written by different threads off of each other's cache lines
+#ifndef GABE_CPP_UTILS_CACHE_LINE_SIZE
+#define GABE_CPP_UTILS_CACHE_LINE_SIZE 64
+#endif
+
+// Wrap types that are cache line aligned on purpose in these, so MSVC doesn't warn about the padding (C4324)
+#ifdef _MSC_VER
+#define GABE_CPP_UTILS_ALLOW_PADDING_BEGIN __pragma(warning(push)) __pragma(warning(disable : 4324))
+#define GABE_CPP_UTILS_ALLOW_PADDING_END __pragma(warning(pop))
+#else
+#define GABE_CPP_UTILS_ALLOW_PADDING_BEGIN
+#define GABE_CPP_UTILS_ALLOW_PADDING_END
+#endif
+
 	// ----------------------------------
 	// Logging Utils
 	// ----------------------------------
@@ -256,26 +632,174 @@ extern "C" {
 
 #define VA_ARGS(...) , ##__VA_ARGS__
 
+	// For the failure paths of g_logger_check/g_logger_verify, which should stay out of the hot code
+#if defined(__GNUC__) || defined(__clang__)
+#define _g_logger_unlikely(x) __builtin_expect(!!(x), 0)
+#define _g_logger_cold __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+#define _g_logger_unlikely(x) (x)
+#define _g_logger_cold __declspec(noinline)
+#else
+#define _g_logger_unlikely(x) (x)
+#define _g_logger_cold
+#endif
+
+	// Part of every g_logger_site. The top 32 bits are the second the current rate limit window started,
+	// the bottom 32 bits count the calls made during it. Check sites never open a window, they just count
+	// their failures in it (see _g_logger_checkFirstFailure).
+	typedef struct g_logger_rate_state
+	{
+		volatile uint64 state;
+	} g_logger_rate_state;
+
+	typedef void (*g_logger_binary_decode_fn)(const char* format, const uint8* payload, size_t payloadSize);
+
+#ifndef GABE_LOGGER_MAX_CHANNELS
+#define GABE_LOGGER_MAX_CHANNELS 64
+#endif
+
+#ifndef GABE_LOGGER_CHANNEL_NAME_SIZE
+#define GABE_LOGGER_CHANNEL_NAME_SIZE 32
+#endif
+
+	// A named group of log calls with its own level. Channels live in a fixed array inside the logger,
+	// so a pointer to one stays good until g_logger_free.
+	typedef struct g_logger_channel
+	{
+		char name[GABE_LOGGER_CHANNEL_NAME_SIZE];
+		// Lowest g_logger_level that gets through. Follows g_logger_set_level unless hasOwnLevel is set.
+		volatile uint32 level;
+		volatile uint32 hasOwnLevel;
+	} g_logger_channel;
+
+	// Every log macro expansion gets one of these as a static, so a log call only passes a pointer to
+	// it. The location and level are filled in at compile time. The first time the call runs the site
+	// gets interned: filename is trimmed down to the basename, the format is saved and the site gets a
+	// small id that binary log files use instead of the strings.
+	typedef struct g_logger_site
+	{
+		const char* filename;
+		int line;
+		g_logger_level level;
+		volatile uint32 id;
+		// Check sites are never rate limited, for them this counts the failures instead
+		g_logger_rate_state rate;
+		const char* format;
+		// Only cppPrint style call sites fill these in, they're what deferred formatting needs
+		uint8 numArgs;
+		const uint8* argTypes;
+		g_logger_binary_decode_fn decode;
+		// NULL for the plain macros. Otherwise the channel gets looked up once, when the site is interned.
+		const char* channelName;
+		g_logger_channel* channel;
+	} g_logger_site;
+
+#define _g_logger_siteInit(level) { __FILE__, __LINE__, level, 0, { 0 }, NULL, 0, NULL, NULL, NULL, NULL }
+#define _g_logger_channelSiteInit(channelName, level) { __FILE__, __LINE__, level, 0, { 0 }, NULL, 0, NULL, NULL, channelName, NULL }
+
+	GABE_CPP_UTILS_API void _g_logger_registerSite(g_logger_site* site, const char* format, uint8 numArgs, const uint8* argTypes, g_logger_binary_decode_fn decode);
+
+	typedef enum g_logger_kv_type
+	{
+		g_logger_kv_Int = 0,
+		g_logger_kv_UInt = 1,
+		g_logger_kv_Float = 2,
+		g_logger_kv_Bool = 3,
+		g_logger_kv_String = 4,
+	} g_logger_kv_type;
+
+	// A typed field for the *_kv logging macros. Use the g_logger_kv_* helpers below to make them.
+	typedef struct g_logger_kv
+	{
+		const char* key;
+		g_logger_kv_type type;
+		union
+		{
+			int64 i;
+			uint64 u;
+			double f;
+			bool b;
+			const char* s;
+		} value;
+	} g_logger_kv;
+
+	static inline g_logger_kv g_logger_kv_int(const char* key, int64 value) { g_logger_kv kv; kv.key = key; kv.type = g_logger_kv_Int; kv.value.i = value; return kv; }
+	static inline g_logger_kv g_logger_kv_uint(const char* key, uint64 value) { g_logger_kv kv; kv.key = key; kv.type = g_logger_kv_UInt; kv.value.u = value; return kv; }
+	static inline g_logger_kv g_logger_kv_float(const char* key, double value) { g_logger_kv kv; kv.key = key; kv.type = g_logger_kv_Float; kv.value.f = value; return kv; }
+	static inline g_logger_kv g_logger_kv_bool(const char* key, bool value) { g_logger_kv kv; kv.key = key; kv.type = g_logger_kv_Bool; kv.value.b = value; return kv; }
+	static inline g_logger_kv g_logger_kv_str(const char* key, const char* value) { g_logger_kv kv; kv.key = key; kv.type = g_logger_kv_String; kv.value.s = value; return kv; }
+
+	GABE_CPP_UTILS_API bool g_logger_set_json_log_file(const char* filepath);
+
+	GABE_CPP_UTILS_API void g_logger_set_rate_limit(g_logger_level level, uint32 maxPerSecond);
+	GABE_CPP_UTILS_API void g_logger_set_repeat_suppression(g_logger_level level, uint32 windowSeconds);
+	GABE_CPP_UTILS_API bool _g_logger_checkRateLimit(g_logger_rate_state* rate, g_logger_level level, uint32* outNumSuppressed);
+
 #ifndef USE_GABE_CPP_PRINT
 #ifdef _WIN32
-#define g_logger_log(format, ...) _g_logger_cStdCommonPrint(__FILE__, __LINE__, g_logger_level_Log, g_logger_FOREGROUND_BLUE | g_logger_FOREGROUND_GREEN, format VA_ARGS(__VA_ARGS__))
-#define g_logger_info(format, ...) _g_logger_cStdCommonPrint(__FILE__, __LINE__, g_logger_level_Info, g_logger_FOREGROUND_GREEN, format VA_ARGS(__VA_ARGS__))
-#define g_logger_warning(format, ...) _g_logger_cStdCommonPrint(__FILE__, __LINE__, g_logger_level_Warning, g_logger_FOREGROUND_GREEN | g_logger_FOREGROUND_RED, format VA_ARGS(__VA_ARGS__))
-#define g_logger_error(format, ...) _g_logger_cStdCommonPrint(__FILE__, __LINE__, g_logger_level_Error, g_logger_FOREGROUND_RED, format VA_ARGS(__VA_ARGS__))
+#define _g_logger_cStdSitePrint(level, format, ...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(level); _g_logger_cStdCommonPrint(&_g_logger_site, format VA_ARGS(__VA_ARGS__)); } while (0)
+
+#define g_logger_log(format, ...) _g_logger_cStdSitePrint(g_logger_level_Log, format VA_ARGS(__VA_ARGS__))
+#define g_logger_info(format, ...) _g_logger_cStdSitePrint(g_logger_level_Info, format VA_ARGS(__VA_ARGS__))
+#define g_logger_warning(format, ...) _g_logger_cStdSitePrint(g_logger_level_Warning, format VA_ARGS(__VA_ARGS__))
+#define g_logger_error(format, ...) _g_logger_cStdSitePrint(g_logger_level_Error, format VA_ARGS(__VA_ARGS__))
 #define g_logger_assert(condition, format, ...) _g_logger_assert(__FILE__, __LINE__, condition, format, __VA_ARGS__)
+#define g_logger_debug(format, ...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(g_logger_level_All); _g_logger_cStdDebug(&_g_logger_site, format VA_ARGS(__VA_ARGS__)); } while (0)
+
+#define _g_logger_cStdSiteKvPrint(level, fields, numFields, format, ...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(level); _g_logger_cStdKvPrint(&_g_logger_site, fields, numFields, format VA_ARGS(__VA_ARGS__)); } while (0)
+
+#define g_logger_log_kv(fields, numFields, format, ...) _g_logger_cStdSiteKvPrint(g_logger_level_Log, fields, numFields, format VA_ARGS(__VA_ARGS__))
+#define g_logger_info_kv(fields, numFields, format, ...) _g_logger_cStdSiteKvPrint(g_logger_level_Info, fields, numFields, format VA_ARGS(__VA_ARGS__))
+#define g_logger_warning_kv(fields, numFields, format, ...) _g_logger_cStdSiteKvPrint(g_logger_level_Warning, fields, numFields, format VA_ARGS(__VA_ARGS__))
+#define g_logger_error_kv(fields, numFields, format, ...) _g_logger_cStdSiteKvPrint(g_logger_level_Error, fields, numFields, format VA_ARGS(__VA_ARGS__))
 
-	GABE_CPP_UTILS_API void _g_logger_cStdCommonPrint(const char* filename, int line, g_logger_level level, WORD color, const char* format, ...);
+#define _g_logger_cStdChannelPrint(channelName, level, format, ...) do { static g_logger_site _g_logger_site = _g_logger_channelSiteInit(channelName, level); _g_logger_cStdCommonPrint(&_g_logger_site, format VA_ARGS(__VA_ARGS__)); } while (0)
+
+#define g_logger_channel_log(channelName, format, ...) _g_logger_cStdChannelPrint(channelName, g_logger_level_Log, format VA_ARGS(__VA_ARGS__))
+#define g_logger_channel_info(channelName, format, ...) _g_logger_cStdChannelPrint(channelName, g_logger_level_Info, format VA_ARGS(__VA_ARGS__))
+#define g_logger_channel_warning(channelName, format, ...) _g_logger_cStdChannelPrint(channelName, g_logger_level_Warning, format VA_ARGS(__VA_ARGS__))
+#define g_logger_channel_error(channelName, format, ...) _g_logger_cStdChannelPrint(channelName, g_logger_level_Error, format VA_ARGS(__VA_ARGS__))
+
+#define g_logger_check(condition, format, ...) do { if (_g_logger_unlikely(!(condition))) { static g_logger_site _g_logger_site = _g_logger_siteInit(g_logger_level_Error); _g_logger_checkFailed(&_g_logger_site, #condition, format VA_ARGS(__VA_ARGS__)); } } while (0)
+#define g_logger_verify(condition, format, ...) g_logger_check(condition, format VA_ARGS(__VA_ARGS__))
+
+	GABE_CPP_UTILS_API void _g_logger_cStdCommonPrint(g_logger_site* site, const char* format, ...);
+	GABE_CPP_UTILS_API void _g_logger_cStdKvPrint(g_logger_site* site, const g_logger_kv* fields, uint32 numFields, const char* format, ...);
 #elif defined(unix) || defined(__unix) || defined(__unix__)
-#define g_logger_log(format, ...) _g_logger_cStdCommonPrint(__FILE__, __LINE__, g_logger_level_Log, ColorCode::KBLU, format,##__VA_ARGS__)
-#define g_logger_info(format, ...) _g_logger_cStdCommonPrint(__FILE__, __LINE__, g_logger_level_Info, ColorCode::KGRN, format,##__VA_ARGS__)
-#define g_logger_warning(format, ...) _g_logger_cStdCommonPrint(__FILE__, __LINE__, , g_logger_level_Warning, ColorCode::KYEL, format,##__VA_ARGS__)
-#define g_logger_error(format, ...) _g_logger_cStdCommonPrint(__FILE__, __LINE__, , g_logger_level_Error, ColorCode::KRED, format,##__VA_ARGS__)
-#define g_logger_assert(condition, format, ...) _g_logger_assert(__FILE__, __LINE__, condition, format,##__VA_ARGS__)
+#define _g_logger_cStdSitePrint(level, ...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(level); _g_logger_cStdCommonPrint(&_g_logger_site, __VA_ARGS__); } while (0)
+
+#define g_logger_log(...) _g_logger_cStdSitePrint(g_logger_level_Log, __VA_ARGS__)
+#define g_logger_info(...) _g_logger_cStdSitePrint(g_logger_level_Info, __VA_ARGS__)
+#define g_logger_warning(...) _g_logger_cStdSitePrint(g_logger_level_Warning, __VA_ARGS__)
+#define g_logger_error(...) _g_logger_cStdSitePrint(g_logger_level_Error, __VA_ARGS__)
+#define g_logger_assert(condition, ...) _g_logger_assert(__FILE__, __LINE__, condition, __VA_ARGS__)
+#define g_logger_debug(...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(g_logger_level_All); _g_logger_cStdDebug(&_g_logger_site, __VA_ARGS__); } while (0)
 
-	GABE_CPP_UTILS_API void _g_logger_cStdCommonPrint(const char* filename, int line, g_logger_level level, const char* color, const char* format, ...);
+#define _g_logger_cStdSiteKvPrint(level, fields, numFields, ...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(level); _g_logger_cStdKvPrint(&_g_logger_site, fields, numFields, __VA_ARGS__); } while (0)
+
+#define g_logger_log_kv(fields, numFields, ...) _g_logger_cStdSiteKvPrint(g_logger_level_Log, fields, numFields, __VA_ARGS__)
+#define g_logger_info_kv(fields, numFields, ...) _g_logger_cStdSiteKvPrint(g_logger_level_Info, fields, numFields, __VA_ARGS__)
+#define g_logger_warning_kv(fields, numFields, ...) _g_logger_cStdSiteKvPrint(g_logger_level_Warning, fields, numFields, __VA_ARGS__)
+#define g_logger_error_kv(fields, numFields, ...) _g_logger_cStdSiteKvPrint(g_logger_level_Error, fields, numFields, __VA_ARGS__)
+
+#define _g_logger_cStdChannelPrint(channelName, level, ...) do { static g_logger_site _g_logger_site = _g_logger_channelSiteInit(channelName, level); _g_logger_cStdCommonPrint(&_g_logger_site, __VA_ARGS__); } while (0)
+
+#define g_logger_channel_log(channelName, ...) _g_logger_cStdChannelPrint(channelName, g_logger_level_Log, __VA_ARGS__)
+#define g_logger_channel_info(channelName, ...) _g_logger_cStdChannelPrint(channelName, g_logger_level_Info, __VA_ARGS__)
+#define g_logger_channel_warning(channelName, ...) _g_logger_cStdChannelPrint(channelName, g_logger_level_Warning, __VA_ARGS__)
+#define g_logger_channel_error(channelName, ...) _g_logger_cStdChannelPrint(channelName, g_logger_level_Error, __VA_ARGS__)
+
+#define g_logger_check(condition, ...) do { if (_g_logger_unlikely(!(condition))) { static g_logger_site _g_logger_site = _g_logger_siteInit(g_logger_level_Error); _g_logger_checkFailed(&_g_logger_site, #condition, __VA_ARGS__); } } while (0)
+#define g_logger_verify(condition, ...) g_logger_check(condition, __VA_ARGS__)
+
+	GABE_CPP_UTILS_API void _g_logger_cStdCommonPrint(g_logger_site* site, const char* format, ...);
+	GABE_CPP_UTILS_API void _g_logger_cStdKvPrint(g_logger_site* site, const g_logger_kv* fields, uint32 numFields, const char* format, ...);
 #else 
 #error "Unsupported platform for logging."
 #endif
+
+	GABE_CPP_UTILS_API void _g_logger_cStdDebug(g_logger_site* site, const char* format, ...);
+	_g_logger_cold GABE_CPP_UTILS_API void _g_logger_checkFailed(g_logger_site* site, const char* condition, const char* format, ...);
 #endif // #ifndef USE_GABE_CPP_PRINT
 
 	GABE_CPP_UTILS_API void _g_logger_assert(const char* filename, int line, int condition, const char* format, ...);
@@ -283,16 +807,166 @@ extern "C" {
 	GABE_CPP_UTILS_API void g_logger_set_level(g_logger_level level);
 	GABE_CPP_UTILS_API g_logger_level g_logger_get_level(void);
 
+	GABE_CPP_UTILS_API bool g_logger_set_channel_level(const char* channelName, g_logger_level level);
+	GABE_CPP_UTILS_API g_logger_level g_logger_get_channel_level(const char* channelName);
+	GABE_CPP_UTILS_API g_logger_channel* g_logger_get_channel(const char* channelName);
+	GABE_CPP_UTILS_API bool g_logger_configure_channels(const char* config);
+
+	// What a failed g_logger_check/g_logger_verify does after it's been logged
+	typedef enum g_logger_check_action
+	{
+		g_logger_check_Continue = 0,
+		g_logger_check_Abort = 1,
+		g_logger_check_Callback = 2,
+	} g_logger_check_action;
+
+	// message is the formatted message with printf style logging, and the format string with cppPrint
+	typedef void (*g_logger_check_callback)(void* userData, const char* filename, int line, const char* condition, const char* message);
+
+	GABE_CPP_UTILS_API void g_logger_set_check_action(g_logger_check_action action, g_logger_check_callback callback, void* userData);
+	GABE_CPP_UTILS_API uint64 g_logger_get_check_failure_count(void);
+
+	GABE_CPP_UTILS_API bool _g_logger_checkFirstFailure(g_logger_site* site);
+	GABE_CPP_UTILS_API void _g_logger_checkReport(const g_logger_site* site, const char* condition, const char* message);
+	GABE_CPP_UTILS_API void _g_logger_checkAbortIfNeeded(void);
+
+	// The level a site has to reach to get logged. Sites cache their channel, so this is one load.
+	static inline g_logger_level _g_logger_siteMinLevel(const g_logger_site* site)
+	{
+		return site->channel ? (g_logger_level)site->channel->level : g_logger_get_level();
+	}
+
 	GABE_CPP_UTILS_API void g_logger_init(void);
 	GABE_CPP_UTILS_API void g_logger_free(void);
 
 	GABE_CPP_UTILS_API void g_logger_set_log_directory(const char* directory);
+	GABE_CPP_UTILS_API void g_logger_set_log_rotation(uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles);
+
+	// Handle to a log sink. Negative means adding the sink failed.
+	typedef int32 g_logger_sink;
+
+#ifndef GABE_LOGGER_MAX_SINKS
+#define GABE_LOGGER_MAX_SINKS 8
+#endif
+
+	// g_logger_init adds a console sink that takes every level with the default format
+#define g_logger_console_sink ((g_logger_sink)0)
+
+	// Which parts of a record a sink writes. The message itself is always written.
+	typedef enum g_logger_format
+	{
+		g_logger_format_Message = 0,
+		g_logger_format_Location = 1,
+		g_logger_format_Timestamp = 2,
+		g_logger_format_Color = 4,
+		g_logger_format_Default = 7,
+	} g_logger_format;
+
+	// What a callback sink gets. None of the strings are null terminated, and they're only valid during
+	// the callback. text is the record laid out the way the sink's format asked for.
+	typedef struct g_logger_sink_record
+	{
+		g_logger_level level;
+		const char* filename;
+		int line;
+		const char* timestamp;
+		size_t timestampLength;
+		const char* message;
+		size_t messageLength;
+		const char* text;
+		size_t textLength;
+	} g_logger_sink_record;
+
+	typedef void (*g_logger_sink_callback)(void* userData, const g_logger_sink_record* record);
+
+	GABE_CPP_UTILS_API g_logger_sink g_logger_add_console_sink(g_logger_level level, uint32 format);
+	GABE_CPP_UTILS_API g_logger_sink g_logger_add_file_sink(const char* filepath, g_logger_level level, uint32 format);
+	GABE_CPP_UTILS_API g_logger_sink g_logger_add_rotating_file_sink(const char* filepath, g_logger_level level, uint32 format, uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles);
+	GABE_CPP_UTILS_API g_logger_sink g_logger_add_memory_sink(size_t capacityBytes, g_logger_level level, uint32 format);
+	GABE_CPP_UTILS_API g_logger_sink g_logger_add_callback_sink(g_logger_sink_callback callback, void* userData, g_logger_level level, uint32 format);
+	GABE_CPP_UTILS_API size_t g_logger_read_memory_sink(g_logger_sink sink, char* buffer, size_t bufferSize);
+	GABE_CPP_UTILS_API void g_logger_remove_sink(g_logger_sink sink);
+	GABE_CPP_UTILS_API void g_logger_set_sink_level(g_logger_sink sink, g_logger_level level);
+	GABE_CPP_UTILS_API void g_logger_set_sink_format(g_logger_sink sink, uint32 format);
+
+	// Size of each memory mapped log segment when g_logger_set_mapped_log_file gets 0 for it
+#ifndef GABE_LOGGER_MAPPED_SEGMENT_SIZE
+#define GABE_LOGGER_MAPPED_SEGMENT_SIZE (64ull * 1024ull * 1024ull)
+#endif
+
+	GABE_CPP_UTILS_API bool g_logger_set_mapped_log_file(const char* filepath, uint64 segmentBytes, uint32 syncIntervalMs);
+
+	// Where log timestamps come from
+	typedef enum g_logger_clock
+	{
+		g_logger_clock_System = 0,
+		g_logger_clock_Tsc = 1,
+	} g_logger_clock;
+
+	GABE_CPP_UTILS_API void g_logger_set_clock(g_logger_clock clock);
+	GABE_CPP_UTILS_API void g_logger_set_timestamp_microseconds(bool enabled);
+
+	// Big enough for "YYYY-MM-DD hh:mm:ss.uuuuuu" plus the null byte
+#define GABE_LOGGER_TIMESTAMP_SIZE 32
+
+	// What happens when a thread logs in async mode and the ring buffer is full
+	typedef enum g_logger_overflow_policy
+	{
+		g_logger_overflow_Block = 0,
+		g_logger_overflow_Drop = 1,
+		g_logger_overflow_DropAndCount = 2,
+	} g_logger_overflow_policy;
+
+	// Max size of a formatted message in async mode. Anything longer gets truncated.
+#ifndef GABE_LOGGER_ASYNC_MESSAGE_SIZE
+#define GABE_LOGGER_ASYNC_MESSAGE_SIZE 512
+#endif
+
+	GABE_CPP_UTILS_API void g_logger_enable_async(uint32 numRecords, g_logger_overflow_policy policy);
+	GABE_CPP_UTILS_API void g_logger_disable_async(void);
+	GABE_CPP_UTILS_API void g_logger_flush(void);
+	GABE_CPP_UTILS_API uint64 g_logger_get_dropped_count(void);
+
+	typedef enum g_logger_fsync_policy
+	{
+		g_logger_fsync_Never = 0,
+		g_logger_fsync_EveryBatch = 1,
+		g_logger_fsync_Interval = 2,
+	} g_logger_fsync_policy;
+
+	// Size of each of the two staging buffers the io_uring writer fills
+#ifndef GABE_LOGGER_URING_BUFFER_SIZE
+#define GABE_LOGGER_URING_BUFFER_SIZE (256 * 1024)
+#endif
+
+	// Linux only, see the docs at the top of the file. Returns false when io_uring isn't available.
+	GABE_CPP_UTILS_API bool g_logger_set_io_uring_writer(bool enabled, g_logger_fsync_policy fsyncPolicy, uint32 fsyncIntervalMs);
+
+	// Deferred formatting (only used by cppPrint style logging, see the docs at the top of the file)
+	GABE_CPP_UTILS_API void g_logger_set_deferred_formatting(bool enabled);
+	GABE_CPP_UTILS_API bool g_logger_set_binary_log_file(const char* filepath);
+
+	GABE_CPP_UTILS_API bool _g_logger_isDeferred(void);
+	// Returns false if async mode is off. *outPayload is NULL if the overflow policy dropped the record.
+	GABE_CPP_UTILS_API bool _g_logger_beginBinaryRecord(const g_logger_site* site, size_t payloadSize, uint8** outPayload, void** outRecordHandle);
+	GABE_CPP_UTILS_API void _g_logger_endBinaryRecord(void* recordHandle);
+
+	// Bytes of argument data each flight recorder record has room for. Arguments past that aren't recorded.
+#ifndef GABE_LOGGER_FLIGHT_ARGS_SIZE
+#define GABE_LOGGER_FLIGHT_ARGS_SIZE 192
+#endif
+
+	GABE_CPP_UTILS_API void g_logger_enable_flight_recorder(uint32 numRecordsPerThread, int fileDescriptor);
+	GABE_CPP_UTILS_API void g_logger_write_flight_recorder(int fileDescriptor);
+	GABE_CPP_UTILS_API bool _g_logger_isFlightRecording(void);
+	GABE_CPP_UTILS_API uint8* _g_logger_beginFlightRecord(const char* filename, int line, g_logger_level level, const char* format, uint8 numArgs, const uint8* argTypes, size_t payloadSize);
+	GABE_CPP_UTILS_API void _g_logger_endFlightRecord(void);
 
 	// ----------------------------------
 	// Thread safety utils
 	// ----------------------------------
 
-	// These "mutexes" are really Win32 critical sections
+	// These "mutexes" are really Win32 critical sections (pthread mutexes on Linux)
 	// You should use a different library if you need interprocess
 	// mutexes and not single-multithread-process mutexes
 
@@ -301,79 +975,608 @@ extern "C" {
 	GABE_CPP_UTILS_API void g_thread_releaseMutex(void* mtx);
 	GABE_CPP_UTILS_API void g_thread_freeMutex(void* mtx);
 
+	// Locks that live inside whatever they protect instead of on the heap. Zero initialize them
+	// (`g_thread_mutex mtx = G_THREAD_MUTEX_INIT;`) and they're ready to go, there's nothing to create
+	// or free. Neither of them is recursive.
+	//
+	//   * g_thread_mutex    -- Spins for a little while and then sleeps in the kernel (a futex on Linux,
+	//                          WaitOnAddress on Windows). How long it spins adapts to how long it
+	//                          usually takes to get the lock. Uncontended lock and unlock are one atomic
+	//                          instruction each.
+	//   * g_thread_spinlock -- A ticket lock. Hands the lock out in FIFO order and never sleeps, so only
+	//                          use it around a handful of instructions, and only when there aren't more
+	//                          threads fighting over it than there are cores.
+	//
+	// In C++ both have lock(), try_lock() and unlock(), so std::lock_guard and std::unique_lock work.
+
+	// Upper bound on how many times g_thread_mutexLock spins before it goes to sleep
+#ifndef GABE_THREAD_MUTEX_MAX_SPINS
+#define GABE_THREAD_MUTEX_MAX_SPINS 100
+#endif
+
+	typedef struct g_thread_mutex g_thread_mutex;
+	typedef struct g_thread_spinlock g_thread_spinlock;
+
+	GABE_CPP_UTILS_API void g_thread_mutexLock(g_thread_mutex* mtx);
+	GABE_CPP_UTILS_API bool g_thread_mutexTryLock(g_thread_mutex* mtx);
+	GABE_CPP_UTILS_API void g_thread_mutexUnlock(g_thread_mutex* mtx);
+
+	GABE_CPP_UTILS_API void g_thread_spinlockLock(g_thread_spinlock* lock);
+	GABE_CPP_UTILS_API bool g_thread_spinlockTryLock(g_thread_spinlock* lock);
+	GABE_CPP_UTILS_API void g_thread_spinlockUnlock(g_thread_spinlock* lock);
+
+	struct g_thread_mutex
+	{
+		// 0 is unlocked, 1 is locked and 2 is locked with threads that might be sleeping on it
+		volatile uint32 state;
+		// Running average of how many spins it took to get the lock
+		volatile uint32 spins;
+
 #ifdef __cplusplus
+		inline void lock() { g_thread_mutexLock(this); }
+		inline bool try_lock() { return g_thread_mutexTryLock(this); }
+		inline void unlock() { g_thread_mutexUnlock(this); }
+#endif
+	};
+
+	struct g_thread_spinlock
+	{
+		volatile uint32 nextTicket;
+		volatile uint32 nowServing;
+
+#ifdef __cplusplus
+		inline void lock() { g_thread_spinlockLock(this); }
+		inline bool try_lock() { return g_thread_spinlockTryLock(this); }
+		inline void unlock() { g_thread_spinlockUnlock(this); }
+#endif
+	};
+
+	// Spells out every field, so they work in C and C++ without -Wmissing-field-initializers complaining
+#define G_THREAD_MUTEX_INIT { 0, 0 }
+#define G_THREAD_SPINLOCK_INIT { 0, 0 }
+
+	// Two more embedded locks for data that gets read far more often than it gets written. Zero
+	// initialize these too, with G_THREAD_RWLOCK_INIT and G_THREAD_SEQLOCK_INIT.
+	//
+	//   * g_thread_rwlock  -- Any number of readers at once, or one writer. Writer preferring: once a
+	//                         writer is waiting, new readers wait behind it, so a steady stream of
+	//                         readers can't starve writers. Readers and writers both sleep instead of
+	//                         spinning when they have to wait. Not recursive, and a reader can't
+	//                         upgrade to a writer.
+	//   * g_thread_seqlock -- Readers never write to shared memory at all, so they don't bounce cache
+	//                         lines between cores. Writers bump a sequence number before and after they
+	//                         write, and readers copy the data out and retry if a write overlapped the
+	//                         copy. Only use it for small, plain data that's cheap to copy, and never
+	//                         follow pointers you read before the retry check passes. Writers exclude
+	//                         each other by spinning, so keep writes short. See THREAD UTILS at the
+	//                         top of this file for the read loop.
+
+	typedef struct g_thread_rwlock g_thread_rwlock;
+	typedef struct g_thread_seqlock g_thread_seqlock;
+
+	GABE_CPP_UTILS_API void g_thread_rwlockReadLock(g_thread_rwlock* lock);
+	GABE_CPP_UTILS_API bool g_thread_rwlockTryReadLock(g_thread_rwlock* lock);
+	GABE_CPP_UTILS_API void g_thread_rwlockReadUnlock(g_thread_rwlock* lock);
+	GABE_CPP_UTILS_API void g_thread_rwlockWriteLock(g_thread_rwlock* lock);
+	GABE_CPP_UTILS_API bool g_thread_rwlockTryWriteLock(g_thread_rwlock* lock);
+	GABE_CPP_UTILS_API void g_thread_rwlockWriteUnlock(g_thread_rwlock* lock);
+
+	GABE_CPP_UTILS_API void g_thread_seqlockWriteBegin(g_thread_seqlock* lock);
+	GABE_CPP_UTILS_API void g_thread_seqlockWriteEnd(g_thread_seqlock* lock);
+	GABE_CPP_UTILS_API uint32 g_thread_seqlockReadBegin(const g_thread_seqlock* lock);
+	GABE_CPP_UTILS_API bool g_thread_seqlockReadRetry(const g_thread_seqlock* lock, uint32 sequence);
+
+	struct g_thread_rwlock
+	{
+		// The low 31 bits count the readers holding it. The top bit is set while a writer holds it or
+		// is waiting for the readers to leave.
+		volatile uint32 state;
+		volatile uint32 numWaitingWriters;
+		// Readers sleep on this and writers bump it when they're done, so no wake up gets lost
+		volatile uint32 readerWakeSequence;
+		volatile uint32 numSleepingReaders;
+		// Lines the writers up behind each other
+		g_thread_mutex writerMutex;
+
+#ifdef __cplusplus
+		inline void lock() { g_thread_rwlockWriteLock(this); }
+		inline bool try_lock() { return g_thread_rwlockTryWriteLock(this); }
+		inline void unlock() { g_thread_rwlockWriteUnlock(this); }
+		inline void lock_shared() { g_thread_rwlockReadLock(this); }
+		inline bool try_lock_shared() { return g_thread_rwlockTryReadLock(this); }
+		inline void unlock_shared() { g_thread_rwlockReadUnlock(this); }
+#endif
+	};
+
+	struct g_thread_seqlock
+	{
+		// Odd while a write is in progress
+		volatile uint32 sequence;
+
+#ifdef __cplusplus
+		inline void writeBegin() { g_thread_seqlockWriteBegin(this); }
+		inline void writeEnd() { g_thread_seqlockWriteEnd(this); }
+		inline uint32 readBegin() const { return g_thread_seqlockReadBegin(this); }
+		inline bool readRetry(uint32 readSequence) const { return g_thread_seqlockReadRetry(this, readSequence); }
+#endif
+	};
+
+#define G_THREAD_RWLOCK_INIT { 0, 0, 0, 0, G_THREAD_MUTEX_INIT }
+#define G_THREAD_SEQLOCK_INIT { 0 }
+
+#ifdef __cplusplus
+}
+
+#include <string.h>
+#include <type_traits>
+
+// Copies `shared` out from under the seqlock, trying again until no write overlapped the copy.
+// The copy is done byte by byte with memcpy so a torn read never turns into a half constructed
+// object, which is also why T has to be trivially copyable.
+template<typename T>
+inline T g_thread_seqlockRead(const g_thread_seqlock* lock, const T& shared)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "g_thread_seqlockRead can only copy trivially copyable types");
+
+	T copy;
+	uint32 sequence;
+	do
+	{
+		sequence = g_thread_seqlockReadBegin(lock);
+		memcpy((void*)&copy, (const void*)&shared, sizeof(T));
+	} while (g_thread_seqlockReadRetry(lock, sequence));
+
+	return copy;
 }
 #endif
 
 // Template version of logging for using this library with GABE_CPP_PRINT library
 #ifdef USE_GABE_CPP_PRINT
 #include <cppUtils/cppPrint.hpp>
+#include <string.h>
+#include <string>
+#include <tuple>
+#include <type_traits>
 
-#ifdef _WIN32
-
-GABE_CPP_UTILS_API void _g_logger_printPreamble(const char* filename, int line, char* buf, size_t bufSize, CppUtils::ConsoleColor color);
-GABE_CPP_UTILS_API void _g_logger_printPostamble(const char* filename, int line, char* buf, size_t bufSize);
+// ----------------------------------
+// Deferred (binary) argument capture
+// ----------------------------------
+// These type codes are written to binary log files, so never reorder them. Only add to the end.
+enum class _g_logger_ArgType : uint8
+{
+	Unsupported = 0,
+	I8, I16, I32, I64,
+	U8, U16, U32, U64,
+	F32, F64,
+	Bool,
+	Char,
+	Pointer,
+	String,
+};
 
-template<typename...Args>
-GABE_CPP_UTILS_API void _g_logger_gabeCommonPrint(const char* filename, int line, g_logger_level level, CppUtils::ConsoleColor color, const char* format, const Args&... args)
+template<typename T>
+constexpr _g_logger_ArgType _g_logger_argType()
 {
-	if (g_logger_get_level() <= level)
+	using D = std::decay_t<T>;
+	if constexpr (std::is_same_v<D, bool>) return _g_logger_ArgType::Bool;
+	else if constexpr (std::is_same_v<D, char>) return _g_logger_ArgType::Char;
+	else if constexpr (std::is_same_v<D, float>) return _g_logger_ArgType::F32;
+	else if constexpr (std::is_same_v<D, double>) return _g_logger_ArgType::F64;
+	else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
 	{
-		char buf[20] = { 0 };
-		_g_logger_printPreamble(filename, line, buf, sizeof(buf), color);
-		CppUtils::IO::printf(format, args...);
-		_g_logger_printPostamble(filename, line, buf, sizeof(buf));
+		if constexpr (sizeof(D) == 1) return _g_logger_ArgType::I8;
+		else if constexpr (sizeof(D) == 2) return _g_logger_ArgType::I16;
+		else if constexpr (sizeof(D) == 4) return _g_logger_ArgType::I32;
+		else return _g_logger_ArgType::I64;
+	}
+	else if constexpr (std::is_integral_v<D>)
+	{
+		if constexpr (sizeof(D) == 1) return _g_logger_ArgType::U8;
+		else if constexpr (sizeof(D) == 2) return _g_logger_ArgType::U16;
+		else if constexpr (sizeof(D) == 4) return _g_logger_ArgType::U32;
+		else return _g_logger_ArgType::U64;
 	}
+	else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>
+		|| std::is_same_v<D, const unsigned char*> || std::is_same_v<D, unsigned char*>
+		|| std::is_same_v<D, std::string>) return _g_logger_ArgType::String;
+	else if constexpr (std::is_pointer_v<D>) return _g_logger_ArgType::Pointer;
+	// Anything with a custom operator<< has to be formatted on the calling thread
+	else return _g_logger_ArgType::Unsupported;
 }
 
-GABE_CPP_UTILS_API void _g_logger_assertGabePreamble(const char* filename, int line, char* buf, size_t bufSize);
-GABE_CPP_UTILS_API void _g_logger_assertGabePostamble(const char* filename, int line, char* buf, size_t bufSize);
+template<typename T>
+constexpr bool _g_logger_isCapturable() { return _g_logger_argType<T>() != _g_logger_ArgType::Unsupported; }
 
-template<typename...Args>
-GABE_CPP_UTILS_API void _g_logger_gabeAssert(const char* filename, int line, bool condition, const char* format, Args... args)
+template<typename T>
+inline const char* _g_logger_stringData(const T& value)
 {
-	if (g_logger_get_level() <= g_logger_level_Assert)
-	{
-		if (!condition)
-		{
-			char buf[20] = { 0 };
-			_g_logger_assertGabePreamble(filename, line, buf, sizeof(buf));
-			CppUtils::IO::printf(format, args...);
-			_g_logger_assertGabePostamble(filename, line, buf, sizeof(buf));
-		}
-	}
+	if constexpr (std::is_same_v<std::decay_t<T>, std::string>) return value.c_str();
+	else if constexpr (std::is_array_v<T>) return (const char*)value;
+	else return value ? (const char*)value : "(null)";
 }
 
-#define g_logger_log(format, ...) _g_logger_gabeCommonPrint(__FILE__, __LINE__, g_logger_level_Log, CppUtils::ConsoleColor::CYAN, format VA_ARGS(__VA_ARGS__))
-#define g_logger_info(format, ...) _g_logger_gabeCommonPrint(__FILE__, __LINE__, g_logger_level_Info, CppUtils::ConsoleColor::GREEN, format VA_ARGS(__VA_ARGS__))
-#define g_logger_warning(format, ...) _g_logger_gabeCommonPrint(__FILE__, __LINE__, g_logger_level_Warning, CppUtils::ConsoleColor::YELLOW, format VA_ARGS(__VA_ARGS__))
-#define g_logger_error(format, ...) _g_logger_gabeCommonPrint(__FILE__, __LINE__, g_logger_level_Error, CppUtils::ConsoleColor::RED, format VA_ARGS(__VA_ARGS__))
-#define g_logger_assert(condition, format, ...) _g_logger_gabeAssert(__FILE__, __LINE__, condition, format, __VA_ARGS__)
-
-#endif // _WIN32
-#endif // USE_GABE_CPP_PRINT
+// Strings are stored as a uint32 length followed by the bytes and a null terminator
+template<typename T>
+inline size_t _g_logger_argSize(const T& value)
+{
+	if constexpr (_g_logger_argType<T>() == _g_logger_ArgType::String) return sizeof(uint32) + strlen(_g_logger_stringData(value)) + 1;
+	else return sizeof(std::decay_t<T>);
+}
 
-#ifdef __cplusplus
+template<typename T>
+inline void _g_logger_writeArg(uint8*& cursor, const T& value)
+{
+	if constexpr (_g_logger_argType<T>() == _g_logger_ArgType::String)
+	{
+		const char* str = _g_logger_stringData(value);
+		uint32 length = (uint32)strlen(str);
+		memcpy(cursor, &length, sizeof(uint32));
+		memcpy(cursor + sizeof(uint32), str, length + 1);
+		cursor += sizeof(uint32) + length + 1;
+	}
+	else
+	{
+		std::decay_t<T> decayed = value;
+		memcpy(cursor, &decayed, sizeof(decayed));
+		cursor += sizeof(decayed);
+	}
+}
 
-void* operator new(size_t size, const char* filename, int line);
-void operator delete(void* memory, const char* filename, int line);
+// Strings come back out as pointers into the payload, everything else comes back as its own type
+template<typename T>
+using _g_logger_DecodedArg = std::conditional_t<_g_logger_argType<T>() == _g_logger_ArgType::String, const char*, std::decay_t<T>>;
 
 template<typename T>
-void _g_memory_delete(T* memory, const char* filename, int line)
+inline _g_logger_DecodedArg<T> _g_logger_readArg(const uint8*& cursor)
 {
-	if (memory)
+	if constexpr (_g_logger_argType<T>() == _g_logger_ArgType::String)
 	{
-		memory->~T();
-		_g_memory_free(filename, line, memory);
+		uint32 length;
+		memcpy(&length, cursor, sizeof(uint32));
+		const char* str = (const char*)(cursor + sizeof(uint32));
+		cursor += sizeof(uint32) + length + 1;
+		return str;
+	}
+	else
+	{
+		std::decay_t<T> value;
+		memcpy(&value, cursor, sizeof(value));
+		cursor += sizeof(value);
+		return value;
 	}
 }
 
-#define g_memory_new new(__FILE__, __LINE__)
-#define g_memory_delete(memory) _g_memory_delete(memory, __FILE__, __LINE__)
+// Instantiated once per argument list. The writer thread calls this through the site to format
+// the message with the exact same types the caller passed in.
+template<typename...Args>
+void _g_logger_binaryDecode(const char* format, const uint8* payload, size_t)
+{
+	const uint8* cursor = payload;
+	// Braced initialization guarantees the arguments are read left to right
+	std::tuple<_g_logger_DecodedArg<Args>...> values{ _g_logger_readArg<Args>(cursor)... };
+	std::apply([format](const auto&... decoded) { CppUtils::IO::printf(format, decoded...); }, values);
+}
 
-#endif // __cplusplus
+// Interns the site along with everything deferred formatting needs to decode its arguments later
+template<typename...Args>
+void _g_logger_registerGabeSite(g_logger_site* site, const char* format)
+{
+	if constexpr ((_g_logger_isCapturable<Args>() && ...))
+	{
+		static const uint8 argTypes[sizeof...(Args) + 1] = { (uint8)_g_logger_argType<Args>()..., 0 };
+		_g_logger_registerSite(site, format, (uint8)sizeof...(Args), argTypes, _g_logger_binaryDecode<Args...>);
+	}
+	else
+	{
+		_g_logger_registerSite(site, format, (uint8)sizeof...(Args), nullptr, nullptr);
+	}
+}
 
-#endif // GABE_CPP_UTILS_H
+// Returns false if the record can't be deferred and should be formatted right now instead
+template<typename...Args>
+bool _g_logger_pushBinary(const g_logger_site* site, const Args&... args)
+{
+	if (site->id == 0 || site->decode == nullptr)
+	{
+		return false;
+	}
+
+	size_t payloadSize = (0 + ... + _g_logger_argSize(args));
+	if (payloadSize > GABE_LOGGER_ASYNC_MESSAGE_SIZE)
+	{
+		return false;
+	}
+
+	void* recordHandle = NULL;
+	uint8* cursor = NULL;
+	if (!_g_logger_beginBinaryRecord(site, payloadSize, &cursor, &recordHandle))
+	{
+		// Async mode got turned off after the caller checked
+		return false;
+	}
+
+	if (cursor == NULL)
+	{
+		// Dropped by the overflow policy
+		return true;
+	}
+
+	(_g_logger_writeArg(cursor, args), ...);
+	_g_logger_endBinaryRecord(recordHandle);
+	return true;
+}
+
+// Copies the arguments into this thread's flight recorder without formatting them
+template<typename...Args>
+void _g_logger_recordFlight(const char* filename, int line, g_logger_level level, const char* format, const Args&... args)
+{
+	if constexpr ((_g_logger_isCapturable<Args>() && ...))
+	{
+		static const uint8 argTypes[sizeof...(Args) + 1] = { (uint8)_g_logger_argType<Args>()..., 0 };
+		size_t payloadSize = (0 + ... + _g_logger_argSize(args));
+		uint8* cursor = _g_logger_beginFlightRecord(filename, line, level, format, (uint8)sizeof...(Args), argTypes, payloadSize);
+		if (cursor)
+		{
+			(_g_logger_writeArg(cursor, args), ...);
+			_g_logger_endFlightRecord();
+		}
+	}
+	else
+	{
+		// Types with a custom operator<< can't be captured, so only the format string gets recorded
+		static const uint8 noArgs[1] = { 0 };
+		_g_logger_beginFlightRecord(filename, line, level, format, (uint8)sizeof...(Args), noArgs, (size_t)-1);
+	}
+}
+
+#ifdef _WIN32
+
+// The preamble takes the log lock and starts the record. Everything cppPrint prints on this thread
+// until the postamble goes into that record instead of the console, and the postamble hands the
+// finished record to every sink and releases the lock.
+GABE_CPP_UTILS_API void _g_logger_printPreamble(const g_logger_site* site);
+GABE_CPP_UTILS_API void _g_logger_printPostamble(const g_logger_site* site, const g_logger_kv* fields, uint32 numFields);
+
+// Formats and prints the record right away, on this thread
+template<typename...Args>
+void _g_logger_gabePrintNow(const g_logger_site* site, const char* format, const Args&... args)
+{
+	_g_logger_printPreamble(site);
+	CppUtils::IO::printf(format, args...);
+	_g_logger_printPostamble(site, nullptr, 0);
+}
+
+template<typename...Args>
+GABE_CPP_UTILS_API void _g_logger_gabeCommonPrint(g_logger_site* site, const char* format, const Args&... args)
+{
+	if (site->id == 0)
+	{
+		_g_logger_registerGabeSite<Args...>(site, format);
+	}
+
+	// Before the level check, the flight recorder keeps everything
+	if (_g_logger_isFlightRecording())
+	{
+		_g_logger_recordFlight(site->filename, site->line, site->level, format, args...);
+	}
+
+	if (_g_logger_siteMinLevel(site) <= site->level)
+	{
+		uint32 numSuppressed;
+		if (!_g_logger_checkRateLimit(&site->rate, site->level, &numSuppressed))
+		{
+			return;
+		}
+
+		if (numSuppressed > 0)
+		{
+			_g_logger_gabePrintNow(site, "suppressed {} messages from this site", numSuppressed);
+		}
+
+		if constexpr ((_g_logger_isCapturable<Args>() && ...))
+		{
+			if (_g_logger_isDeferred() && _g_logger_pushBinary(site, args...))
+			{
+				return;
+			}
+		}
+
+		_g_logger_gabePrintNow(site, format, args...);
+	}
+}
+
+template<typename...Args>
+GABE_CPP_UTILS_API void _g_logger_gabeKvPrint(g_logger_site* site, const g_logger_kv* fields, uint32 numFields, const char* format, const Args&... args)
+{
+	if (site->id == 0)
+	{
+		// Never deferred, the fields have nowhere to go in a binary record
+		_g_logger_registerSite(site, format, (uint8)sizeof...(Args), nullptr, nullptr);
+	}
+
+	if (_g_logger_isFlightRecording())
+	{
+		_g_logger_recordFlight(site->filename, site->line, site->level, format, args...);
+	}
+
+	if (_g_logger_siteMinLevel(site) <= site->level)
+	{
+		uint32 numSuppressed;
+		if (!_g_logger_checkRateLimit(&site->rate, site->level, &numSuppressed))
+		{
+			return;
+		}
+
+		if (numSuppressed > 0)
+		{
+			_g_logger_gabePrintNow(site, "suppressed {} messages from this site", numSuppressed);
+		}
+
+		_g_logger_printPreamble(site);
+		CppUtils::IO::printf(format, args...);
+		_g_logger_printPostamble(site, fields, numFields);
+	}
+}
+
+GABE_CPP_UTILS_API void _g_logger_assertGabePreamble(const char* filename, int line);
+GABE_CPP_UTILS_API void _g_logger_assertGabePostamble(const char* filename, int line);
+
+// Only goes to the flight recorder
+template<typename...Args>
+void _g_logger_gabeDebug(g_logger_site* site, const char* format, const Args&... args)
+{
+	if (_g_logger_isFlightRecording())
+	{
+		if (site->id == 0)
+		{
+			_g_logger_registerSite(site, format, (uint8)sizeof...(Args), nullptr, nullptr);
+		}
+		_g_logger_recordFlight(site->filename, site->line, g_logger_level_All, format, args...);
+	}
+}
+
+template<typename...Args>
+GABE_CPP_UTILS_API void _g_logger_gabeAssert(const char* filename, int line, bool condition, const char* format, Args... args)
+{
+	if (g_logger_get_level() <= g_logger_level_Assert)
+	{
+		if (!condition)
+		{
+			_g_logger_assertGabePreamble(filename, line);
+			CppUtils::IO::printf(format, args...);
+			_g_logger_assertGabePostamble(filename, line);
+		}
+	}
+}
+
+// Cold and out of line, so a passing check is just the branch
+template<typename...Args>
+_g_logger_cold void _g_logger_gabeCheckFailed(g_logger_site* site, const char* condition, const char* format, const Args&... args)
+{
+	if (site->id == 0)
+	{
+		_g_logger_registerSite(site, format, (uint8)sizeof...(Args), nullptr, nullptr);
+	}
+
+	if (_g_logger_checkFirstFailure(site))
+	{
+		_g_logger_printPreamble(site);
+		CppUtils::IO::printf("Check '{}' failed: ", condition);
+		CppUtils::IO::printf(format, args...);
+		_g_logger_printPostamble(site, nullptr, 0);
+		// The record is gone once the postamble returns, so the callback gets the format string
+		_g_logger_checkReport(site, condition, format);
+	}
+
+	_g_logger_checkAbortIfNeeded();
+}
+
+#define _g_logger_gabeSitePrint(level, format, ...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(level); _g_logger_gabeCommonPrint(&_g_logger_site, format VA_ARGS(__VA_ARGS__)); } while (0)
+
+#define g_logger_log(format, ...) _g_logger_gabeSitePrint(g_logger_level_Log, format VA_ARGS(__VA_ARGS__))
+#define g_logger_info(format, ...) _g_logger_gabeSitePrint(g_logger_level_Info, format VA_ARGS(__VA_ARGS__))
+#define g_logger_warning(format, ...) _g_logger_gabeSitePrint(g_logger_level_Warning, format VA_ARGS(__VA_ARGS__))
+#define g_logger_error(format, ...) _g_logger_gabeSitePrint(g_logger_level_Error, format VA_ARGS(__VA_ARGS__))
+#define g_logger_assert(condition, format, ...) _g_logger_gabeAssert(__FILE__, __LINE__, condition, format, __VA_ARGS__)
+#define g_logger_debug(format, ...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(g_logger_level_All); _g_logger_gabeDebug(&_g_logger_site, format VA_ARGS(__VA_ARGS__)); } while (0)
+
+#define _g_logger_gabeSiteKvPrint(level, fields, numFields, format, ...) do { static g_logger_site _g_logger_site = _g_logger_siteInit(level); _g_logger_gabeKvPrint(&_g_logger_site, fields, numFields, format VA_ARGS(__VA_ARGS__)); } while (0)
+
+#define g_logger_log_kv(fields, numFields, format, ...) _g_logger_gabeSiteKvPrint(g_logger_level_Log, fields, numFields, format VA_ARGS(__VA_ARGS__))
+#define g_logger_info_kv(fields, numFields, format, ...) _g_logger_gabeSiteKvPrint(g_logger_level_Info, fields, numFields, format VA_ARGS(__VA_ARGS__))
+#define g_logger_warning_kv(fields, numFields, format, ...) _g_logger_gabeSiteKvPrint(g_logger_level_Warning, fields, numFields, format VA_ARGS(__VA_ARGS__))
+#define g_logger_error_kv(fields, numFields, format, ...) _g_logger_gabeSiteKvPrint(g_logger_level_Error, fields, numFields, format VA_ARGS(__VA_ARGS__))
+
+#define _g_logger_gabeChannelPrint(channelName, level, format, ...) do { static g_logger_site _g_logger_site = _g_logger_channelSiteInit(channelName, level); _g_logger_gabeCommonPrint(&_g_logger_site, format VA_ARGS(__VA_ARGS__)); } while (0)
+
+#define g_logger_channel_log(channelName, format, ...) _g_logger_gabeChannelPrint(channelName, g_logger_level_Log, format VA_ARGS(__VA_ARGS__))
+#define g_logger_channel_info(channelName, format, ...) _g_logger_gabeChannelPrint(channelName, g_logger_level_Info, format VA_ARGS(__VA_ARGS__))
+#define g_logger_channel_warning(channelName, format, ...) _g_logger_gabeChannelPrint(channelName, g_logger_level_Warning, format VA_ARGS(__VA_ARGS__))
+#define g_logger_channel_error(channelName, format, ...) _g_logger_gabeChannelPrint(channelName, g_logger_level_Error, format VA_ARGS(__VA_ARGS__))
+
+#define g_logger_check(condition, format, ...) do { if (_g_logger_unlikely(!(condition))) { static g_logger_site _g_logger_site = _g_logger_siteInit(g_logger_level_Error); _g_logger_gabeCheckFailed(&_g_logger_site, #condition, format VA_ARGS(__VA_ARGS__)); } } while (0)
+#define g_logger_verify(condition, format, ...) g_logger_check(condition, format VA_ARGS(__VA_ARGS__))
+
+#endif // _WIN32
+#endif // USE_GABE_CPP_PRINT
+
+// Compile time level filter. Anything below GABE_LOGGER_MIN_LEVEL expands to nothing, arguments and all.
+// These have to be plain numbers for the preprocessor, they match the g_logger_level values.
+#ifndef GABE_LOGGER_MIN_LEVEL
+#define GABE_LOGGER_MIN_LEVEL 0
+#endif
+
+#if GABE_LOGGER_MIN_LEVEL > 0 // Debug, which only goes to the flight recorder
+#undef g_logger_debug
+#define g_logger_debug(format, ...) ((void)0)
+#endif
+
+#if GABE_LOGGER_MIN_LEVEL > 1 // g_logger_level_Log
+#undef g_logger_log
+#undef g_logger_log_kv
+#define g_logger_log(format, ...) ((void)0)
+#define g_logger_log_kv(fields, numFields, format, ...) ((void)0)
+#undef g_logger_channel_log
+#define g_logger_channel_log(channelName, format, ...) ((void)0)
+#endif
+
+#if GABE_LOGGER_MIN_LEVEL > 2 // g_logger_level_Info
+#undef g_logger_info
+#undef g_logger_info_kv
+#define g_logger_info(format, ...) ((void)0)
+#define g_logger_info_kv(fields, numFields, format, ...) ((void)0)
+#undef g_logger_channel_info
+#define g_logger_channel_info(channelName, format, ...) ((void)0)
+#endif
+
+#if GABE_LOGGER_MIN_LEVEL > 3 // g_logger_level_Warning
+#undef g_logger_warning
+#undef g_logger_warning_kv
+#define g_logger_warning(format, ...) ((void)0)
+#define g_logger_warning_kv(fields, numFields, format, ...) ((void)0)
+#undef g_logger_channel_warning
+#define g_logger_channel_warning(channelName, format, ...) ((void)0)
+#endif
+
+#if GABE_LOGGER_MIN_LEVEL > 4 // g_logger_level_Error
+#undef g_logger_error
+#undef g_logger_error_kv
+#define g_logger_error(format, ...) ((void)0)
+#define g_logger_error_kv(fields, numFields, format, ...) ((void)0)
+#undef g_logger_channel_error
+#define g_logger_channel_error(channelName, format, ...) ((void)0)
+#endif
+
+// Compiles every g_logger_check out, condition included. g_logger_verify still evaluates its condition
+// (so side effects in it stay), it just never reports anything.
+#ifdef GABE_LOGGER_DISABLE_CHECKS
+#undef g_logger_check
+#undef g_logger_verify
+#define g_logger_check(condition, format, ...) ((void)0)
+#define g_logger_verify(condition, format, ...) ((void)(condition))
+#endif
+
+#ifdef __cplusplus
+
+void* operator new(size_t size, const char* filename, int line);
+void operator delete(void* memory, const char* filename, int line);
+
+template<typename T>
+void _g_memory_delete(T* memory, const char* filename, int line)
+{
+	if (memory)
+	{
+		memory->~T();
+		_g_memory_free(filename, line, memory);
+	}
+}
+
+#define g_memory_new new(__FILE__, __LINE__)
+#define g_memory_delete(memory) _g_memory_delete(memory, __FILE__, __LINE__)
+
+#endif // __cplusplus
+
+#endif // GABE_CPP_UTILS_H
 
 
 
@@ -400,10 +1603,10 @@ void* operator new(size_t size, const char* filename, int line)
 	return ptr;
 }
 
-void operator delete(void* memory, const char*, int)
+void operator delete(void* memory, const char* filename, int line)
 {
 	g_logger_error("Exception thrown in new operator.");
-	return delete memory;
+	_g_memory_free(filename, line, memory);
 }
 
 #endif 
@@ -426,8 +1629,114 @@ void operator delete(void* memory, const char*, int)
 #endif 
 
 // Forward declarations
-static void* g_thread_createMutexUntracked(void);
-static void g_thread_freeMutexUntracked(void* mutex);
+typedef void (*gcu_ThreadFn)(void* userData);
+static void* gcu_thread_start(gcu_ThreadFn fn, void* userData);
+static void gcu_thread_join(void* thread);
+static void gcu_thread_yield(void);
+static void gcu_thread_sleepMs(uint32 milliseconds);
+static uint64 gcu_thread_id(void);
+// Sleeps until somebody wakes the address up, as long as it still holds expected. Can wake up for no
+// reason, so always check the value again afterwards.
+static void gcu_thread_waitOnAddress(volatile uint32* address, uint32 expected);
+static void gcu_thread_wakeOneOnAddress(volatile uint32* address);
+static void gcu_thread_wakeAllOnAddress(volatile uint32* address);
+
+// ----------------------------------
+// Internal atomics
+// ----------------------------------
+// This file has to compile as C11 and C++ on MSVC, which rules out both <stdatomic.h> and <atomic>,
+// so these wrap the compiler intrinsics directly. Loads are acquire and stores are release.
+#ifdef _WIN32
+#include <intrin.h>
+
+// A volatile access on its own only orders anything on x86, and ARM64 builds default to
+// /volatile:iso where it doesn't even do that. So the loads and stores go through __iso_volatile_*
+// and get a real barrier on ARM64, which is what MSVC's own std::atomic does.
+#if defined(_M_ARM64)
+static inline void gcu_atomic_orderingBarrier(void) { __dmb(_ARM64_BARRIER_ISH); }
+#else
+// x86 never reorders loads with loads or stores with stores, so only the compiler needs stopping
+static inline void gcu_atomic_orderingBarrier(void) { _ReadWriteBarrier(); }
+#endif
+
+static inline uint32 gcu_atomic_loadU32(const volatile uint32* ptr) { uint32 res = (uint32)__iso_volatile_load32((const volatile __int32*)ptr); gcu_atomic_orderingBarrier(); return res; }
+static inline void gcu_atomic_storeU32(volatile uint32* ptr, uint32 value) { gcu_atomic_orderingBarrier(); __iso_volatile_store32((volatile __int32*)ptr, (__int32)value); }
+static inline uint32 gcu_atomic_addU32(volatile uint32* ptr, uint32 value) { return (uint32)_InterlockedExchangeAdd((volatile long*)ptr, (long)value); }
+static inline uint32 gcu_atomic_exchangeU32(volatile uint32* ptr, uint32 value) { return (uint32)_InterlockedExchange((volatile long*)ptr, (long)value); }
+static inline bool gcu_atomic_casU32(volatile uint32* ptr, uint32* expected, uint32 desired)
+{
+	uint32 prev = (uint32)_InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)*expected);
+	if (prev == *expected) return true;
+	*expected = prev;
+	return false;
+}
+
+#if defined(_M_IX86)
+// 32 bit x86 can't load or store 64 bits in one plain instruction, the compare exchange is the only
+// way to do it atomically
+static inline uint64 gcu_atomic_loadU64(const volatile uint64* ptr) { return (uint64)_InterlockedCompareExchange64((volatile long long*)ptr, 0, 0); }
+static inline void gcu_atomic_storeU64(volatile uint64* ptr, uint64 value)
+{
+	// The first guess can be torn, the compare exchange just fails and hands back the real value
+	long long expected = (long long)*ptr;
+	long long prev;
+	while ((prev = _InterlockedCompareExchange64((volatile long long*)ptr, (long long)value, expected)) != expected)
+	{
+		expected = prev;
+	}
+}
+#else
+static inline uint64 gcu_atomic_loadU64(const volatile uint64* ptr) { uint64 res = (uint64)__iso_volatile_load64((const volatile __int64*)ptr); gcu_atomic_orderingBarrier(); return res; }
+static inline void gcu_atomic_storeU64(volatile uint64* ptr, uint64 value) { gcu_atomic_orderingBarrier(); __iso_volatile_store64((volatile __int64*)ptr, (__int64)value); }
+#endif
+static inline uint64 gcu_atomic_addU64(volatile uint64* ptr, uint64 value) { return (uint64)_InterlockedExchangeAdd64((volatile long long*)ptr, (long long)value); }
+static inline uint64 gcu_atomic_addU64Relaxed(volatile uint64* ptr, uint64 value) { return (uint64)_InterlockedExchangeAdd64((volatile long long*)ptr, (long long)value); }
+static inline bool gcu_atomic_casU64(volatile uint64* ptr, uint64* expected, uint64 desired)
+{
+	uint64 prev = (uint64)_InterlockedCompareExchange64((volatile long long*)ptr, (long long)desired, (long long)*expected);
+	if (prev == *expected) return true;
+	*expected = prev;
+	return false;
+}
+
+static inline void gcu_atomic_pause(void) { YieldProcessor(); }
+static inline void gcu_atomic_fence(void) { MemoryBarrier(); }
+#else
+static inline uint32 gcu_atomic_loadU32(const volatile uint32* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void gcu_atomic_storeU32(volatile uint32* ptr, uint32 value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+static inline uint32 gcu_atomic_addU32(volatile uint32* ptr, uint32 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL); }
+static inline uint32 gcu_atomic_exchangeU32(volatile uint32* ptr, uint32 value) { return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL); }
+static inline bool gcu_atomic_casU32(volatile uint32* ptr, uint32* expected, uint32 desired)
+{
+	return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline uint64 gcu_atomic_loadU64(const volatile uint64* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void gcu_atomic_storeU64(volatile uint64* ptr, uint64 value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+static inline uint64 gcu_atomic_addU64(volatile uint64* ptr, uint64 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL); }
+static inline uint64 gcu_atomic_addU64Relaxed(volatile uint64* ptr, uint64 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_RELAXED); }
+static inline bool gcu_atomic_casU64(volatile uint64* ptr, uint64* expected, uint64 desired)
+{
+	return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline void gcu_atomic_pause(void) { __builtin_ia32_pause(); }
+#elif defined(__aarch64__)
+static inline void gcu_atomic_pause(void) { __asm__ __volatile__("yield"); }
+#else
+static inline void gcu_atomic_pause(void) { }
+#endif
+static inline void gcu_atomic_fence(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#endif
+
+#if defined(__cplusplus)
+#define GCU_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define GCU_THREAD_LOCAL __declspec(thread)
+#else
+#define GCU_THREAD_LOCAL _Thread_local
+#endif
 
 // ----------------------------------
 // C Memory Implementation
@@ -468,17 +1777,24 @@ static gma_DebugMemoryAllocation* gma_DebugMemoryAllocation_find(gma_DebugMemory
 
 static void gma_DebugMemoryAllocation_push(gma_DebugMemoryAllocationList* list, const gma_DebugMemoryAllocation* element)
 {
-	// TODO: Do heavy testing here to make sure this is rock-solid
 	if (list->length + 1 > list->maxCapacity)
 	{
-		// Grow our list
-		list->maxCapacity *= 2;
-		gma_DebugMemoryAllocation* newPtr = (gma_DebugMemoryAllocation*)realloc(list->data, sizeof(gma_DebugMemoryAllocation) * list->maxCapacity);
-		g_logger_assert(list->data != NULL, "Realloc failed, out of memory.");
+		// Grow our list. No realloc, g_memory_writeCrashReport can be reading the old block from a signal
+		// handler without the lock, so it never gets freed. The list doubles every time, so all of the old
+		// blocks together are never bigger than the current one.
+		size_t newCapacity = list->maxCapacity * 2;
+		gma_DebugMemoryAllocation* newPtr = (gma_DebugMemoryAllocation*)malloc(sizeof(gma_DebugMemoryAllocation) * newCapacity);
+		g_logger_assert(newPtr != NULL, "Malloc failed, out of memory.");
+		memcpy(newPtr, list->data, sizeof(gma_DebugMemoryAllocation) * list->length);
+		// The copy has to be done before the crash report can see the new block
+		gcu_atomic_fence();
 		list->data = newPtr;
+		list->maxCapacity = newCapacity;
 	}
 
 	list->data[list->length] = *element;
+	// Same for the element before the crash report can count it
+	gcu_atomic_fence();
 	list->length += 1;
 }
 
@@ -489,7 +1805,7 @@ static void gma_DebugMemoryAllocationList_init(gma_DebugMemoryAllocationList* li
 	list->data = (gma_DebugMemoryAllocation*)malloc(sizeof(gma_DebugMemoryAllocation) * list->maxCapacity);
 }
 
-static void* memoryMtx = NULL;
+static g_thread_mutex memoryMtx = G_THREAD_MUTEX_INIT;
 static gma_DebugMemoryAllocationList allocations;
 static bool trackMemoryAllocations = false;
 static bool zeroMemoryOnAllocate = false;
@@ -498,6 +1814,37 @@ static uint16 bufferPadding = 5;
 #define I_HAT 238
 static uint8* cleanPaddingBytes = NULL;
 
+// Ring buffer of the most recent heap corruption findings. This is fixed size so that
+// the crash handler can read it without allocating or locking.
+typedef enum gma_CorruptionKind
+{
+	gma_CorruptionKind_BufferUnderrun = 0,
+	gma_CorruptionKind_BufferOverrun = 1,
+	gma_CorruptionKind_DoubleFree = 2,
+	gma_CorruptionKind_InvalidFree = 3,
+} gma_CorruptionKind;
+
+typedef struct gma_CorruptionRecord
+{
+	const char* fileAllocator;
+	int fileAllocatorLine;
+	gma_CorruptionKind kind;
+} gma_CorruptionRecord;
+
+#define gma_maxCorruptionRecords 32
+static gma_CorruptionRecord corruptionRecords[gma_maxCorruptionRecords];
+static volatile size_t numCorruptionRecords = 0;
+
+// NOTE: Always called with memoryMtx held
+static void gma_CorruptionRecord_push(gma_CorruptionKind kind, const char* fileAllocator, int fileAllocatorLine)
+{
+	gma_CorruptionRecord* record = corruptionRecords + (numCorruptionRecords % gma_maxCorruptionRecords);
+	record->fileAllocator = fileAllocator;
+	record->fileAllocatorLine = fileAllocatorLine;
+	record->kind = kind;
+	numCorruptionRecords = numCorruptionRecords + 1;
+}
+
 void g_memory_init(bool detectMemoryErrors)
 {
 	g_memory_init_padding(detectMemoryErrors, 0);
@@ -505,7 +1852,7 @@ void g_memory_init(bool detectMemoryErrors)
 
 void g_memory_init_padding(bool detectMemoryErrors, uint16 inBufferPadding)
 {
-	g_memory_init_padding_zeroed(detectMemoryErrors, inBufferPadding, FALSE);
+	g_memory_init_padding_zeroed(detectMemoryErrors, inBufferPadding, false);
 }
 
 void g_memory_init_padding_zeroed(bool detectMemoryErrors, uint16 inBufferPadding, bool inZeroMemoryOnAllocate)
@@ -513,7 +1860,6 @@ void g_memory_init_padding_zeroed(bool detectMemoryErrors, uint16 inBufferPaddin
 	trackMemoryAllocations = detectMemoryErrors;
 	bufferPadding = inBufferPadding;
 	gma_DebugMemoryAllocationList_init(&allocations);
-	memoryMtx = g_thread_createMutexUntracked();
 	zeroMemoryOnAllocate = inZeroMemoryOnAllocate;
 
 	cleanPaddingBytes = (uint8*)malloc(inBufferPadding);
@@ -526,11 +1872,6 @@ void g_memory_init_padding_zeroed(bool detectMemoryErrors, uint16 inBufferPaddin
 
 void g_memory_deinit(void)
 {
-	if (memoryMtx)
-	{
-		g_thread_freeMutexUntracked(memoryMtx);
-	}
-
 	free(cleanPaddingBytes);
 }
 
@@ -581,7 +1922,7 @@ void* _g_memory_allocate(const char* filename, int line, size_t numBytes)
 			setMemoryPaddingPost((uint8*)memory, numBytes);
 		}
 
-		g_thread_lockMutex(memoryMtx);
+		g_thread_mutexLock(&memoryMtx);
 		// If we are in a debug build, track all memory allocations to see if we free them all as well
 		gma_DebugMemoryAllocation tmp = {
 			filename,
@@ -611,7 +1952,7 @@ void* _g_memory_allocate(const char* filename, int line, size_t numBytes)
 			}
 		}
 
-		g_thread_releaseMutex(memoryMtx);
+		g_thread_mutexUnlock(&memoryMtx);
 		return (void*)((uint8*)memory + bufferPadding);
 	}
 
@@ -642,7 +1983,7 @@ void* _g_memory_realloc(const char* filename, int line, void* oldMemory, size_t
 			return NULL;
 		}
 
-		g_thread_lockMutex(memoryMtx);
+		g_thread_mutexLock(&memoryMtx);
 
 		oldMemory = (void*)((uint8*)oldMemory - bufferPadding);
 		gma_DebugMemoryAllocation tmp = {
@@ -716,7 +2057,7 @@ void* _g_memory_realloc(const char* filename, int line, void* oldMemory, size_t
 			}
 		}
 
-		g_thread_releaseMutex(memoryMtx);
+		g_thread_mutexUnlock(&memoryMtx);
 
 		// If realloc expanded the memory in-place, then we don't need to do anything because no "new" memory locations were allocated
 		// and no "new" memory references were created
@@ -739,7 +2080,7 @@ void _g_memory_free(const char* filename, int line, void* memory)
 	{
 		memory = (void*)((uint8*)memory - bufferPadding);
 
-		g_thread_lockMutex(memoryMtx);
+		g_thread_mutexLock(&memoryMtx);
 
 		gma_DebugMemoryAllocation tmp = {
 			filename,
@@ -751,6 +2092,7 @@ void _g_memory_free(const char* filename, int line, void* memory)
 		gma_DebugMemoryAllocation* iterator = gma_DebugMemoryAllocation_find(&allocations, &tmp);
 		if (iterator == NULL)
 		{
+			gma_CorruptionRecord_push(gma_CorruptionKind_InvalidFree, filename, line);
 #ifndef USE_GABE_CPP_PRINT
 			g_logger_error("Tried to free invalid memory that was never allocated at '%s' line: %d", filename, line);
 #else
@@ -759,6 +2101,7 @@ void _g_memory_free(const char* filename, int line, void* memory)
 	}
 		else if (iterator->references <= 0)
 		{
+			gma_CorruptionRecord_push(gma_CorruptionKind_DoubleFree, iterator->fileAllocator, iterator->fileAllocatorLine);
 #ifndef USE_GABE_CPP_PRINT
 			g_logger_error("Tried to free memory that has already been freed.");
 			g_logger_error("Code that attempted to free: '%s' line: %d", filename, line);
@@ -781,6 +2124,7 @@ void _g_memory_free(const char* filename, int line, void* memory)
 				{
 					if (memoryBytes[i] != I_HAT)
 					{
+						gma_CorruptionRecord_push(gma_CorruptionKind_BufferUnderrun, iterator->fileAllocator, iterator->fileAllocatorLine);
 #ifndef USE_GABE_CPP_PRINT
 						g_logger_warning("Heap corruption detected. Buffer underrun in memory allocated from: '%s' line: %d", iterator->fileAllocator, iterator->fileAllocatorLine);
 #else 
@@ -795,6 +2139,7 @@ void _g_memory_free(const char* filename, int line, void* memory)
 				{
 					if (memoryBytes[i] != I_HAT)
 					{
+						gma_CorruptionRecord_push(gma_CorruptionKind_BufferOverrun, iterator->fileAllocator, iterator->fileAllocatorLine);
 #ifndef USE_GABE_CPP_PRINT
 						g_logger_warning("Heap corruption detected. Buffer overrun in memory allocated from: '%s' line: %d", iterator->fileAllocator, iterator->fileAllocatorLine);
 #else 
@@ -806,7 +2151,7 @@ void _g_memory_free(const char* filename, int line, void* memory)
 			}
 		}
 
-		g_thread_releaseMutex(memoryMtx);
+		g_thread_mutexUnlock(&memoryMtx);
 	}
 
 	// When debug is turned off we literally just free the memory, so it will throw a segfault if a
@@ -814,9 +2159,32 @@ void _g_memory_free(const char* filename, int line, void* memory)
 	free(memory);
 }
 
+void* _g_memory_allocateAligned(const char* filename, int line, size_t numBytes, size_t alignment)
+{
+	// Buffer padding throws off whatever alignment malloc gave us, so allocate enough to line it up
+	// ourselves and stash the real block right in front of the aligned one
+	uint8* raw = (uint8*)_g_memory_allocate(filename, line, numBytes + alignment + sizeof(void*));
+	if (raw == NULL)
+	{
+		return NULL;
+	}
+
+	uintptr_t aligned = ((uintptr_t)raw + sizeof(void*) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	((void**)aligned)[-1] = raw;
+	return (void*)aligned;
+}
+
+void _g_memory_freeAligned(const char* filename, int line, void* memory)
+{
+	if (memory != NULL)
+	{
+		_g_memory_free(filename, line, ((void**)memory)[-1]);
+	}
+}
+
 void g_memory_dumpMemoryLeaks(void)
 {
-	g_thread_lockMutex(memoryMtx);
+	g_thread_mutexLock(&memoryMtx);
 
 	for (size_t i = 0; i < allocations.length; i++)
 	{
@@ -831,12 +2199,12 @@ void g_memory_dumpMemoryLeaks(void)
 	}
 }
 
-	g_thread_releaseMutex(memoryMtx);
+	g_thread_mutexUnlock(&memoryMtx);
 }
 
 bool g_memory_compareMem(void* a, size_t aLength, void* b, size_t bLength)
 {
-	if (aLength != bLength) return FALSE;
+	if (aLength != bLength) return false;
 	return (memcmp(a, b, bLength) == 0);
 }
 
@@ -855,100 +2223,5167 @@ void g_memory_copyMem(void* dst, size_t dstNumBytes, void* src, size_t srcNumByt
 	memcpy(dst, src, srcNumBytes);
 }
 
-
 // ----------------------------------
-// Logging Implementation Common C11
+// Crash Report Implementation
 // ----------------------------------
+// Everything reachable from the signal handler has to stay async-signal-safe. That means
+// no locks, no allocations and no stdio, just write(2) on a stack buffer.
+#ifdef _WIN32
+#include <io.h>
+#include <signal.h>
+#else
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
 
-// Initialize these variables just in case init isn't called for some reason
-static g_logger_level log_level = g_logger_level_All;
+static volatile int crashReportFd = -1;
 
-// If this is not nullptr, logging to file is enabled
-static FILE* logFile = NULL;
-static char* logFilePath = NULL;
-static void* logMutex = NULL;
+// Lives with the logger. Dumps the log flight recorder, if it's on, next to the crash report.
+static void glog_dumpFlightRecorder(void);
 
-void g_logger_set_level(g_logger_level level)
+typedef struct gma_CrashLine
 {
-	log_level = level;
-}
+	char data[512];
+	size_t length;
+} gma_CrashLine;
 
-g_logger_level g_logger_get_level(void)
+// Also used by the logger, which hands every sink a whole record at once
+static void gcu_writeAll(int fd, const char* buffer, size_t numBytes)
 {
-	return log_level;
-}
+	while (numBytes > 0)
+	{
+#ifdef _WIN32
+		int written = _write(fd, buffer, (unsigned int)numBytes);
+#else
+		ssize_t written = write(fd, buffer, numBytes);
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+#endif
+		if (written <= 0)
+		{
+			return;
+		}
 
-void g_logger_init(void)
-{
-	logFile = NULL;
-	logFilePath = NULL;
-	log_level = g_logger_level_All;
-	logMutex = g_thread_createMutexUntracked();
+		buffer += written;
+		numBytes -= (size_t)written;
+	}
 }
 
-void g_logger_free(void)
+static void gma_CrashLine_appendStr(gma_CrashLine* line, const char* str)
 {
-	if (logFile)
+	if (str == NULL)
 	{
-		fclose(logFile);
-		logFile = NULL;
+		str = "(null)";
 	}
 
-	if (logFilePath)
+	while (*str && line->length < sizeof(line->data))
 	{
-		free(logFilePath);
-		logFilePath = NULL;
+		line->data[line->length++] = *str++;
 	}
+}
+
+static void gma_CrashLine_appendUint(gma_CrashLine* line, uint64 value)
+{
+	char digits[20];
+	size_t numDigits = 0;
+	do
+	{
+		digits[numDigits++] = (char)('0' + (value % 10));
+		value /= 10;
+	} while (value > 0);
 
-	if (logMutex)
+	while (numDigits > 0 && line->length < sizeof(line->data))
 	{
-		g_thread_freeMutexUntracked(logMutex);
-		logMutex = NULL;
+		line->data[line->length++] = digits[--numDigits];
 	}
 }
 
-void g_logger_set_log_directory(const char* directory)
+static void gma_CrashLine_appendPtr(gma_CrashLine* line, const void* ptr)
 {
-	// TODO: Better error checking
-	// Max path on windows, should be large enough for linux, if not we should error out here
-#define maxPath 261
-	char timebuf[maxPath] = { 0 };
-
-	time_t now;
-	time(&now);
-	struct tm localTime;
-	localtime_s(&localTime, &now);
-	strftime(timebuf, sizeof(timebuf), "/log_%Y-%m-%d_%I_%M_%S.txt", &localTime);
+	const char* hexDigits = "0123456789ABCDEF";
+	uint64 value = (uint64)(uintptr_t)ptr;
+	gma_CrashLine_appendStr(line, "0x");
+	for (int shift = (int)(sizeof(uintptr_t) * 8) - 4; shift >= 0; shift -= 4)
+	{
+		if (line->length < sizeof(line->data))
+		{
+			line->data[line->length++] = hexDigits[(value >> shift) & 0xF];
+		}
+	}
+}
 
-	size_t filenameLength = strlen(timebuf);
-	size_t dirStringLength = strlen(directory);
-	// Minus 1 here for the null character
-	if (dirStringLength >= (maxPath - filenameLength - 1))
+static void gma_CrashLine_appendChar(gma_CrashLine* line, char c)
+{
+	if (line->length < sizeof(line->data))
 	{
-		printf("Directory name to long. Max length 260 gets exceeded with log filename. Not setting log directory to: %s\n", directory);
-		return;
+		line->data[line->length++] = c;
 	}
-	// +1 for null byte
-	logFilePath = (char*)malloc(sizeof(char) * (filenameLength + dirStringLength + 1));
-	if (!logFilePath)
+}
+
+static void gma_CrashLine_appendInt(gma_CrashLine* line, int64 value)
+{
+	if (value < 0)
 	{
-		printf("Failed to allocate memory for the log file path. Out of memory. Returning early.");
+		gma_CrashLine_appendChar(line, '-');
+		// Negate in unsigned so INT64_MIN doesn't overflow
+		gma_CrashLine_appendUint(line, (uint64)0 - (uint64)value);
 		return;
 	}
 
-	memcpy(logFilePath, directory, sizeof(char) * dirStringLength);
-	memcpy(logFilePath + (sizeof(char) * dirStringLength), timebuf, sizeof(char) * filenameLength);
-	logFilePath[dirStringLength + filenameLength] = '\0';
+	gma_CrashLine_appendUint(line, (uint64)value);
+}
+
+static void gma_CrashLine_appendBase(gma_CrashLine* line, uint64 value, uint32 base, bool upperCase)
+{
+	const char* digitChars = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+	char digits[64];
+	size_t numDigits = 0;
+	do
+	{
+		digits[numDigits++] = digitChars[value % base];
+		value /= base;
+	} while (value > 0);
+
+	while (numDigits > 0)
+	{
+		gma_CrashLine_appendChar(line, digits[--numDigits]);
+	}
+}
+
+// Appends numDigits digits of fraction, which has to be in [0, 1)
+static void gma_CrashLine_appendFraction(gma_CrashLine* line, double fraction, int numDigits)
+{
+	for (int i = 0; i < numDigits; i++)
+	{
+		fraction *= 10.0;
+		int digit = (int)fraction;
+		digit = digit > 9 ? 9 : digit;
+		gma_CrashLine_appendChar(line, (char)('0' + digit));
+		fraction -= digit;
+	}
+}
+
+// A small printf("%f"/"%e"/"%g") stand-in. snprintf isn't async-signal-safe, so crash reports can't use
+// it. It's only accurate to about 15 significant digits, which is plenty for a crash report.
+static void gma_CrashLine_appendDouble(gma_CrashLine* line, double value, int precision, char style)
+{
+	if (value != value)
+	{
+		gma_CrashLine_appendStr(line, "nan");
+		return;
+	}
+	if (value < 0)
+	{
+		gma_CrashLine_appendChar(line, '-');
+		value = -value;
+	}
+	if (value > 1.7976931348623157e308)
+	{
+		gma_CrashLine_appendStr(line, "inf");
+		return;
+	}
+
+	precision = precision < 0 ? 6 : (precision > 17 ? 17 : precision);
+	bool trimZeros = false;
+	if (style == 'g' || style == 'G')
+	{
+		style = (value == 0.0 || (value >= 1e-4 && value < 1e15)) ? 'f' : 'e';
+		trimZeros = true;
+	}
+
+	// Past this the integer part doesn't fit in a uint64
+	if ((style == 'f' || style == 'F') && value < 1.8e19)
+	{
+		double rounding = 0.5;
+		for (int i = 0; i < precision; i++)
+		{
+			rounding /= 10.0;
+		}
+		value += rounding;
+
+		uint64 integerPart = (uint64)value;
+		gma_CrashLine_appendUint(line, integerPart);
+		if (precision > 0)
+		{
+			gma_CrashLine_appendChar(line, '.');
+			size_t fractionStart = line->length;
+			gma_CrashLine_appendFraction(line, value - (double)integerPart, precision);
+			if (trimZeros)
+			{
+				while (line->length > fractionStart && line->data[line->length - 1] == '0')
+				{
+					line->length--;
+				}
+				if (line->length == fractionStart)
+				{
+					line->length--;
+				}
+			}
+		}
+		return;
+	}
+
+	int exponent = 0;
+	while (value >= 10.0)
+	{
+		value /= 10.0;
+		exponent++;
+	}
+	while (value != 0.0 && value < 1.0)
+	{
+		value *= 10.0;
+		exponent--;
+	}
+
+	double rounding = 0.5;
+	for (int i = 0; i < precision; i++)
+	{
+		rounding /= 10.0;
+	}
+	value += rounding;
+	if (value >= 10.0)
+	{
+		value /= 10.0;
+		exponent++;
+	}
+
+	int integerPart = (int)value;
+	gma_CrashLine_appendChar(line, (char)('0' + integerPart));
+	if (precision > 0)
+	{
+		gma_CrashLine_appendChar(line, '.');
+		gma_CrashLine_appendFraction(line, value - integerPart, precision);
+	}
+	gma_CrashLine_appendChar(line, style == 'E' ? 'E' : 'e');
+	gma_CrashLine_appendChar(line, exponent < 0 ? '-' : '+');
+	if (exponent < 0)
+	{
+		exponent = -exponent;
+	}
+	if (exponent < 10)
+	{
+		gma_CrashLine_appendChar(line, '0');
+	}
+	gma_CrashLine_appendUint(line, (uint64)exponent);
+}
+
+static void gma_CrashLine_flush(gma_CrashLine* line, int fd)
+{
+	gcu_writeAll(fd, line->data, line->length);
+	line->length = 0;
+}
+
+static const char* gma_CorruptionKind_toString(gma_CorruptionKind kind)
+{
+	switch (kind)
+	{
+	case gma_CorruptionKind_BufferUnderrun: return "Buffer underrun in memory allocated from";
+	case gma_CorruptionKind_BufferOverrun: return "Buffer overrun in memory allocated from";
+	case gma_CorruptionKind_DoubleFree: return "Double free of memory allocated from";
+	case gma_CorruptionKind_InvalidFree: return "Free of untracked memory at";
+	}
+
+	return "Unknown corruption in memory allocated from";
+}
+
+void g_memory_writeCrashReport(int fd)
+{
+	if (fd < 0)
+	{
+		return;
+	}
+
+	gma_CrashLine line;
+	line.length = 0;
+
+	gma_CrashLine_appendStr(&line, "==== g_memory crash report ====\n");
+	if (!trackMemoryAllocations)
+	{
+		gma_CrashLine_appendStr(&line, "Memory tracking is disabled, no allocations were recorded.\n");
+	}
+	gma_CrashLine_flush(&line, fd);
+
+	// Snapshot the table once. We can't take memoryMtx here, but growing the table never frees the old
+	// block and length only goes up once its entry is written. So with length read first, every entry
+	// we walk is there in whichever block we get.
+	size_t length = allocations.length;
+	gcu_atomic_fence();
+	const gma_DebugMemoryAllocation* data = allocations.data;
+	size_t numLiveAllocations = 0;
+	uint64 numLiveBytes = 0;
+	for (size_t i = 0; data != NULL && i < length; i++)
+	{
+		const gma_DebugMemoryAllocation* alloc = data + i;
+		if (alloc->references <= 0)
+		{
+			continue;
+		}
+
+		uint64 numBytes = (uint64)(alloc->memorySize - (bufferPadding * 2));
+		numLiveAllocations++;
+		numLiveBytes += numBytes;
+
+		gma_CrashLine_appendStr(&line, "Live allocation of '");
+		gma_CrashLine_appendUint(&line, numBytes);
+		gma_CrashLine_appendStr(&line, "' bytes at ");
+		gma_CrashLine_appendPtr(&line, (const uint8*)alloc->memory + bufferPadding);
+		gma_CrashLine_appendStr(&line, " allocated from: '");
+		gma_CrashLine_appendStr(&line, alloc->fileAllocator);
+		gma_CrashLine_appendStr(&line, "' line: ");
+		gma_CrashLine_appendUint(&line, (uint64)alloc->fileAllocatorLine);
+		gma_CrashLine_appendStr(&line, "\n");
+		gma_CrashLine_flush(&line, fd);
+	}
+
+	gma_CrashLine_appendStr(&line, "Live allocations: ");
+	gma_CrashLine_appendUint(&line, (uint64)numLiveAllocations);
+	gma_CrashLine_appendStr(&line, " (");
+	gma_CrashLine_appendUint(&line, numLiveBytes);
+	gma_CrashLine_appendStr(&line, " bytes)\n");
+	gma_CrashLine_flush(&line, fd);
+
+	size_t totalCorruptionRecords = numCorruptionRecords;
+	size_t firstRecord = totalCorruptionRecords > gma_maxCorruptionRecords
+		? totalCorruptionRecords - gma_maxCorruptionRecords
+		: 0;
+	gma_CrashLine_appendStr(&line, "Recent corruption findings: ");
+	gma_CrashLine_appendUint(&line, (uint64)(totalCorruptionRecords - firstRecord));
+	gma_CrashLine_appendStr(&line, " of ");
+	gma_CrashLine_appendUint(&line, (uint64)totalCorruptionRecords);
+	gma_CrashLine_appendStr(&line, "\n");
+	gma_CrashLine_flush(&line, fd);
+	for (size_t i = firstRecord; i < totalCorruptionRecords; i++)
+	{
+		const gma_CorruptionRecord* record = corruptionRecords + (i % gma_maxCorruptionRecords);
+		gma_CrashLine_appendStr(&line, gma_CorruptionKind_toString(record->kind));
+		gma_CrashLine_appendStr(&line, ": '");
+		gma_CrashLine_appendStr(&line, record->fileAllocator);
+		gma_CrashLine_appendStr(&line, "' line: ");
+		gma_CrashLine_appendUint(&line, (uint64)record->fileAllocatorLine);
+		gma_CrashLine_appendStr(&line, "\n");
+		gma_CrashLine_flush(&line, fd);
+	}
+
+	gma_CrashLine_appendStr(&line, "==== end of g_memory crash report ====\n");
+	gma_CrashLine_flush(&line, fd);
+}
+
+static void gma_writeCaughtSignal(int signalNumber)
+{
+	gma_CrashLine line;
+	line.length = 0;
+	gma_CrashLine_appendStr(&line, "Caught fatal signal ");
+	gma_CrashLine_appendUint(&line, (uint64)signalNumber);
+	gma_CrashLine_appendStr(&line, "\n");
+	gma_CrashLine_flush(&line, crashReportFd);
+}
+
+#ifdef _WIN32
+static const int crashSignals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+#define gma_numCrashSignals (sizeof(crashSignals) / sizeof(crashSignals[0]))
+static void (*oldCrashHandlers[gma_numCrashSignals])(int);
+static bool crashHandlerInstalled = false;
+
+static void gma_crashSignalHandler(int signalNumber)
+{
+	gma_writeCaughtSignal(signalNumber);
+	g_memory_writeCrashReport(crashReportFd);
+	glog_dumpFlightRecorder();
+
+	// Hand it back to the default handler so the process still dies like it normally would
+	signal(signalNumber, SIG_DFL);
+	raise(signalNumber);
+}
+
+void g_memory_installCrashHandler(int fd)
+{
+	crashReportFd = fd;
+	if (crashHandlerInstalled)
+	{
+		// Saving the handlers again would save ours, and uninstalling would never get the originals back
+		return;
+	}
+
+	for (size_t i = 0; i < gma_numCrashSignals; i++)
+	{
+		oldCrashHandlers[i] = signal(crashSignals[i], gma_crashSignalHandler);
+	}
+	crashHandlerInstalled = true;
+}
+
+void g_memory_uninstallCrashHandler(void)
+{
+	if (!crashHandlerInstalled)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < gma_numCrashSignals; i++)
+	{
+		signal(crashSignals[i], oldCrashHandlers[i] == SIG_ERR ? SIG_DFL : oldCrashHandlers[i]);
+	}
+	crashHandlerInstalled = false;
+	crashReportFd = -1;
+}
+#else
+static const int crashSignals[] = { SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL };
+#define gma_numCrashSignals (sizeof(crashSignals) / sizeof(crashSignals[0]))
+static struct sigaction oldCrashActions[gma_numCrashSignals];
+static bool crashHandlerInstalled = false;
+
+// Stack overflows are reported through SIGSEGV on the overflowed stack, so the handler gets its
+// own stack. NOTE: sigaltstack is per-thread, this only covers the thread that installed the handler.
+#define gma_crashAltStackSize (64 * 1024)
+static void* crashAltStack = NULL;
+
+static void gma_crashSignalHandler(int signalNumber)
+{
+	gma_writeCaughtSignal(signalNumber);
+	g_memory_writeCrashReport(crashReportFd);
+	glog_dumpFlightRecorder();
+
+	// SA_RESETHAND already put the default action back, so this kills the process (and dumps core)
+	// exactly like it would have without us
+	raise(signalNumber);
+}
+
+void g_memory_installCrashHandler(int fd)
+{
+	crashReportFd = fd;
+
+	if (crashAltStack == NULL)
+	{
+		crashAltStack = malloc(gma_crashAltStackSize);
+		if (crashAltStack)
+		{
+			stack_t altStack;
+			altStack.ss_sp = crashAltStack;
+			altStack.ss_size = gma_crashAltStackSize;
+			altStack.ss_flags = 0;
+			sigaltstack(&altStack, NULL);
+		}
+	}
+
+	if (crashHandlerInstalled)
+	{
+		// Saving the actions again would save ours, and uninstalling would never get the originals back
+		return;
+	}
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = gma_crashSignalHandler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+	for (size_t i = 0; i < gma_numCrashSignals; i++)
+	{
+		sigaction(crashSignals[i], &action, &oldCrashActions[i]);
+	}
+	crashHandlerInstalled = true;
+}
+
+void g_memory_uninstallCrashHandler(void)
+{
+	if (!crashHandlerInstalled)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < gma_numCrashSignals; i++)
+	{
+		sigaction(crashSignals[i], &oldCrashActions[i], NULL);
+	}
+	crashHandlerInstalled = false;
+	crashReportFd = -1;
+
+	if (crashAltStack)
+	{
+		stack_t altStack;
+		memset(&altStack, 0, sizeof(altStack));
+		altStack.ss_flags = SS_DISABLE;
+		sigaltstack(&altStack, NULL);
+		free(crashAltStack);
+		crashAltStack = NULL;
+	}
+}
+#endif
+
+
+// ----------------------------------
+// Logging Implementation Common C11
+// ----------------------------------
+
+// Initialize these variables just in case init isn't called for some reason
+static g_logger_level log_level = g_logger_level_All;
+
+static g_thread_mutex logMutex = G_THREAD_MUTEX_INIT;
+
+// Forward declarations
+void g_logger_disable_async(void);
+static void glog_freeDeferredFormatting(void);
+static void glog_freeSites(void);
+static void glog_reportSuppressed(void);
+static void glog_setInheritedChannelLevels(g_logger_level level);
+static void glog_freeChannels(void);
+static void glog_freeFlightRecorder(void);
+static void glog_initSinks(void);
+static void glog_freeSinks(void);
+static void glog_stopRotationThread(void);
+
+void g_logger_set_level(g_logger_level level)
+{
+	log_level = level;
+	glog_setInheritedChannelLevels(level);
+}
+
+g_logger_level g_logger_get_level(void)
+{
+	return log_level;
+}
+
+void g_logger_init(void)
+{
+	log_level = g_logger_level_All;
+	glog_initSinks();
+
+	// The console sink skips stdio on Linux, so whatever the application printed so far goes out first
+	fflush(stdout);
+
+	// Lets levels get changed without a rebuild, for example GABE_LOGGER_LEVELS=warning,net=log
+#ifdef _WIN32
+	char* config = NULL;
+	size_t configSize = 0;
+	if (_dupenv_s(&config, &configSize, "GABE_LOGGER_LEVELS") == 0 && config)
+	{
+		g_logger_configure_channels(config);
+		free(config);
+	}
+#else
+	const char* config = getenv("GABE_LOGGER_LEVELS");
+	if (config)
+	{
+		g_logger_configure_channels(config);
+	}
+#endif
+}
+
+void g_logger_free(void)
+{
+	// First, while every sink is still around
+	glog_reportSuppressed();
+	g_logger_disable_async();
+	glog_freeDeferredFormatting();
+	glog_freeSites();
+	glog_freeChannels();
+	g_logger_set_json_log_file(NULL);
+	g_logger_set_mapped_log_file(NULL, 0, 0);
+	glog_freeFlightRecorder();
+	glog_stopRotationThread();
+	glog_freeSinks();
+}
+
+// ----------------------------------
+// Log Rotation Implementation Common C11
+// ----------------------------------
+// The active file keeps its name and its file descriptor. To rotate, it gets renamed to .1 (renames are
+// atomic, and writers that still hold the descriptor just land in the renamed file), a fresh file is
+// opened at the original path, and dup2 swaps it into the existing descriptor. Nobody ever writes to a
+// closed descriptor, so rotation needs no lock. The async writer thread rotates files itself, anyone
+// else hands the rotation to the rotation thread and keeps writing to the current file until it's done.
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+typedef struct glog_LogFile
+{
+	FILE* file;
+	char* path;
+
+	uint64 rotationMaxBytes;
+	uint32 rotationIntervalSeconds;
+	uint32 rotationNumRetainedFiles;
+
+	volatile uint64 bytesWritten;
+	volatile uint64 nextRotation;
+	// 0, glog_rotatingNow while somebody rotates, or glog_rotatingRequested until the rotation thread does
+	volatile uint32 rotating;
+} glog_LogFile;
+
+#define glog_rotatingNow 1
+#define glog_rotatingRequested 2
+
+// Only ever true on the async writer thread
+static GCU_THREAD_LOCAL bool isAsyncWriter = false;
+
+// Sinks only get freed with rotationMutex held, so the rotation thread never rotates a freed file
+static g_thread_mutex rotationMutex = G_THREAD_MUTEX_INIT;
+static volatile uint32 rotationRequests = 0;
+static volatile uint32 rotationThreadRunning = 0;
+static void* rotationThread = NULL;
+
+// Rotation can run in the middle of a write with logMutex held, so a failed rotation can't log right
+// away. It gets recorded here and glog_writeToSinks reports it once the write that's in progress is done.
+static g_thread_spinlock failedRotationLock = G_THREAD_SPINLOCK_INIT;
+static volatile uint32 numFailedRotations = 0;
+static char failedRotationPath[256];
+
+static void glog_preallocateLogFile(const glog_LogFile* logFile, FILE* file)
+{
+	if (logFile->rotationMaxBytes == 0)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	FILE_ALLOCATION_INFO allocationInfo;
+	allocationInfo.AllocationSize.QuadPart = (LONGLONG)logFile->rotationMaxBytes;
+	SetFileInformationByHandle((HANDLE)_get_osfhandle(_fileno(file)), FileAllocationInfo, &allocationInfo, sizeof(allocationInfo));
+#elif defined(__linux__)
+	// Reserve the blocks without touching the file size, so the file never has a tail of zeros
+	fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, 0, (off_t)logFile->rotationMaxBytes);
+#else
+	(void)file;
+#endif
+}
+
+static FILE* glog_openLogFile(const glog_LogFile* logFile, const char* filepath)
+{
+#ifdef _WIN32
+	// The CRT doesn't open files with FILE_SHARE_DELETE, and without it the file can't be renamed
+	// while it's open
+	HANDLE handle = CreateFileA(filepath, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return NULL;
+	}
+
+	int fd = _open_osfhandle((intptr_t)handle, _O_WRONLY | _O_BINARY);
+	if (fd == -1)
+	{
+		CloseHandle(handle);
+		return NULL;
+	}
+
+	FILE* file = _fdopen(fd, "wb");
+	if (!file)
+	{
+		_close(fd);
+		return NULL;
+	}
+#else
+	FILE* file = fopen(filepath, "wb");
+	if (!file)
+	{
+		return NULL;
+	}
+#endif
+
+	glog_preallocateLogFile(logFile, file);
+	return file;
+}
+
+// Turns "dir/name.txt" into "dir/name.<index>.txt"
+static bool glog_indexedLogFilePath(char* buf, size_t bufSize, const char* path, uint32 index)
+{
+	const char* extension = strrchr(path, '.');
+	const char* lastSlash = strrchr(path, '/');
+	const char* lastBackslash = strrchr(path, '\\');
+	if (!extension || (lastSlash && extension < lastSlash) || (lastBackslash && extension < lastBackslash))
+	{
+		extension = path + strlen(path);
+	}
+
+	int length = snprintf(buf, bufSize, "%.*s.%u%s", (int)(extension - path), path, index, extension);
+	return length >= 0 && length < (int)bufSize;
+}
+
+// Index 0 is the active file, "dir/log_<date>.txt". Anything else is "dir/log_<date>.<index>.txt".
+static bool glog_rotatedLogFilePath(const glog_LogFile* logFile, char* buf, size_t bufSize, uint32 index)
+{
+	if (index == 0)
+	{
+		return snprintf(buf, bufSize, "%s", logFile->path) < (int)bufSize;
+	}
+
+	return glog_indexedLogFilePath(buf, bufSize, logFile->path, index);
+}
+
+static uint64 glog_nextRotationTime(const glog_LogFile* logFile)
+{
+	if (logFile->rotationIntervalSeconds == 0)
+	{
+		return 0;
+	}
+
+	uint64 now = (uint64)time(NULL);
+	return (now / logFile->rotationIntervalSeconds + 1) * logFile->rotationIntervalSeconds;
+}
+
+// Defined with the io_uring writer
+static void glog_Uring_waitIdle(void);
+
+static void glog_rotateLogFile(glog_LogFile* logFile)
+{
+	// Max path on windows plus room for the index
+#define maxRotatedPath 280
+	char oldPath[maxRotatedPath];
+	char newPath[maxRotatedPath];
+	uint32 numRetainedFiles = logFile->rotationNumRetainedFiles;
+
+	// Shift every retained file up by one, dropping the oldest
+	if (numRetainedFiles > 0 && glog_rotatedLogFilePath(logFile, oldPath, sizeof(oldPath), numRetainedFiles))
+	{
+		remove(oldPath);
+	}
+	for (uint32 i = numRetainedFiles; i > 1; i--)
+	{
+		if (glog_rotatedLogFilePath(logFile, oldPath, sizeof(oldPath), i - 1) && glog_rotatedLogFilePath(logFile, newPath, sizeof(newPath), i))
+		{
+			rename(oldPath, newPath);
+		}
+	}
+
+	glog_rotatedLogFilePath(logFile, oldPath, sizeof(oldPath), 0);
+	if (numRetainedFiles > 0 && glog_rotatedLogFilePath(logFile, newPath, sizeof(newPath), 1))
+	{
+		rename(oldPath, newPath);
+	}
+	else
+	{
+		remove(oldPath);
+	}
+
+	// Writers keep counting while this runs, so only take off what went to the file that's getting
+	// rotated out. Resetting to 0 would lose their bytes.
+	uint64 rotatedBytes = gcu_atomic_loadU64(&logFile->bytesWritten);
+	FILE* freshFile = glog_openLogFile(logFile, oldPath);
+	if (!freshFile)
+	{
+		// Keep appending to the file we have. Better than losing the messages.
+		g_thread_spinlockLock(&failedRotationLock);
+		gcu_atomic_addU32(&numFailedRotations, 1);
+		size_t pathLength = strlen(oldPath) < sizeof(failedRotationPath) ? strlen(oldPath) : sizeof(failedRotationPath) - 1;
+		memcpy(failedRotationPath, oldPath, pathLength);
+		failedRotationPath[pathLength] = '\0';
+		g_thread_spinlockUnlock(&failedRotationLock);
+	}
+	else
+	{
+#ifdef _WIN32
+		_dup2(_fileno(freshFile), _fileno(logFile->file));
+#else
+		// Anything the io_uring writer still has staged belongs in the old file
+		glog_Uring_waitIdle();
+		dup2(fileno(freshFile), fileno(logFile->file));
+#endif
+		fclose(freshFile);
+	}
+
+	gcu_atomic_addU64(&logFile->bytesWritten, (uint64)0 - rotatedBytes);
+	gcu_atomic_storeU64(&logFile->nextRotation, glog_nextRotationTime(logFile));
+#undef maxRotatedPath
+}
+
+// Called by every log file write with the number of bytes it's about to write
+static void glog_rotateIfNeeded(glog_LogFile* logFile, size_t numBytes)
+{
+	if (logFile->rotationMaxBytes == 0 && logFile->rotationIntervalSeconds == 0)
+	{
+		return;
+	}
+
+	uint64 bytesWritten = gcu_atomic_loadU64(&logFile->bytesWritten);
+	bool tooBig = logFile->rotationMaxBytes != 0 && bytesWritten != 0 && bytesWritten + numBytes > logFile->rotationMaxBytes;
+	bool tooOld = logFile->rotationIntervalSeconds != 0 && (uint64)time(NULL) >= gcu_atomic_loadU64(&logFile->nextRotation);
+	if (tooBig || tooOld)
+	{
+		// Only one rotation at a time, everyone else keeps writing to whichever file is current
+		bool rotateHere = isAsyncWriter || !rotationThread;
+		uint32 notRotating = 0;
+		if (gcu_atomic_casU32(&logFile->rotating, &notRotating, rotateHere ? glog_rotatingNow : glog_rotatingRequested))
+		{
+			if (rotateHere)
+			{
+				glog_rotateLogFile(logFile);
+				gcu_atomic_storeU32(&logFile->rotating, 0);
+			}
+			else
+			{
+				gcu_atomic_addU32(&rotationRequests, 1);
+				gcu_thread_wakeOneOnAddress(&rotationRequests);
+			}
+		}
+	}
+
+	gcu_atomic_addU64(&logFile->bytesWritten, numBytes);
+}
+
+// Defined with the sinks
+static void glog_startRotationThread(void);
+
+static void glog_LogFile_setRotation(glog_LogFile* logFile, uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles)
+{
+	if (maxBytes != 0 || intervalSeconds != 0)
+	{
+		glog_startRotationThread();
+	}
+
+	logFile->rotationMaxBytes = maxBytes;
+	logFile->rotationIntervalSeconds = intervalSeconds;
+	logFile->rotationNumRetainedFiles = numRetainedFiles;
+	gcu_atomic_storeU64(&logFile->nextRotation, glog_nextRotationTime(logFile));
+
+	if (logFile->file)
+	{
+		glog_preallocateLogFile(logFile, logFile->file);
+	}
+}
+
+static bool glog_LogFile_open(glog_LogFile* logFile, const char* filepath, uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles)
+{
+	size_t pathLength = strlen(filepath);
+	logFile->path = (char*)malloc(pathLength + 1);
+	if (!logFile->path)
+	{
+		printf("Failed to allocate memory for the log file path. Out of memory. Returning early.\n");
+		return false;
+	}
+	memcpy(logFile->path, filepath, pathLength + 1);
+
+	logFile->file = NULL;
+	logFile->rotating = 0;
+	gcu_atomic_storeU64(&logFile->bytesWritten, 0);
+	glog_LogFile_setRotation(logFile, maxBytes, intervalSeconds, numRetainedFiles);
+
+	logFile->file = glog_openLogFile(logFile, filepath);
+	if (!logFile->file)
+	{
+		printf("Failed to open file '%s' to log to. Please make sure the log directory exists, otherwise this will fail.\n", filepath);
+		free(logFile->path);
+		logFile->path = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+static void glog_LogFile_close(glog_LogFile* logFile)
+{
+	if (logFile->file)
+	{
+		fclose(logFile->file);
+		logFile->file = NULL;
+	}
+
+	if (logFile->path)
+	{
+		free(logFile->path);
+		logFile->path = NULL;
+	}
+}
+
+// ----------------------------------
+// Memory Mapped Log File Implementation Common C11
+// ----------------------------------
+// The mapped log file is a series of preallocated segments that are mapped into memory. Writers reserve
+// room with one atomic add on the segment's tail and memcpy the record in, so there's no syscall and no
+// stdio buffer. Anything copied in is already in the page cache, which means it survives the process
+// crashing. A background thread msyncs every so often so it survives the machine going down too.
+//
+// When a reservation runs past the end, the writer whose record straddles the end opens the next segment
+// and swaps it in. Everyone else that ran past the end just waits for the swap. There are two segment
+// slots that get reused back and forth, and each counts the threads using it, so the old segment is
+// only unmapped once nobody is copying into it anymore.
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+typedef struct glog_MappedSegment
+{
+	char* data;
+	uint64 size;
+	volatile uint64 tail;
+	// Where the record that ran off the end started, UINT64_MAX until that happens
+	volatile uint64 end;
+	volatile uint32 numUsers;
+	// Only touched by the sync thread
+	uint64 syncedBytes;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int fd;
+#endif
+} glog_MappedSegment;
+
+static glog_MappedSegment mappedSegments[2];
+// Goes up by one every time a segment fills up, 0 when the mapped log file is off. The segment being
+// written to lives in slot generation % 2. Waiters compare generations instead of slots, so two quick
+// rolls in a row can't look like no roll at all.
+static volatile uint64 mappedCurrent = 0;
+static volatile uint32 mappedRolling = 0;
+// The last generation handed out. Turning the mapped log file back on carries on from here instead of
+// starting over at 1, so a waiter from before can't mistake the new file for the one it waited on.
+static uint64 mappedLastGeneration = 0;
+
+static char* mappedLogFilePath = NULL;
+static uint64 mappedSegmentSize = 0;
+static uint32 mappedNextSegmentIndex = 0;
+
+static void* mappedSyncThread = NULL;
+static volatile uint32 mappedSyncRunning = 0;
+static uint32 mappedSyncIntervalMs = 0;
+
+static bool glog_openMappedSegment(glog_MappedSegment* segment, uint32 index)
+{
+	// Max path on windows plus room for the index
+	char path[280];
+	if (!glog_indexedLogFilePath(path, sizeof(path), mappedLogFilePath, index))
+	{
+		return false;
+	}
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	// Creating the mapping grows the file to the full segment size
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(mappedSegmentSize >> 32), (DWORD)(mappedSegmentSize & 0xFFFFFFFF), NULL);
+	void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)mappedSegmentSize) : NULL;
+	if (!data)
+	{
+		if (mapping)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	segment->file = file;
+	segment->mapping = mapping;
+#else
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	// Allocate the blocks up front. Otherwise a full disk shows up as a SIGBUS in the middle of a memcpy.
+#ifdef __linux__
+	bool allocated = posix_fallocate(fd, 0, (off_t)mappedSegmentSize) == 0;
+#else
+	bool allocated = ftruncate(fd, (off_t)mappedSegmentSize) == 0;
+#endif
+	void* data = allocated ? mmap(NULL, (size_t)mappedSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	if (data == MAP_FAILED)
+	{
+		close(fd);
+		remove(path);
+		return false;
+	}
+
+	segment->fd = fd;
+#endif
+
+	segment->data = (char*)data;
+	segment->size = mappedSegmentSize;
+	segment->syncedBytes = 0;
+	gcu_atomic_storeU64(&segment->end, UINT64_MAX);
+	gcu_atomic_storeU64(&segment->tail, 0);
+	return true;
+}
+
+static void glog_closeMappedSegment(glog_MappedSegment* segment, uint64 usedBytes)
+{
+	// The part of the segment that never got used gets cut off, so closed segments don't end in zeros
+#ifdef _WIN32
+	UnmapViewOfFile(segment->data);
+	CloseHandle(segment->mapping);
+
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = (LONGLONG)usedBytes;
+	SetFilePointerEx(segment->file, fileSize, NULL, FILE_BEGIN);
+	SetEndOfFile(segment->file);
+	CloseHandle(segment->file);
+#else
+	munmap(segment->data, (size_t)segment->size);
+	if (ftruncate(segment->fd, (off_t)usedBytes) != 0)
+	{
+		// Nothing to do about it, the file just keeps its zeros at the end
+	}
+	close(segment->fd);
+#endif
+
+	segment->data = NULL;
+}
+
+#ifdef _WIN32
+typedef HANDLE glog_MappedSyncFile;
+#else
+typedef int glog_MappedSyncFile;
+#endif
+
+// Called with a user on the segment. Starts writing back everything copied in since the last sync and
+// hands out a duplicate of the file to wait on with glog_finishMappedSync. That wait happens after
+// letting go of the segment, otherwise a roll would have to wait for the disk too. Returns false if
+// there's nothing to sync.
+static bool glog_startMappedSync(glog_MappedSegment* segment, glog_MappedSyncFile* outFile)
+{
+	uint64 tail = gcu_atomic_loadU64(&segment->tail);
+	if (tail > segment->size)
+	{
+		tail = segment->size;
+	}
+	if (tail <= segment->syncedBytes)
+	{
+		return false;
+	}
+
+#ifdef _WIN32
+	FlushViewOfFile(segment->data + segment->syncedBytes, (SIZE_T)(tail - segment->syncedBytes));
+	if (!DuplicateHandle(GetCurrentProcess(), segment->file, GetCurrentProcess(), outFile, 0, FALSE, DUPLICATE_SAME_ACCESS))
+	{
+		return false;
+	}
+#else
+	// msync needs a page aligned start
+	uint64 pageSize = (uint64)sysconf(_SC_PAGESIZE);
+	uint64 start = segment->syncedBytes - (segment->syncedBytes % pageSize);
+	msync(segment->data + start, (size_t)(tail - start), MS_ASYNC);
+	*outFile = dup(segment->fd);
+	if (*outFile < 0)
+	{
+		return false;
+	}
+#endif
+
+	segment->syncedBytes = tail;
+	return true;
+}
+
+// Waits for the write back to reach the disk. The segment may have been rolled and closed by now, the
+// duplicate keeps the file around until this is done with it.
+static void glog_finishMappedSync(glog_MappedSyncFile file)
+{
+#ifdef _WIN32
+	FlushFileBuffers(file);
+	CloseHandle(file);
+#else
+	// The mapping shares its pages with the file, so syncing the file covers everything copied in
+#ifdef __linux__
+	fdatasync(file);
+#else
+	fsync(file);
+#endif
+	close(file);
+#endif
+}
+
+// Returns the current segment with a user added to it, or NULL if the mapped log file is off
+static glog_MappedSegment* glog_acquireMappedSegment(uint64* outCurrent)
+{
+	for (;;)
+	{
+		uint64 current = gcu_atomic_loadU64(&mappedCurrent);
+		if (current == 0)
+		{
+			return NULL;
+		}
+
+		glog_MappedSegment* segment = mappedSegments + (current % 2);
+		gcu_atomic_addU32(&segment->numUsers, 1);
+		// Pairs with the fence in glog_retireMappedSegment. Either it sees our user, or we see it swapped out.
+		gcu_atomic_fence();
+		if (gcu_atomic_loadU64(&mappedCurrent) == current)
+		{
+			*outCurrent = current;
+			return segment;
+		}
+
+		gcu_atomic_addU32(&segment->numUsers, (uint32)-1);
+	}
+}
+
+static void glog_releaseMappedSegment(glog_MappedSegment* segment)
+{
+	gcu_atomic_addU32(&segment->numUsers, (uint32)-1);
+}
+
+// Swaps in newCurrent (0 for none), waits for everyone still copying into the old segment and closes it
+static void glog_retireMappedSegment(glog_MappedSegment* segment, uint64 newCurrent)
+{
+	gcu_atomic_storeU64(&mappedCurrent, newCurrent);
+	gcu_atomic_fence();
+	while (gcu_atomic_loadU32(&segment->numUsers) != 0)
+	{
+		gcu_thread_yield();
+	}
+
+	// Every reservation was made by a user, so end and tail are final now
+	uint64 usedBytes = gcu_atomic_loadU64(&segment->end);
+	if (usedBytes == UINT64_MAX)
+	{
+		usedBytes = gcu_atomic_loadU64(&segment->tail);
+	}
+	glog_closeMappedSegment(segment, usedBytes);
+}
+
+static void glog_lockMappedRoll(void)
+{
+	uint32 notRolling = 0;
+	while (!gcu_atomic_casU32(&mappedRolling, &notRolling, 1))
+	{
+		notRolling = 0;
+		gcu_thread_yield();
+	}
+}
+
+static void glog_unlockMappedRoll(void)
+{
+	gcu_atomic_storeU32(&mappedRolling, 0);
+}
+
+static void glog_rollMappedSegment(uint64 current)
+{
+	glog_lockMappedRoll();
+
+	// Someone may have turned the mapped log file off while we waited
+	if (gcu_atomic_loadU64(&mappedCurrent) == current)
+	{
+		uint64 next = current + 1;
+		bool opened = glog_openMappedSegment(mappedSegments + (next % 2), mappedNextSegmentIndex);
+		if (opened)
+		{
+			mappedNextSegmentIndex++;
+			mappedLastGeneration = next;
+		}
+		else
+		{
+			printf("Failed to open the next mapped log segment. Turning the mapped log file off.\n");
+		}
+
+		glog_retireMappedSegment(mappedSegments + (current % 2), opened ? next : 0);
+	}
+
+	glog_unlockMappedRoll();
+}
+
+// Copies a record into the mapped log file, if there is one. Records bigger than a whole segment get truncated.
+static void glog_writeMapped(const char* header, size_t headerLength, const char* body, size_t bodyLength)
+{
+	for (;;)
+	{
+		uint64 current;
+		glog_MappedSegment* segment = glog_acquireMappedSegment(&current);
+		if (!segment)
+		{
+			return;
+		}
+
+		if (headerLength > segment->size)
+		{
+			headerLength = (size_t)segment->size;
+		}
+		if (headerLength + bodyLength > segment->size)
+		{
+			bodyLength = (size_t)segment->size - headerLength;
+		}
+
+		uint64 numBytes = headerLength + bodyLength;
+		uint64 start = gcu_atomic_addU64(&segment->tail, numBytes);
+		if (start + numBytes <= segment->size)
+		{
+			memcpy(segment->data + start, header, headerLength);
+			memcpy(segment->data + start + headerLength, body, bodyLength);
+			glog_releaseMappedSegment(segment);
+			return;
+		}
+
+		// Only the record that straddles the end rolls, it has to mark the end before letting go
+		bool straddlesEnd = start <= segment->size;
+		if (straddlesEnd)
+		{
+			gcu_atomic_storeU64(&segment->end, start);
+		}
+		glog_releaseMappedSegment(segment);
+
+		if (straddlesEnd)
+		{
+			glog_rollMappedSegment(current);
+		}
+		else
+		{
+			while (gcu_atomic_loadU64(&mappedCurrent) == current)
+			{
+				gcu_thread_yield();
+			}
+		}
+	}
+}
+
+static void glog_mappedSyncThread(void* userData)
+{
+	(void)userData;
+
+	uint32 msSinceSync = 0;
+	while (gcu_atomic_loadU32(&mappedSyncRunning))
+	{
+		// Sleep in small steps so turning the mapped log file off doesn't wait a whole interval
+		gcu_thread_sleepMs(10);
+		msSinceSync += 10;
+		if (msSinceSync < mappedSyncIntervalMs)
+		{
+			continue;
+		}
+		msSinceSync = 0;
+
+		uint64 current;
+		glog_MappedSegment* segment = glog_acquireMappedSegment(&current);
+		if (segment)
+		{
+			glog_MappedSyncFile file;
+			bool started = glog_startMappedSync(segment, &file);
+			glog_releaseMappedSegment(segment);
+			if (started)
+			{
+				glog_finishMappedSync(file);
+			}
+		}
+	}
+}
+
+bool g_logger_set_mapped_log_file(const char* filepath, uint64 segmentBytes, uint32 syncIntervalMs)
+{
+	if (mappedSyncThread)
+	{
+		gcu_atomic_storeU32(&mappedSyncRunning, 0);
+		gcu_thread_join(mappedSyncThread);
+		mappedSyncThread = NULL;
+	}
+
+	glog_lockMappedRoll();
+	uint64 current = gcu_atomic_loadU64(&mappedCurrent);
+	if (current != 0)
+	{
+		glog_retireMappedSegment(mappedSegments + (current % 2), 0);
+	}
+	if (mappedLogFilePath)
+	{
+		free(mappedLogFilePath);
+		mappedLogFilePath = NULL;
+	}
+	glog_unlockMappedRoll();
+
+	if (!filepath)
+	{
+		return true;
+	}
+
+	size_t pathLength = strlen(filepath);
+	mappedLogFilePath = (char*)malloc(pathLength + 1);
+	if (!mappedLogFilePath)
+	{
+		printf("Failed to allocate memory for the mapped log file path. Out of memory. Returning early.\n");
+		return false;
+	}
+	memcpy(mappedLogFilePath, filepath, pathLength + 1);
+
+	mappedSegmentSize = segmentBytes != 0 ? segmentBytes : GABE_LOGGER_MAPPED_SEGMENT_SIZE;
+	mappedNextSegmentIndex = 1;
+	uint64 generation = mappedLastGeneration + 1;
+	if (!glog_openMappedSegment(mappedSegments + (generation % 2), mappedNextSegmentIndex))
+	{
+		printf("Failed to map log file '%s'. Please make sure the directory exists and has room for a %llu byte segment.\n",
+			filepath, (unsigned long long)mappedSegmentSize);
+		free(mappedLogFilePath);
+		mappedLogFilePath = NULL;
+		return false;
+	}
+	mappedNextSegmentIndex++;
+	mappedLastGeneration = generation;
+	gcu_atomic_storeU64(&mappedCurrent, generation);
+
+	if (syncIntervalMs != 0)
+	{
+		mappedSyncIntervalMs = syncIntervalMs;
+		gcu_atomic_storeU32(&mappedSyncRunning, 1);
+		mappedSyncThread = gcu_thread_start(glog_mappedSyncThread, NULL);
+		if (!mappedSyncThread)
+		{
+			printf("Failed to start the mapped log sync thread. Segments will only be synced by the OS.\n");
+		}
+	}
+
+	return true;
+}
+
+// ----------------------------------
+// Timestamp Implementation Common C11
+// ----------------------------------
+typedef struct glog_Timestamp
+{
+	// Unix time
+	int64 seconds;
+	uint32 microseconds;
+} glog_Timestamp;
+
+static volatile uint32 timestampMicroseconds = 0;
+static volatile uint32 clockMode = g_logger_clock_System;
+
+#if defined(_WIN32) && (defined(_M_X64) || defined(_M_IX86))
+static inline uint64 glog_readTicks(void) { return __rdtsc(); }
+#elif defined(__x86_64__) || defined(__i386__)
+static inline uint64 glog_readTicks(void) { return __builtin_ia32_rdtsc(); }
+#elif defined(_WIN32)
+static inline uint64 glog_readTicks(void)
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64)counter.QuadPart;
+}
+#else
+static inline uint64 glog_readTicks(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64)ts.tv_sec * 1000000000ull + (uint64)ts.tv_nsec;
+}
+#endif
+
+static uint64 glog_monotonicNs(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (uint64)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64)ts.tv_sec * 1000000000ull + (uint64)ts.tv_nsec;
+#endif
+}
+
+static void glog_systemNow(glog_Timestamp* out)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	out->seconds = (int64)ts.tv_sec;
+	out->microseconds = (uint32)(ts.tv_nsec / 1000);
+}
+
+// Tick clock calibration. Selecting the tick clock again re-anchors it while other threads are
+// logging, so every log call reads these under the seqlock. They're atomics anyways so a torn read
+// is only ever thrown away, never undefined.
+static g_thread_seqlock tscCalibrationLock = G_THREAD_SEQLOCK_INIT;
+static volatile uint64 tscBaseTicks = 0;
+// Unix time
+static volatile uint64 tscBaseMicroseconds = 0;
+// The bits of a double
+static volatile uint64 tscMicrosecondsPerTickBits = 0;
+
+static void glog_calibrateTicks(void)
+{
+	// Measure outside the lock, the 10ms sleep would stall every thread trying to log
+	uint64 startNs = glog_monotonicNs();
+	uint64 startTicks = glog_readTicks();
+	gcu_thread_sleepMs(10);
+	uint64 endNs = glog_monotonicNs();
+	uint64 endTicks = glog_readTicks();
+
+	double microsecondsPerTick = ((double)(endNs - startNs) / 1000.0) / (double)(endTicks - startTicks);
+	uint64 microsecondsPerTickBits;
+	memcpy(&microsecondsPerTickBits, &microsecondsPerTick, sizeof(uint64));
+
+	glog_Timestamp baseTime;
+	glog_systemNow(&baseTime);
+	uint64 baseTicks = glog_readTicks();
+
+	g_thread_seqlockWriteBegin(&tscCalibrationLock);
+	gcu_atomic_storeU64(&tscBaseTicks, baseTicks);
+	gcu_atomic_storeU64(&tscBaseMicroseconds, (uint64)baseTime.seconds * 1000000 + baseTime.microseconds);
+	gcu_atomic_storeU64(&tscMicrosecondsPerTickBits, microsecondsPerTickBits);
+	g_thread_seqlockWriteEnd(&tscCalibrationLock);
+}
+
+void g_logger_set_clock(g_logger_clock clock)
+{
+	if (clock == g_logger_clock_Tsc)
+	{
+		glog_calibrateTicks();
+	}
+
+	gcu_atomic_storeU32(&clockMode, (uint32)clock);
+}
+
+void g_logger_set_timestamp_microseconds(bool enabled)
+{
+	gcu_atomic_storeU32(&timestampMicroseconds, enabled ? 1 : 0);
+}
+
+static void glog_now(glog_Timestamp* out)
+{
+	if (gcu_atomic_loadU32(&clockMode) == g_logger_clock_Tsc)
+	{
+		uint64 baseTicks;
+		uint64 baseMicroseconds;
+		uint64 microsecondsPerTickBits;
+		uint32 sequence;
+		do
+		{
+			sequence = g_thread_seqlockReadBegin(&tscCalibrationLock);
+			baseTicks = gcu_atomic_loadU64(&tscBaseTicks);
+			baseMicroseconds = gcu_atomic_loadU64(&tscBaseMicroseconds);
+			microsecondsPerTickBits = gcu_atomic_loadU64(&tscMicrosecondsPerTickBits);
+		} while (g_thread_seqlockReadRetry(&tscCalibrationLock, sequence));
+
+		double microsecondsPerTick;
+		memcpy(&microsecondsPerTick, &microsecondsPerTickBits, sizeof(double));
+		uint64 micros = baseMicroseconds + (uint64)((double)(glog_readTicks() - baseTicks) * microsecondsPerTick);
+		out->seconds = (int64)(micros / 1000000);
+		out->microseconds = (uint32)(micros % 1000000);
+		return;
+	}
+
+	glog_systemNow(out);
+}
+
+// The last second each thread formatted. localtime takes a lock and reads the timezone state, so we
+// only call it when the second changes and reuse the text otherwise.
+typedef struct glog_TimestampCache
+{
+	int64 seconds;
+	size_t length;
+	char text[GABE_LOGGER_TIMESTAMP_SIZE];
+} glog_TimestampCache;
+
+static GCU_THREAD_LOCAL glog_TimestampCache timestampCache = { -1, 0, { 0 } };
+
+// Writes "YYYY-MM-DD hh:mm:ss" (or "YYYY-MM-DD hh:mm:ss.uuuuuu") into buf and returns the length
+static size_t glog_formatTimestamp(const glog_Timestamp* timestamp, char* buf, size_t bufSize)
+{
+	glog_TimestampCache* cache = &timestampCache;
+	if (cache->seconds != timestamp->seconds)
+	{
+		time_t seconds = (time_t)timestamp->seconds;
+		struct tm localTime;
+#ifdef _WIN32
+		localtime_s(&localTime, &seconds);
+#else
+		localtime_r(&seconds, &localTime);
+#endif
+		cache->length = strftime(cache->text, sizeof(cache->text), "%Y-%m-%d %I:%M:%S", &localTime);
+		cache->seconds = timestamp->seconds;
+	}
+
+	if (bufSize == 0)
+	{
+		return 0;
+	}
+
+	size_t length = cache->length < bufSize - 1 ? cache->length : bufSize - 1;
+	memcpy(buf, cache->text, length);
+
+	if (gcu_atomic_loadU32(&timestampMicroseconds) && length + 7 < bufSize)
+	{
+		uint32 micros = timestamp->microseconds;
+		buf[length] = '.';
+		for (int i = 6; i > 0; i--)
+		{
+			buf[length + i] = (char)('0' + micros % 10);
+			micros /= 10;
+		}
+		length += 7;
+	}
+
+	buf[length] = '\0';
+	return length;
+}
+
+static size_t glog_formatNow(char* buf, size_t bufSize)
+{
+	glog_Timestamp now;
+	glog_now(&now);
+	return glog_formatTimestamp(&now, buf, bufSize);
+}
+
+// ----------------------------------
+// Rate Limiting Implementation Common C11
+// ----------------------------------
+// Both limits work on a window per call site. Rate limiting lets maxPerSecond calls through per one
+// second window. Repeat suppression lets one call through per windowSeconds window. Whichever call
+// starts a new window reports how many calls the old one swallowed. A call in the middle of a window
+// costs a single relaxed fetch add on the site's state.
+static volatile uint32 rateLimits[g_logger_level_None + 1] = { 0 };
+static volatile uint32 repeatWindows[g_logger_level_None + 1] = { 0 };
+
+// g_logger_level_All sets every level at once
+static void glog_setPerLevel(volatile uint32* values, g_logger_level level, uint32 value)
+{
+	if (level < g_logger_level_All || level > g_logger_level_None)
+	{
+		return;
+	}
+
+	for (int i = (int)g_logger_level_All; i <= (int)g_logger_level_None; i++)
+	{
+		if (level == g_logger_level_All || i == (int)level)
+		{
+			gcu_atomic_storeU32(values + i, value);
+		}
+	}
+}
+
+void g_logger_set_rate_limit(g_logger_level level, uint32 maxPerSecond)
+{
+	glog_setPerLevel(rateLimits, level, maxPerSecond);
+}
+
+void g_logger_set_repeat_suppression(g_logger_level level, uint32 windowSeconds)
+{
+	glog_setPerLevel(repeatWindows, level, windowSeconds);
+}
+
+bool _g_logger_checkRateLimit(g_logger_rate_state* rate, g_logger_level level, uint32* outNumSuppressed)
+{
+	*outNumSuppressed = 0;
+
+	uint32 maxPerWindow = rateLimits[level];
+	uint32 windowSeconds = repeatWindows[level];
+	if (maxPerWindow == 0 && windowSeconds == 0)
+	{
+		return true;
+	}
+
+	if (windowSeconds == 0)
+	{
+		windowSeconds = 1;
+	}
+	else
+	{
+		maxPerWindow = 1;
+	}
+
+	uint32 now = (uint32)time(NULL);
+	// If the count ever overflows it carries into the window start, which just makes the next call open
+	// a fresh window
+	uint64 previous = gcu_atomic_addU64Relaxed(&rate->state, 1);
+	for (;;)
+	{
+		uint32 windowStart = (uint32)(previous >> 32);
+		uint32 numCalls = (uint32)previous;
+		if (now - windowStart < windowSeconds)
+		{
+			return numCalls < maxPerWindow;
+		}
+
+		uint64 expected = previous + 1;
+		if (gcu_atomic_casU64(&rate->state, &expected, ((uint64)now << 32) | 1))
+		{
+			*outNumSuppressed = numCalls > maxPerWindow ? numCalls - maxPerWindow : 0;
+			return true;
+		}
+
+		// Someone else changed the state first (most likely by starting the new window), so look again
+		previous = expected - 1;
+	}
+}
+
+// How many calls the site's current window has swallowed so far. Resets the site, so the next window
+// has nothing left to report.
+static uint32 glog_takeSuppressed(g_logger_site* site)
+{
+	uint32 maxPerWindow = repeatWindows[site->level] != 0 ? 1 : rateLimits[site->level];
+	uint64 state = gcu_atomic_loadU64(&site->rate.state);
+	// A window start of 0 means the site never went through the rate limiter, like check sites
+	if (maxPerWindow == 0 || (state >> 32) == 0)
+	{
+		return 0;
+	}
+
+	gcu_atomic_storeU64(&site->rate.state, 0);
+	uint32 numCalls = (uint32)state;
+	return numCalls > maxPerWindow ? numCalls - maxPerWindow : 0;
+}
+
+// ----------------------------------
+// Log Line Assembly Common C11
+// ----------------------------------
+// Each record is assembled once into a per-thread buffer and handed to every sink in a single write,
+// instead of a printf/fprintf per piece. Besides saving syscalls, that keeps lines from different
+// processes sharing the same output from interleaving mid record. Records that don't fit in the
+// buffer spill over to the heap.
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+#define glog_lineBufferSize 2048
+
+typedef struct glog_Line
+{
+	char* data;
+	size_t length;
+	size_t capacity;
+	// The per-thread buffer this line started in. data only points anywhere else after spilling to the heap.
+	char* inlineData;
+
+	// Console color codes are in the middle of a record, these mark the parts that go to the log file
+	size_t headerStart;
+	size_t headerEnd;
+	size_t bodyStart;
+	// Where the message starts, after the timestamp
+	size_t messageStart;
+} glog_Line;
+
+static GCU_THREAD_LOCAL char lineBuffer[glog_lineBufferSize];
+static GCU_THREAD_LOCAL char jsonLineBuffer[glog_lineBufferSize];
+
+static void glog_Line_beginIn(glog_Line* line, char* buffer, size_t bufferSize)
+{
+	line->data = buffer;
+	line->length = 0;
+	line->capacity = bufferSize;
+	line->inlineData = buffer;
+	line->headerStart = 0;
+	line->headerEnd = 0;
+	line->bodyStart = 0;
+	line->messageStart = 0;
+}
+
+static void glog_Line_begin(glog_Line* line)
+{
+	glog_Line_beginIn(line, lineBuffer, sizeof(lineBuffer));
+}
+
+static void glog_Line_end(glog_Line* line)
+{
+	if (line->data != line->inlineData)
+	{
+		free(line->data);
+	}
+	line->data = NULL;
+}
+
+static bool glog_Line_reserve(glog_Line* line, size_t numBytes)
+{
+	if (line->length + numBytes <= line->capacity)
+	{
+		return true;
+	}
+
+	size_t newCapacity = line->capacity * 2;
+	while (newCapacity < line->length + numBytes)
+	{
+		newCapacity *= 2;
+	}
+
+	char* newData = (char*)malloc(newCapacity);
+	if (!newData)
+	{
+		return false;
+	}
+
+	memcpy(newData, line->data, line->length);
+	if (line->data != line->inlineData)
+	{
+		free(line->data);
+	}
+	line->data = newData;
+	line->capacity = newCapacity;
+	return true;
+}
+
+static void glog_Line_append(glog_Line* line, const char* str, size_t length)
+{
+	if (!glog_Line_reserve(line, length))
+	{
+		length = line->capacity - line->length;
+	}
+
+	memcpy(line->data + line->length, str, length);
+	line->length += length;
+}
+
+static void glog_Line_appendStr(glog_Line* line, const char* str)
+{
+	if (str)
+	{
+		glog_Line_append(line, str, strlen(str));
+	}
+}
+
+static void glog_Line_appendv(glog_Line* line, const char* format, va_list args)
+{
+	size_t remaining = line->capacity - line->length;
+
+	va_list firstTry;
+	va_copy(firstTry, args);
+	int length = vsnprintf(line->data + line->length, remaining, format, firstTry);
+	va_end(firstTry);
+	if (length < 0)
+	{
+		return;
+	}
+
+	if ((size_t)length >= remaining)
+	{
+		// +1 since vsnprintf always wants room for the null byte
+		if (!glog_Line_reserve(line, (size_t)length + 1))
+		{
+			// Out of memory, keep what fit the first time around
+			line->length = line->capacity - 1;
+			return;
+		}
+		vsnprintf(line->data + line->length, line->capacity - line->length, format, args);
+	}
+
+	line->length += (size_t)length;
+}
+
+static void glog_Line_appendf(glog_Line* line, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	glog_Line_appendv(line, format, args);
+	va_end(args);
+}
+
+// Starts a record as "<color>filename (line N) <kind>: \n<reset>[timestamp]: ". The caller appends the
+// message and the trailing newline.
+static void glog_Line_beginRecord(glog_Line* line, const char* color, const char* reset, const char* filename, int lineNumber, const char* kind, const char* timestamp)
+{
+	glog_Line_begin(line);
+	glog_Line_appendStr(line, color);
+	line->headerStart = line->length;
+	glog_Line_appendf(line, "%s (line %d) %s: \n", filename, lineNumber, kind);
+	line->headerEnd = line->length;
+	glog_Line_appendStr(line, reset);
+	line->bodyStart = line->length;
+	glog_Line_appendf(line, "[%s]: ", timestamp);
+	line->messageStart = line->length;
+}
+
+// ----------------------------------
+// Log Sinks Implementation Common C11
+// ----------------------------------
+// Every record is formatted once into a glog_Line. Sinks never format anything themselves, they just
+// pick which parts of the line they want (location, timestamp, message) and write those. The registry is
+// a fixed array, so handing a record to every sink is a loop with no locks and no allocations. Writes
+// already happen under logMutex (or on the async writer thread), so the sinks don't need locks of their
+// own, except the memory sink, which can be read from any thread.
+#if defined(_WIN32) && defined(USE_GABE_CPP_PRINT)
+typedef CppUtils::ConsoleColor glog_Color;
+#elif defined(_WIN32)
+typedef WORD glog_Color;
+#else
+typedef const char* glog_Color;
+#endif
+
+typedef enum glog_SinkType
+{
+	glog_SinkType_Console = 0,
+	glog_SinkType_File,
+	glog_SinkType_RotatingFile,
+	glog_SinkType_Memory,
+	glog_SinkType_Callback,
+} glog_SinkType;
+
+typedef struct glog_Span
+{
+	const char* data;
+	size_t length;
+} glog_Span;
+
+typedef struct glog_Sink
+{
+	volatile uint32 active;
+	glog_SinkType type;
+	volatile uint32 level;
+	volatile uint32 format;
+
+	// File and RotatingFile
+	glog_LogFile logFile;
+
+	// Memory
+	char* memory;
+	size_t memoryCapacity;
+	uint64 memoryWritten;
+	volatile uint32 memoryLock;
+
+	// Callback
+	g_logger_sink_callback callback;
+	void* userData;
+} glog_Sink;
+
+static glog_Sink sinks[GABE_LOGGER_MAX_SINKS];
+// For callback sinks that want parts of the line that aren't next to each other
+static GCU_THREAD_LOCAL char sinkLineBuffer[glog_lineBufferSize];
+
+// The file g_logger_set_log_directory opened, and the rotation settings it gets
+static g_logger_sink logDirectorySink = -1;
+static uint64 logDirectoryRotationMaxBytes = 0;
+static uint32 logDirectoryRotationIntervalSeconds = 0;
+static uint32 logDirectoryRotationNumRetainedFiles = 0;
+
+// Defined per platform. Writes the parts of the line the format asks for to the console.
+static void glog_writeConsole(const glog_Line* line, uint32 format, glog_Color color);
+
+// Splits the line into the parts the format wants, merging the ones that are next to each other.
+// Returns the number of parts, at most 3.
+static size_t glog_Line_sinkParts(const glog_Line* line, uint32 format, glog_Span* parts)
+{
+	size_t numParts = 0;
+	size_t starts[3];
+	size_t ends[3];
+
+	if (format & g_logger_format_Location)
+	{
+		bool withColor = (format & g_logger_format_Color) != 0;
+		starts[numParts] = withColor ? 0 : line->headerStart;
+		ends[numParts] = withColor ? line->bodyStart : line->headerEnd;
+		numParts++;
+	}
+	if (format & g_logger_format_Timestamp)
+	{
+		starts[numParts] = line->bodyStart;
+		ends[numParts] = line->messageStart;
+		numParts++;
+	}
+	starts[numParts] = line->messageStart;
+	ends[numParts] = line->length;
+	numParts++;
+
+	size_t numMerged = 0;
+	for (size_t i = 0; i < numParts; i++)
+	{
+		if (numMerged > 0 && parts[numMerged - 1].data + parts[numMerged - 1].length == line->data + starts[i])
+		{
+			parts[numMerged - 1].length += ends[i] - starts[i];
+			continue;
+		}
+
+		parts[numMerged].data = line->data + starts[i];
+		parts[numMerged].length = ends[i] - starts[i];
+		numMerged++;
+	}
+
+	return numMerged;
+}
+
+static size_t glog_Span_totalLength(const glog_Span* parts, size_t numParts)
+{
+	size_t length = 0;
+	for (size_t i = 0; i < numParts; i++)
+	{
+		length += parts[i].length;
+	}
+	return length;
+}
+
+// One writev on POSIX. Short writes are rare on files and terminals, whatever's left is finished one
+// part at a time.
+static void glog_writeParts(int fd, const glog_Span* parts, size_t numParts)
+{
+#ifdef _WIN32
+	for (size_t i = 0; i < numParts; i++)
+	{
+		gcu_writeAll(fd, parts[i].data, parts[i].length);
+	}
+#else
+	struct iovec vectors[3];
+	for (size_t i = 0; i < numParts; i++)
+	{
+		vectors[i].iov_base = (void*)parts[i].data;
+		vectors[i].iov_len = parts[i].length;
+	}
+
+	ssize_t written;
+	do
+	{
+		written = writev(fd, vectors, (int)numParts);
+	} while (written < 0 && errno == EINTR);
+
+	if (written < 0)
+	{
+		return;
+	}
+
+	size_t numWritten = (size_t)written;
+	for (size_t i = 0; i < numParts; i++)
+	{
+		if (numWritten >= parts[i].length)
+		{
+			numWritten -= parts[i].length;
+			continue;
+		}
+
+		gcu_writeAll(fd, parts[i].data + numWritten, parts[i].length - numWritten);
+		numWritten = 0;
+	}
+#endif
+}
+
+// Defined with the io_uring writer. Only does anything on the async writer thread with io_uring on.
+static bool glog_Uring_stage(int fd, const glog_Span* parts, size_t numParts);
+
+static void glog_LogFile_write(glog_LogFile* logFile, const glog_Span* parts, size_t numParts)
+{
+	glog_rotateIfNeeded(logFile, glog_Span_totalLength(parts, numParts));
+#ifdef _WIN32
+	glog_writeParts(_fileno(logFile->file), parts, numParts);
+#else
+	int fd = fileno(logFile->file);
+	if (!glog_Uring_stage(fd, parts, numParts))
+	{
+		glog_writeParts(fd, parts, numParts);
+	}
+#endif
+}
+
+static void glog_lockMemorySink(glog_Sink* sink)
+{
+	uint32 unlocked = 0;
+	while (!gcu_atomic_casU32(&sink->memoryLock, &unlocked, 1))
+	{
+		unlocked = 0;
+		gcu_atomic_pause();
+	}
+}
+
+static void glog_unlockMemorySink(glog_Sink* sink)
+{
+	gcu_atomic_storeU32(&sink->memoryLock, 0);
+}
+
+static void glog_writeMemorySink(glog_Sink* sink, const glog_Span* parts, size_t numParts)
+{
+	glog_lockMemorySink(sink);
+	for (size_t i = 0; i < numParts; i++)
+	{
+		const char* data = parts[i].data;
+		size_t length = parts[i].length;
+		// Only the tail of anything bigger than the whole buffer would survive anyways
+		if (length > sink->memoryCapacity)
+		{
+			data += length - sink->memoryCapacity;
+			sink->memoryWritten += length - sink->memoryCapacity;
+			length = sink->memoryCapacity;
+		}
+
+		size_t offset = (size_t)(sink->memoryWritten % sink->memoryCapacity);
+		size_t firstChunk = length < sink->memoryCapacity - offset ? length : sink->memoryCapacity - offset;
+		memcpy(sink->memory + offset, data, firstChunk);
+		memcpy(sink->memory, data + firstChunk, length - firstChunk);
+		sink->memoryWritten += length;
+	}
+	glog_unlockMemorySink(sink);
+}
+
+static void glog_writeCallbackSink(const glog_Sink* sink, const glog_Line* line, const glog_Span* parts, size_t numParts, g_logger_level level, const char* filename, int lineNumber)
+{
+	g_logger_sink_record record;
+	record.level = level;
+	record.filename = filename;
+	record.line = lineNumber;
+
+	// The line holds "[timestamp]: message\n"
+	record.timestamp = line->data + line->bodyStart + 1;
+	record.timestampLength = line->messageStart > line->bodyStart + 4 ? line->messageStart - line->bodyStart - 4 : 0;
+	record.message = line->data + line->messageStart;
+	record.messageLength = line->length - line->messageStart;
+	if (record.messageLength > 0 && record.message[record.messageLength - 1] == '\n')
+	{
+		record.messageLength--;
+	}
+
+	// Parts that aren't next to each other get copied together, the callback wants one string
+	glog_Line text;
+	glog_Line_beginIn(&text, sinkLineBuffer, sizeof(sinkLineBuffer));
+	if (numParts == 1)
+	{
+		record.text = parts[0].data;
+		record.textLength = parts[0].length;
+	}
+	else
+	{
+		for (size_t i = 0; i < numParts; i++)
+		{
+			glog_Line_append(&text, parts[i].data, parts[i].length);
+		}
+		record.text = text.data;
+		record.textLength = text.length;
+	}
+
+	sink->callback(sink->userData, &record);
+	glog_Line_end(&text);
+}
+
+// Defined with the async ring
+static void glog_writeNotice(g_logger_level level, const char* filename, int line, const char* format, ...);
+
+// Has to be called with logMutex held
+static void glog_reportFailedRotations(void)
+{
+	// Writing the report can rotate and fail again. That one waits for the next record instead of
+	// recursing.
+	static bool reporting = false;
+	if (reporting)
+	{
+		return;
+	}
+	reporting = true;
+
+	char path[sizeof(failedRotationPath)];
+	g_thread_spinlockLock(&failedRotationLock);
+	uint32 numFailed = gcu_atomic_exchangeU32(&numFailedRotations, 0);
+	memcpy(path, failedRotationPath, sizeof(path));
+	g_thread_spinlockUnlock(&failedRotationLock);
+
+	if (numFailed > 0)
+	{
+		glog_writeNotice(g_logger_level_Error, __FILE__, __LINE__,
+			"Failed to open '%s' while rotating logs (%u times). Continuing to write to the previous file.", path, numFailed);
+	}
+	reporting = false;
+}
+
+// Hands a finished record to every sink that wants its level. Callers that already printed the record to
+// the console themselves pass skipConsole.
+static void glog_writeToSinks(const glog_Line* line, g_logger_level level, glog_Color color, const char* filename, int lineNumber, bool skipConsole)
+{
+	glog_writeMapped(line->data + line->headerStart, line->headerEnd - line->headerStart, line->data + line->bodyStart, line->length - line->bodyStart);
+
+	for (int i = 0; i < GABE_LOGGER_MAX_SINKS; i++)
+	{
+		glog_Sink* sink = sinks + i;
+		if (!gcu_atomic_loadU32(&sink->active) || (uint32)level < gcu_atomic_loadU32(&sink->level))
+		{
+			continue;
+		}
+
+		uint32 format = gcu_atomic_loadU32(&sink->format);
+		if (sink->type == glog_SinkType_Console)
+		{
+			if (!skipConsole)
+			{
+				glog_writeConsole(line, format, color);
+			}
+			continue;
+		}
+
+		glog_Span parts[3];
+		size_t numParts = glog_Line_sinkParts(line, format, parts);
+		switch (sink->type)
+		{
+		case glog_SinkType_File:
+		case glog_SinkType_RotatingFile:
+			glog_LogFile_write(&sink->logFile, parts, numParts);
+			break;
+		case glog_SinkType_Memory:
+			glog_writeMemorySink(sink, parts, numParts);
+			break;
+		case glog_SinkType_Callback:
+			glog_writeCallbackSink(sink, line, parts, numParts, level, filename, lineNumber);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// The file writes above are what rotate, so this is the first chance to report a failure
+	if (gcu_atomic_loadU32(&numFailedRotations) != 0)
+	{
+		glog_reportFailedRotations();
+	}
+}
+
+#ifdef USE_GABE_CPP_PRINT
+// For the cppPrint paths that print straight to the console instead of formatting into a line first
+static bool glog_consoleWants(g_logger_level level)
+{
+	for (int i = 0; i < GABE_LOGGER_MAX_SINKS; i++)
+	{
+		glog_Sink* sink = sinks + i;
+		if (gcu_atomic_loadU32(&sink->active) && sink->type == glog_SinkType_Console && (uint32)level >= gcu_atomic_loadU32(&sink->level))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+#endif
+
+static glog_Sink* glog_getSink(g_logger_sink sink)
+{
+	if (sink < 0 || sink >= GABE_LOGGER_MAX_SINKS || !gcu_atomic_loadU32(&sinks[sink].active))
+	{
+		return NULL;
+	}
+
+	return sinks + sink;
+}
+
+// Grabs a free slot and fills in the common parts. The caller fills in the rest and activates it.
+static g_logger_sink glog_reserveSink(glog_SinkType type, g_logger_level level, uint32 format)
+{
+	for (int i = 0; i < GABE_LOGGER_MAX_SINKS; i++)
+	{
+		glog_Sink* sink = sinks + i;
+		if (gcu_atomic_loadU32(&sink->active))
+		{
+			continue;
+		}
+
+		memset(&sink->logFile, 0, sizeof(sink->logFile));
+		sink->type = type;
+		sink->level = (uint32)level;
+		sink->format = format;
+		sink->memory = NULL;
+		sink->memoryCapacity = 0;
+		sink->memoryWritten = 0;
+		sink->memoryLock = 0;
+		sink->callback = NULL;
+		sink->userData = NULL;
+		return (g_logger_sink)i;
+	}
+
+	printf("Can't add another log sink, all %d are in use. Define GABE_LOGGER_MAX_SINKS to allow more.\n", GABE_LOGGER_MAX_SINKS);
+	return -1;
+}
+
+static g_logger_sink glog_activateSink(g_logger_sink sink)
+{
+	gcu_atomic_storeU32(&sinks[sink].active, 1);
+	return sink;
+}
+
+g_logger_sink g_logger_add_console_sink(g_logger_level level, uint32 format)
+{
+	g_logger_sink sink = glog_reserveSink(glog_SinkType_Console, level, format);
+	return sink < 0 ? -1 : glog_activateSink(sink);
+}
+
+g_logger_sink g_logger_add_rotating_file_sink(const char* filepath, g_logger_level level, uint32 format, uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles)
+{
+	g_logger_sink sink = glog_reserveSink(maxBytes != 0 || intervalSeconds != 0 ? glog_SinkType_RotatingFile : glog_SinkType_File, level, format);
+	if (sink < 0 || !glog_LogFile_open(&sinks[sink].logFile, filepath, maxBytes, intervalSeconds, numRetainedFiles))
+	{
+		return -1;
+	}
+
+	return glog_activateSink(sink);
+}
+
+g_logger_sink g_logger_add_file_sink(const char* filepath, g_logger_level level, uint32 format)
+{
+	return g_logger_add_rotating_file_sink(filepath, level, format, 0, 0, 0);
+}
+
+g_logger_sink g_logger_add_memory_sink(size_t capacityBytes, g_logger_level level, uint32 format)
+{
+	g_logger_sink sink = glog_reserveSink(glog_SinkType_Memory, level, format);
+	if (sink < 0)
+	{
+		return -1;
+	}
+
+	sinks[sink].memory = (char*)malloc(capacityBytes == 0 ? 1 : capacityBytes);
+	if (!sinks[sink].memory)
+	{
+		printf("Failed to allocate the memory log sink. Out of memory.\n");
+		return -1;
+	}
+	sinks[sink].memoryCapacity = capacityBytes == 0 ? 1 : capacityBytes;
+
+	return glog_activateSink(sink);
+}
+
+g_logger_sink g_logger_add_callback_sink(g_logger_sink_callback callback, void* userData, g_logger_level level, uint32 format)
+{
+	g_logger_sink sink = glog_reserveSink(glog_SinkType_Callback, level, format);
+	if (sink < 0)
+	{
+		return -1;
+	}
+
+	sinks[sink].callback = callback;
+	sinks[sink].userData = userData;
+	return glog_activateSink(sink);
+}
+
+size_t g_logger_read_memory_sink(g_logger_sink sinkHandle, char* buffer, size_t bufferSize)
+{
+	glog_Sink* sink = glog_getSink(sinkHandle);
+	if (!sink || sink->type != glog_SinkType_Memory)
+	{
+		return 0;
+	}
+
+	glog_lockMemorySink(sink);
+	uint64 numStored = sink->memoryWritten < sink->memoryCapacity ? sink->memoryWritten : sink->memoryCapacity;
+	size_t numBytes = numStored < bufferSize ? (size_t)numStored : bufferSize;
+
+	// The newest numBytes, oldest first
+	uint64 start = sink->memoryWritten - numBytes;
+	size_t offset = (size_t)(start % sink->memoryCapacity);
+	size_t firstChunk = numBytes < sink->memoryCapacity - offset ? numBytes : sink->memoryCapacity - offset;
+	memcpy(buffer, sink->memory + offset, firstChunk);
+	memcpy(buffer + firstChunk, sink->memory, numBytes - firstChunk);
+	glog_unlockMemorySink(sink);
+
+	return numBytes;
+}
+
+// Only call this once nothing can be writing to the sink anymore
+static void glog_Sink_free(glog_Sink* sink)
+{
+	gcu_atomic_storeU32(&sink->active, 0);
+	glog_LogFile_close(&sink->logFile);
+	if (sink->memory)
+	{
+		free(sink->memory);
+		sink->memory = NULL;
+	}
+}
+
+void g_logger_remove_sink(g_logger_sink sinkHandle)
+{
+	glog_Sink* sink = glog_getSink(sinkHandle);
+	if (!sink)
+	{
+		return;
+	}
+
+	// Let anything already queued up reach the sink before it goes away
+	g_logger_flush();
+
+	// Every sink write happens under the lock, the async writer thread takes it for each record too. So
+	// once we have it nobody is in the middle of one, and nobody starts another after we clear active.
+	g_thread_mutexLock(&logMutex);
+	gcu_atomic_storeU32(&sink->active, 0);
+	g_thread_mutexUnlock(&logMutex);
+
+	// The io_uring writer can still have writes for records it drained before that with the kernel
+	g_logger_flush();
+	g_thread_mutexLock(&rotationMutex);
+	glog_Sink_free(sink);
+	g_thread_mutexUnlock(&rotationMutex);
+
+	if (sinkHandle == logDirectorySink)
+	{
+		logDirectorySink = -1;
+	}
+}
+
+void g_logger_set_sink_level(g_logger_sink sinkHandle, g_logger_level level)
+{
+	glog_Sink* sink = glog_getSink(sinkHandle);
+	if (sink)
+	{
+		gcu_atomic_storeU32(&sink->level, (uint32)level);
+	}
+}
+
+void g_logger_set_sink_format(g_logger_sink sinkHandle, uint32 format)
+{
+	glog_Sink* sink = glog_getSink(sinkHandle);
+	if (sink)
+	{
+		gcu_atomic_storeU32(&sink->format, format);
+	}
+}
+
+static void glog_initSinks(void)
+{
+	memset(sinks, 0, sizeof(sinks));
+	logDirectorySink = -1;
+	g_logger_add_console_sink(g_logger_level_All, g_logger_format_Default);
+}
+
+static void glog_freeSinks(void)
+{
+	for (int i = 0; i < GABE_LOGGER_MAX_SINKS; i++)
+	{
+		glog_Sink_free(sinks + i);
+	}
+	logDirectorySink = -1;
+}
+
+static void glog_rotationThreadMain(void* userData)
+{
+	(void)userData;
+
+	uint32 seenRequests = 0;
+	for (;;)
+	{
+		uint32 requests = gcu_atomic_loadU32(&rotationRequests);
+		if (requests == seenRequests)
+		{
+			if (!gcu_atomic_loadU32(&rotationThreadRunning))
+			{
+				break;
+			}
+			gcu_thread_waitOnAddress(&rotationRequests, seenRequests);
+			continue;
+		}
+		seenRequests = requests;
+
+		g_thread_mutexLock(&rotationMutex);
+		for (int i = 0; i < GABE_LOGGER_MAX_SINKS; i++)
+		{
+			glog_LogFile* logFile = &sinks[i].logFile;
+			if (gcu_atomic_loadU32(&sinks[i].active) && logFile->file && gcu_atomic_loadU32(&logFile->rotating) == glog_rotatingRequested)
+			{
+				glog_rotateLogFile(logFile);
+				gcu_atomic_storeU32(&logFile->rotating, 0);
+			}
+		}
+		g_thread_mutexUnlock(&rotationMutex);
+	}
+}
+
+static void glog_startRotationThread(void)
+{
+	if (rotationThread)
+	{
+		return;
+	}
+
+	gcu_atomic_storeU32(&rotationThreadRunning, 1);
+	rotationThread = gcu_thread_start(glog_rotationThreadMain, NULL);
+	if (!rotationThread)
+	{
+		printf("Failed to start the log rotation thread. Log calls will rotate files themselves.\n");
+	}
+}
+
+static void glog_stopRotationThread(void)
+{
+	if (!rotationThread)
+	{
+		return;
+	}
+
+	gcu_atomic_storeU32(&rotationThreadRunning, 0);
+	gcu_atomic_addU32(&rotationRequests, 1);
+	gcu_thread_wakeOneOnAddress(&rotationRequests);
+	gcu_thread_join(rotationThread);
+	rotationThread = NULL;
+}
+
+void g_logger_set_log_rotation(uint64 maxBytes, uint32 intervalSeconds, uint32 numRetainedFiles)
+{
+	g_thread_mutexLock(&logMutex);
+
+	logDirectoryRotationMaxBytes = maxBytes;
+	logDirectoryRotationIntervalSeconds = intervalSeconds;
+	logDirectoryRotationNumRetainedFiles = numRetainedFiles;
+
+	glog_Sink* sink = glog_getSink(logDirectorySink);
+	if (sink)
+	{
+		glog_LogFile_setRotation(&sink->logFile, maxBytes, intervalSeconds, numRetainedFiles);
+	}
+
+	g_thread_mutexUnlock(&logMutex);
+}
+
+void g_logger_set_log_directory(const char* directory)
+{
+	// TODO: Better error checking
+	// Max path on windows, should be large enough for linux, if not we should error out here
+#define maxPath 261
+	char timebuf[maxPath] = { 0 };
+
+	time_t now;
+	time(&now);
+	struct tm localTime;
+#ifdef _WIN32
+	localtime_s(&localTime, &now);
+#else
+	localtime_r(&now, &localTime);
+#endif
+	strftime(timebuf, sizeof(timebuf), "/log_%Y-%m-%d_%I_%M_%S.txt", &localTime);
+
+	size_t filenameLength = strlen(timebuf);
+	size_t dirStringLength = strlen(directory);
+	// Minus 1 here for the null character
+	if (dirStringLength >= (maxPath - filenameLength - 1))
+	{
+		printf("Directory name to long. Max length 260 gets exceeded with log filename. Not setting log directory to: %s\n", directory);
+		return;
+	}
+
+	char filepath[maxPath];
+	memcpy(filepath, directory, sizeof(char) * dirStringLength);
+	memcpy(filepath + (sizeof(char) * dirStringLength), timebuf, sizeof(char) * filenameLength);
+	filepath[dirStringLength + filenameLength] = '\0';
+
+	g_logger_remove_sink(logDirectorySink);
+	logDirectorySink = g_logger_add_rotating_file_sink(filepath, g_logger_level_All, g_logger_format_Location | g_logger_format_Timestamp,
+		logDirectoryRotationMaxBytes, logDirectoryRotationIntervalSeconds, logDirectoryRotationNumRetainedFiles);
+
+#undef maxPath
+}
+
+#if defined(_WIN32) && !defined(USE_GABE_CPP_PRINT)
+// Where g_logger_set_log_directory is logging to, or NULL
+static const char* glog_logDirectoryFilePath(void)
+{
+	glog_Sink* sink = glog_getSink(logDirectorySink);
+	return sink ? sink->logFile.path : NULL;
+}
+#endif
+
+// ----------------------------------
+// JSON Log Output Implementation Common C11
+// ----------------------------------
+// One JSON object per line:
+//   {"ts":1792370476.123456,"level":"info","file":"main.c","line":12,"thread":4242,"msg":"...","fields":{...}}
+// ts is Unix time in seconds. Records from cppPrint style logging have "format" instead of "msg" since
+// their message never gets formatted to text. "fields" is only there for the *_kv macros.
+static FILE* jsonLogFile = NULL;
+
+bool g_logger_set_json_log_file(const char* filepath)
+{
+	g_logger_flush();
+	g_thread_mutexLock(&logMutex);
+
+	if (jsonLogFile)
+	{
+		fclose(jsonLogFile);
+		jsonLogFile = NULL;
+	}
+
+	bool success = true;
+	if (filepath)
+	{
+		jsonLogFile = fopen(filepath, "wb");
+		if (!jsonLogFile)
+		{
+			printf("Failed to open JSON log file '%s'.\n", filepath);
+			success = false;
+		}
+	}
+
+	g_thread_mutexUnlock(&logMutex);
+	return success;
+}
+
+static const char* glog_levelName(g_logger_level level)
+{
+	switch (level)
+	{
+	case g_logger_level_Log: return "log";
+	case g_logger_level_Info: return "info";
+	case g_logger_level_Warning: return "warning";
+	case g_logger_level_Error: return "error";
+	case g_logger_level_Assert: return "assert";
+	default: break;
+	}
+
+	return "unknown";
+}
+
+#define glog_swarOnes 0x0101010101010101ull
+#define glog_swarHighBits 0x8080808080808080ull
+
+// Sets the high bit of every byte in word that's a control character, '"' or '\\'. Bytes >= 0x80 are
+// left alone so UTF-8 passes straight through.
+static inline uint64 glog_jsonSpecialBytes(uint64 word)
+{
+	uint64 quotes = word ^ (glog_swarOnes * '"');
+	uint64 backslashes = word ^ (glog_swarOnes * '\\');
+	uint64 isControl = (word - glog_swarOnes * 0x20) & ~word;
+	uint64 isQuote = (quotes - glog_swarOnes) & ~quotes;
+	uint64 isBackslash = (backslashes - glog_swarOnes) & ~backslashes;
+	return (isControl | isQuote | isBackslash) & glog_swarHighBits;
+}
+
+// Appends str as the inside of a JSON string. Checks 8 bytes per step and copies clean runs in one go,
+// so plain text costs roughly a memcpy.
+static void glog_Line_appendJsonEscaped(glog_Line* line, const char* str, size_t length)
+{
+	static const char hexDigits[] = "0123456789abcdef";
+
+	size_t runStart = 0;
+	size_t i = 0;
+	while (i < length)
+	{
+		if (i + 8 <= length)
+		{
+			uint64 word;
+			memcpy(&word, str + i, sizeof(word));
+			if (glog_jsonSpecialBytes(word) == 0)
+			{
+				i += 8;
+				continue;
+			}
+		}
+
+		unsigned char c = (unsigned char)str[i];
+		if (c >= 0x20 && c != '"' && c != '\\')
+		{
+			i++;
+			continue;
+		}
+
+		glog_Line_append(line, str + runStart, i - runStart);
+		switch (c)
+		{
+		case '"': glog_Line_append(line, "\\\"", 2); break;
+		case '\\': glog_Line_append(line, "\\\\", 2); break;
+		case '\n': glog_Line_append(line, "\\n", 2); break;
+		case '\r': glog_Line_append(line, "\\r", 2); break;
+		case '\t': glog_Line_append(line, "\\t", 2); break;
+		default:
+		{
+			char escaped[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF] };
+			glog_Line_append(line, escaped, sizeof(escaped));
+			break;
+		}
+		}
+
+		i++;
+		runStart = i;
+	}
+
+	glog_Line_append(line, str + runStart, length - runStart);
+}
+
+// Appends `"key":value,"key":value` without the surrounding braces
+static void glog_Line_appendJsonFields(glog_Line* line, const g_logger_kv* fields, uint32 numFields)
+{
+	for (uint32 i = 0; i < numFields; i++)
+	{
+		const g_logger_kv* field = fields + i;
+		if (i > 0)
+		{
+			glog_Line_append(line, ",", 1);
+		}
+
+		glog_Line_append(line, "\"", 1);
+		glog_Line_appendJsonEscaped(line, field->key, strlen(field->key));
+		glog_Line_append(line, "\":", 2);
+
+		switch (field->type)
+		{
+		case g_logger_kv_Int:
+			glog_Line_appendf(line, "%lld", (long long)field->value.i);
+			break;
+		case g_logger_kv_UInt:
+			glog_Line_appendf(line, "%llu", (unsigned long long)field->value.u);
+			break;
+		case g_logger_kv_Float:
+			// JSON has no NaN or infinity
+			if (field->value.f != field->value.f || field->value.f - field->value.f != 0.0)
+			{
+				glog_Line_appendStr(line, "null");
+			}
+			else
+			{
+				glog_Line_appendf(line, "%.17g", field->value.f);
+			}
+			break;
+		case g_logger_kv_Bool:
+			glog_Line_appendStr(line, field->value.b ? "true" : "false");
+			break;
+		case g_logger_kv_String:
+			if (field->value.s)
+			{
+				glog_Line_append(line, "\"", 1);
+				glog_Line_appendJsonEscaped(line, field->value.s, strlen(field->value.s));
+				glog_Line_append(line, "\"", 1);
+			}
+			else
+			{
+				glog_Line_appendStr(line, "null");
+			}
+			break;
+		}
+	}
+}
+
+// message can be NULL, then format gets written instead. fields is the output of
+// glog_Line_appendJsonFields.
+static void glog_writeJson(const char* filename, int lineNumber, g_logger_level level, const glog_Timestamp* time, uint64 threadId,
+	const char* message, size_t messageLength, const char* format, const char* fields, size_t fieldsLength)
+{
+	if (!jsonLogFile)
+	{
+		return;
+	}
+
+	glog_Line line;
+	glog_Line_beginIn(&line, jsonLineBuffer, sizeof(jsonLineBuffer));
+
+	glog_Line_appendf(&line, "{\"ts\":%lld.%06u,\"level\":\"%s\",\"file\":\"",
+		(long long)time->seconds, time->microseconds, glog_levelName(level));
+	glog_Line_appendJsonEscaped(&line, filename, strlen(filename));
+	glog_Line_appendf(&line, "\",\"line\":%d,\"thread\":%llu,", lineNumber, (unsigned long long)threadId);
+
+	if (message)
+	{
+		glog_Line_appendStr(&line, "\"msg\":\"");
+		glog_Line_appendJsonEscaped(&line, message, messageLength);
+	}
+	else if (format)
+	{
+		glog_Line_appendStr(&line, "\"format\":\"");
+		glog_Line_appendJsonEscaped(&line, format, strlen(format));
+	}
+	else
+	{
+		glog_Line_appendStr(&line, "\"msg\":\"");
+	}
+	glog_Line_append(&line, "\"", 1);
+
+	if (fieldsLength > 0)
+	{
+		glog_Line_appendStr(&line, ",\"fields\":{");
+		glog_Line_append(&line, fields, fieldsLength);
+		glog_Line_append(&line, "}", 1);
+	}
+	glog_Line_append(&line, "}\n", 2);
+
+#ifdef _WIN32
+	gcu_writeAll(_fileno(jsonLogFile), line.data, line.length);
+#else
+	gcu_writeAll(fileno(jsonLogFile), line.data, line.length);
+#endif
+	glog_Line_end(&line);
+}
+
+// Where the message and the fields ended up in a line built by glog_Line_appendMessage
+typedef struct glog_MessageSpans
+{
+	size_t messageStart;
+	size_t messageLength;
+	size_t fieldsStart;
+	size_t fieldsLength;
+} glog_MessageSpans;
+
+// Formats the message into out, followed by " {fields}" if there are any
+static void glog_Line_appendMessage(glog_Line* out, glog_MessageSpans* spans, const g_logger_kv* fields, uint32 numFields, const char* format, va_list args)
+{
+	spans->messageStart = out->length;
+	glog_Line_appendv(out, format, args);
+	spans->messageLength = out->length - spans->messageStart;
+	spans->fieldsStart = out->length;
+	spans->fieldsLength = 0;
+
+	if (numFields > 0)
+	{
+		glog_Line_append(out, " {", 2);
+		spans->fieldsStart = out->length;
+		glog_Line_appendJsonFields(out, fields, numFields);
+		spans->fieldsLength = out->length - spans->fieldsStart;
+		glog_Line_append(out, "}", 1);
+	}
+}
+
+static void glog_writeJsonForLine(const glog_Line* line, const glog_MessageSpans* spans, const char* filename, int lineNumber, g_logger_level level, const glog_Timestamp* time)
+{
+	glog_writeJson(filename, lineNumber, level, time, gcu_thread_id(),
+		line->data + spans->messageStart, spans->messageLength, NULL,
+		line->data + spans->fieldsStart, spans->fieldsLength);
+}
+
+// ----------------------------------
+// Log Channels Implementation Common C11
+// ----------------------------------
+// Channels are a fixed array so call sites can hold on to a pointer to theirs. Adding channels and
+// changing their levels happens under logMutex, log calls only ever read a channel's level.
+
+static g_logger_channel channels[GABE_LOGGER_MAX_CHANNELS];
+static uint32 numChannels = 0;
+
+// Has to be called with logMutex held. name doesn't need to be null terminated.
+static g_logger_channel* glog_findChannel(const char* name, size_t nameLength, bool create)
+{
+	for (uint32 i = 0; i < numChannels; i++)
+	{
+		if (strncmp(channels[i].name, name, nameLength) == 0 && channels[i].name[nameLength] == '\0')
+		{
+			return &channels[i];
+		}
+	}
+
+	if (!create || numChannels >= GABE_LOGGER_MAX_CHANNELS || nameLength == 0 || nameLength >= GABE_LOGGER_CHANNEL_NAME_SIZE)
+	{
+		return NULL;
+	}
+
+	g_logger_channel* channel = &channels[numChannels];
+	memcpy(channel->name, name, nameLength);
+	channel->name[nameLength] = '\0';
+	channel->level = (uint32)log_level;
+	channel->hasOwnLevel = 0;
+	numChannels++;
+	return channel;
+}
+
+static void glog_setInheritedChannelLevelsLocked(g_logger_level level)
+{
+	for (uint32 i = 0; i < numChannels; i++)
+	{
+		if (!channels[i].hasOwnLevel)
+		{
+			gcu_atomic_storeU32(&channels[i].level, (uint32)level);
+		}
+	}
+}
+
+static void glog_setInheritedChannelLevels(g_logger_level level)
+{
+	g_thread_mutexLock(&logMutex);
+	glog_setInheritedChannelLevelsLocked(level);
+	g_thread_mutexUnlock(&logMutex);
+}
+
+g_logger_channel* g_logger_get_channel(const char* channelName)
+{
+	g_thread_mutexLock(&logMutex);
+	g_logger_channel* channel = glog_findChannel(channelName, strlen(channelName), true);
+	g_thread_mutexUnlock(&logMutex);
+	return channel;
+}
+
+bool g_logger_set_channel_level(const char* channelName, g_logger_level level)
+{
+	g_thread_mutexLock(&logMutex);
+	g_logger_channel* channel = glog_findChannel(channelName, strlen(channelName), true);
+	if (channel)
+	{
+		channel->hasOwnLevel = 1;
+		gcu_atomic_storeU32(&channel->level, (uint32)level);
+	}
+	g_thread_mutexUnlock(&logMutex);
+	return channel != NULL;
+}
+
+g_logger_level g_logger_get_channel_level(const char* channelName)
+{
+	g_thread_mutexLock(&logMutex);
+	g_logger_channel* channel = glog_findChannel(channelName, strlen(channelName), false);
+	g_logger_level level = channel ? (g_logger_level)channel->level : log_level;
+	g_thread_mutexUnlock(&logMutex);
+	return level;
+}
+
+static bool glog_parseLevel(const char* str, size_t length, g_logger_level* outLevel)
+{
+	static const char* levelNames[] = { "all", "log", "info", "warning", "error", "assert", "none" };
+
+	if (length == 1 && str[0] >= '0' && str[0] <= '6')
+	{
+		*outLevel = (g_logger_level)(str[0] - '0');
+		return true;
+	}
+
+	for (size_t i = 0; i < sizeof(levelNames) / sizeof(levelNames[0]); i++)
+	{
+		if (strlen(levelNames[i]) != length)
+		{
+			continue;
+		}
+
+		// Case insensitive, every name is plain lowercase letters
+		size_t c = 0;
+		while (c < length && (str[c] | 0x20) == levelNames[i][c])
+		{
+			c++;
+		}
+
+		if (c == length)
+		{
+			*outLevel = (g_logger_level)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool glog_isConfigSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static void glog_trimConfig(const char** start, const char** end)
+{
+	while (*start < *end && glog_isConfigSpace(**start))
+	{
+		(*start)++;
+	}
+
+	while (*end > *start && glog_isConfigSpace((*end)[-1]))
+	{
+		(*end)--;
+	}
+}
+
+bool g_logger_configure_channels(const char* config)
+{
+	bool success = true;
+	g_logger_level globalLevel = log_level;
+
+	g_thread_mutexLock(&logMutex);
+
+	// A config replaces the last one, so channels it doesn't mention go back to the global level
+	for (uint32 i = 0; i < numChannels; i++)
+	{
+		channels[i].hasOwnLevel = 0;
+	}
+
+	const char* entry = config;
+	while (*entry != '\0')
+	{
+		const char* entryEnd = entry;
+		while (*entryEnd != '\0' && *entryEnd != ',' && *entryEnd != ';')
+		{
+			entryEnd++;
+		}
+
+		const char* equals = entry;
+		while (equals < entryEnd && *equals != '=')
+		{
+			equals++;
+		}
+
+		// Trim the name and the level
+		const char* nameStart = entry;
+		const char* nameEnd = equals == entryEnd ? entry : equals;
+		const char* levelStart = equals == entryEnd ? entry : equals + 1;
+		const char* levelEnd = entryEnd;
+		glog_trimConfig(&nameStart, &nameEnd);
+		glog_trimConfig(&levelStart, &levelEnd);
+
+		size_t nameLength = (size_t)(nameEnd - nameStart);
+		g_logger_level level;
+		if (levelStart == levelEnd && nameLength == 0)
+		{
+			// Empty entry, like a trailing comma
+		}
+		else if (!glog_parseLevel(levelStart, (size_t)(levelEnd - levelStart), &level))
+		{
+			success = false;
+		}
+		else if (nameLength == 0 || (nameLength == 1 && *nameStart == '*'))
+		{
+			globalLevel = level;
+		}
+		else
+		{
+			g_logger_channel* channel = glog_findChannel(nameStart, nameLength, true);
+			if (channel)
+			{
+				channel->hasOwnLevel = 1;
+				gcu_atomic_storeU32(&channel->level, (uint32)level);
+			}
+			else
+			{
+				success = false;
+			}
+		}
+
+		entry = *entryEnd == '\0' ? entryEnd : entryEnd + 1;
+	}
+
+	log_level = globalLevel;
+	glog_setInheritedChannelLevelsLocked(globalLevel);
+
+	g_thread_mutexUnlock(&logMutex);
+	return success;
+}
+
+static void glog_freeChannels(void)
+{
+	numChannels = 0;
+}
+
+// ----------------------------------
+// Log Sites Implementation Common C11
+// ----------------------------------
+// Every log call has a static g_logger_site. The first call through it trims the filename, saves the
+// format and hands out the next id, after that the call only reads the site. Colors are picked from
+// the level here instead of being passed at every call.
+
+// Indexed by id - 1. Only grows, and is only touched with logMutex held.
+static g_logger_site** sites = NULL;
+static uint32 numSites = 0;
+static uint32 sitesCapacity = 0;
+
+// Has to be called with logMutex held. Sites whose channel doesn't fit just follow g_logger_set_level.
+static g_logger_channel* glog_siteChannel(const g_logger_site* site)
+{
+	return site->channelName ? glog_findChannel(site->channelName, strlen(site->channelName), true) : NULL;
+}
+
+static const char* glog_basename(const char* filepath)
+{
+	const char* basename = filepath;
+	for (const char* c = filepath; *c != '\0'; c++)
+	{
+		if (*c == '/' || *c == '\\')
+		{
+			basename = c + 1;
+		}
+	}
+	return basename;
+}
+
+#ifdef USE_GABE_CPP_PRINT
+static CppUtils::ConsoleColor glog_consoleColor(g_logger_level level)
+{
+	switch (level)
+	{
+	case g_logger_level_Log: return CppUtils::ConsoleColor::CYAN;
+	case g_logger_level_Info: return CppUtils::ConsoleColor::GREEN;
+	case g_logger_level_Warning: return CppUtils::ConsoleColor::YELLOW;
+	default: return CppUtils::ConsoleColor::RED;
+	}
+}
+#endif
+
+static glog_Color glog_levelColor(g_logger_level level)
+{
+#if defined(_WIN32) && defined(USE_GABE_CPP_PRINT)
+	return glog_consoleColor(level);
+#elif defined(_WIN32)
+	switch (level)
+	{
+	case g_logger_level_Log: return g_logger_FOREGROUND_BLUE | g_logger_FOREGROUND_GREEN;
+	case g_logger_level_Info: return g_logger_FOREGROUND_GREEN;
+	case g_logger_level_Warning: return g_logger_FOREGROUND_GREEN | g_logger_FOREGROUND_RED;
+	default: return g_logger_FOREGROUND_RED;
+	}
+#else
+	switch (level)
+	{
+	case g_logger_level_Log: return "\x1B[34m";
+	case g_logger_level_Info: return "\x1B[32m";
+	case g_logger_level_Warning: return "\x1B[33m";
+	default: return "\x1B[31m";
+	}
+#endif
+}
+
+void _g_logger_registerSite(g_logger_site* site, const char* format, uint8 numArgs, const uint8* argTypes, g_logger_binary_decode_fn decode)
+{
+	g_thread_mutexLock(&logMutex);
+
+	// Another thread may have beaten us here
+	if (site->id == 0)
+	{
+		if (numSites >= sitesCapacity)
+		{
+			uint32 newCapacity = sitesCapacity == 0 ? 64 : sitesCapacity * 2;
+			g_logger_site** newSites = (g_logger_site**)realloc(sites, sizeof(g_logger_site*) * newCapacity);
+			if (!newSites)
+			{
+				// Still usable, it just gets no id and tries again next time
+				site->filename = glog_basename(site->filename);
+				site->channel = glog_siteChannel(site);
+				g_thread_mutexUnlock(&logMutex);
+				return;
+			}
+			sites = newSites;
+			sitesCapacity = newCapacity;
+		}
+
+		site->filename = glog_basename(site->filename);
+		site->channel = glog_siteChannel(site);
+		site->format = format;
+		site->numArgs = numArgs;
+		site->argTypes = argTypes;
+		site->decode = decode;
+		sites[numSites++] = site;
+
+		// Publish last so nobody sees the id before the rest of the site is filled in
+		gcu_atomic_storeU32(&site->id, numSites);
+	}
+
+	g_thread_mutexUnlock(&logMutex);
+}
+
+static void glog_registerSiteIfNeeded(g_logger_site* site, const char* format)
+{
+	if (gcu_atomic_loadU32(&site->id) == 0)
+	{
+		_g_logger_registerSite(site, format, 0, NULL, NULL);
+	}
+}
+
+static void glog_freeSites(void)
+{
+	// The sites themselves are static variables at each call site, so reset them for the next init
+	for (uint32 i = 0; i < numSites; i++)
+	{
+		sites[i]->id = 0;
+		sites[i]->channel = NULL;
+	}
+	free(sites);
+	sites = NULL;
+	numSites = 0;
+	sitesCapacity = 0;
+}
+
+#ifndef USE_GABE_CPP_PRINT
+// Defined per platform
+static void glog_printUnthrottled(g_logger_site* site, const char* format, ...);
+#endif
+
+// Windows only get reported when the next call through the site opens a new one, so at shutdown
+// anything a site swallowed since its last message would never show up otherwise. Like the rest of
+// g_logger_free this assumes nobody is logging anymore.
+static void glog_reportSuppressed(void)
+{
+	for (uint32 i = 0; i < numSites; i++)
+	{
+		uint32 numSuppressed = glog_takeSuppressed(sites[i]);
+		if (numSuppressed > 0)
+		{
+#ifndef USE_GABE_CPP_PRINT
+			glog_printUnthrottled(sites[i], "suppressed %u messages from this site", numSuppressed);
+#else
+			_g_logger_gabePrintNow(sites[i], "suppressed {} messages from this site", numSuppressed);
+#endif
+		}
+	}
+}
+
+// ----------------------------------
+// Checks Implementation Common C11
+// ----------------------------------
+// g_logger_check only calls in here once its condition has already failed. Every failure is counted,
+// only the first one from each site gets logged and handed to the callback.
+
+static volatile uint32 checkAction = g_logger_check_Continue;
+static g_logger_check_callback checkCallback = NULL;
+static void* checkUserData = NULL;
+static volatile uint64 numCheckFailures = 0;
+
+void g_logger_set_check_action(g_logger_check_action action, g_logger_check_callback callback, void* userData)
+{
+	checkCallback = callback;
+	checkUserData = userData;
+	gcu_atomic_storeU32(&checkAction, (uint32)action);
+}
+
+uint64 g_logger_get_check_failure_count(void)
+{
+	return gcu_atomic_loadU64(&numCheckFailures);
+}
+
+bool _g_logger_checkFirstFailure(g_logger_site* site)
+{
+	gcu_atomic_addU64(&numCheckFailures, 1);
+	return gcu_atomic_addU64(&site->rate.state, 1) == 0;
+}
+
+void _g_logger_checkReport(const g_logger_site* site, const char* condition, const char* message)
+{
+	if (gcu_atomic_loadU32(&checkAction) == g_logger_check_Callback && checkCallback)
+	{
+		checkCallback(checkUserData, site->filename, site->line, condition, message);
+	}
+}
+
+void _g_logger_checkAbortIfNeeded(void)
+{
+	if (gcu_atomic_loadU32(&checkAction) != g_logger_check_Abort)
+	{
+		return;
+	}
+
+	g_logger_flush();
+	g_thread_mutexLock(&logMutex);
+	glog_dumpFlightRecorder();
+	g_thread_mutexUnlock(&logMutex);
+	abort();
+}
+
+#ifndef USE_GABE_CPP_PRINT
+void _g_logger_checkFailed(g_logger_site* site, const char* condition, const char* format, ...)
+{
+	glog_registerSiteIfNeeded(site, format);
+	if (_g_logger_checkFirstFailure(site))
+	{
+		char message[GABE_LOGGER_ASYNC_MESSAGE_SIZE];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(message, sizeof(message), format, args);
+		va_end(args);
+
+		glog_printUnthrottled(site, "Check '%s' failed: %s", condition, message);
+		_g_logger_checkReport(site, condition, message);
+	}
+
+	_g_logger_checkAbortIfNeeded();
+}
+#endif
+
+// ----------------------------------
+// Flight Recorder Implementation Common C11
+// ----------------------------------
+// Every thread that logs gets its own ring of the last few records. A record is just the call site, the
+// format string and the raw bytes of the arguments. Nothing gets formatted unless the recorder is dumped.
+// Only the owning thread writes to a ring, so recording is a handful of stores. Each slot has a sequence
+// number that's odd while the slot is being written, which lets the dump skip records that were torn
+// by the crash. The rings live on a lock-free list so the dump can walk them from a signal handler, and
+// they stay allocated until g_logger_free, so records from threads that already exited still show up.
+
+// Same values as _g_logger_ArgType, which stamps the cppPrint style records
+typedef enum glog_ArgType
+{
+	glog_ArgType_Unsupported = 0,
+	glog_ArgType_I8, glog_ArgType_I16, glog_ArgType_I32, glog_ArgType_I64,
+	glog_ArgType_U8, glog_ArgType_U16, glog_ArgType_U32, glog_ArgType_U64,
+	glog_ArgType_F32, glog_ArgType_F64,
+	glog_ArgType_Bool,
+	glog_ArgType_Char,
+	glog_ArgType_Pointer,
+	glog_ArgType_String,
+} glog_ArgType;
+
+#define glog_maxFlightArgs 16
+
+typedef struct glog_FlightRecord
+{
+	volatile uint64 sequence;
+	const char* filename;
+	const char* format;
+	glog_Timestamp time;
+	int32 line;
+	uint8 level;
+	// printf style format or cppPrint style format
+	bool isPrintf;
+	uint8 numArgs;
+	// Set when some of the arguments didn't fit or couldn't be captured
+	bool argsDropped;
+	uint32 payloadLength;
+	uint8 argTypes[glog_maxFlightArgs];
+	uint8 payload[GABE_LOGGER_FLIGHT_ARGS_SIZE];
+} glog_FlightRecord;
+
+typedef struct glog_FlightRing
+{
+	struct glog_FlightRing* next;
+	uint64 threadId;
+	uint64 mask;
+	volatile uint64 writePos;
+	glog_FlightRecord* records;
+} glog_FlightRing;
+
+static volatile uint32 flightEnabled = 0;
+// Threads in the middle of writing a record. Freeing the rings waits for this to get back to 0.
+static volatile uint32 flightNumWriters = 0;
+// Bumped every time the recorder is freed, so threads know their ring is gone
+static volatile uint32 flightGeneration = 0;
+static uint64 flightNumRecords = 0;
+static volatile int flightRecorderFd = -1;
+// Head of the ring list, a glog_FlightRing*
+static volatile uint64 flightRings = 0;
+
+static GCU_THREAD_LOCAL glog_FlightRing* flightRing = NULL;
+static GCU_THREAD_LOCAL uint32 flightRingGeneration = 0;
+// The record this thread is in the middle of writing
+static GCU_THREAD_LOCAL glog_FlightRecord* flightPending = NULL;
+
+void g_logger_enable_flight_recorder(uint32 numRecordsPerThread, int fileDescriptor)
+{
+	uint64 numRecords = 2;
+	while (numRecords < numRecordsPerThread)
+	{
+		numRecords *= 2;
+	}
+
+	if (gcu_atomic_loadU32(&flightEnabled))
+	{
+		if (numRecords == flightNumRecords)
+		{
+			flightRecorderFd = fileDescriptor;
+			return;
+		}
+
+		// Every ring has the old size, so start over with new ones
+		glog_freeFlightRecorder();
+	}
+
+	flightRecorderFd = fileDescriptor;
+	flightNumRecords = numRecords;
+	gcu_atomic_storeU32(&flightEnabled, 1);
+}
+
+bool _g_logger_isFlightRecording(void)
+{
+	return gcu_atomic_loadU32(&flightEnabled) != 0;
+}
+
+static void glog_freeFlightRecorder(void)
+{
+	gcu_atomic_storeU32(&flightEnabled, 0);
+	gcu_atomic_fence();
+	// Anyone who got in before that is still writing into their ring
+	while (gcu_atomic_loadU32(&flightNumWriters) != 0)
+	{
+		gcu_thread_yield();
+	}
+
+	gcu_atomic_addU32(&flightGeneration, 1);
+	flightRecorderFd = -1;
+
+	glog_FlightRing* ring = (glog_FlightRing*)(uintptr_t)gcu_atomic_loadU64(&flightRings);
+	gcu_atomic_storeU64(&flightRings, 0);
+	while (ring)
+	{
+		glog_FlightRing* next = ring->next;
+		free(ring);
+		ring = next;
+	}
+}
+
+static glog_FlightRing* glog_getFlightRing(void)
+{
+	uint32 generation = gcu_atomic_loadU32(&flightGeneration);
+	if (flightRing && flightRingGeneration == generation)
+	{
+		return flightRing;
+	}
+
+	glog_FlightRing* ring = (glog_FlightRing*)malloc(sizeof(glog_FlightRing) + sizeof(glog_FlightRecord) * flightNumRecords);
+	if (!ring)
+	{
+		return NULL;
+	}
+
+	ring->threadId = gcu_thread_id();
+	ring->mask = flightNumRecords - 1;
+	ring->writePos = 0;
+	ring->records = (glog_FlightRecord*)(ring + 1);
+	for (uint64 i = 0; i < flightNumRecords; i++)
+	{
+		ring->records[i].sequence = 0;
+	}
+
+	uint64 head = gcu_atomic_loadU64(&flightRings);
+	do
+	{
+		ring->next = (glog_FlightRing*)(uintptr_t)head;
+	} while (!gcu_atomic_casU64(&flightRings, &head, (uint64)(uintptr_t)ring));
+
+	flightRing = ring;
+	flightRingGeneration = generation;
+	return ring;
+}
+
+static glog_FlightRecord* glog_beginFlightRecord(const char* filename, int line, g_logger_level level, const char* format, bool isPrintf)
+{
+	// Pairs with the fence in glog_freeFlightRecorder. Either it sees us writing, or we see it turned off.
+	gcu_atomic_addU32(&flightNumWriters, 1);
+	gcu_atomic_fence();
+	glog_FlightRing* ring = gcu_atomic_loadU32(&flightEnabled) ? glog_getFlightRing() : NULL;
+	if (!ring)
+	{
+		gcu_atomic_addU32(&flightNumWriters, (uint32)-1);
+		return NULL;
+	}
+
+	uint64 pos = ring->writePos;
+	glog_FlightRecord* record = ring->records + (pos & ring->mask);
+	gcu_atomic_storeU64(&record->sequence, pos * 2 + 1);
+
+	record->filename = filename;
+	record->format = format;
+	glog_now(&record->time);
+	record->line = (int32)line;
+	record->level = (uint8)level;
+	record->isPrintf = isPrintf;
+	record->numArgs = 0;
+	record->argsDropped = false;
+	record->payloadLength = 0;
+	return record;
+}
+
+static void glog_endFlightRecord(glog_FlightRecord* record)
+{
+	glog_FlightRing* ring = flightRing;
+	uint64 pos = ring->writePos;
+	gcu_atomic_storeU64(&record->sequence, pos * 2 + 2);
+	gcu_atomic_storeU64(&ring->writePos, pos + 1);
+	gcu_atomic_addU32(&flightNumWriters, (uint32)-1);
+}
+
+uint8* _g_logger_beginFlightRecord(const char* filename, int line, g_logger_level level, const char* format, uint8 numArgs, const uint8* argTypes, size_t payloadSize)
+{
+	glog_FlightRecord* record = glog_beginFlightRecord(filename, line, level, format, false);
+	if (!record)
+	{
+		return NULL;
+	}
+
+	if (numArgs > glog_maxFlightArgs || payloadSize > sizeof(record->payload))
+	{
+		// Still worth keeping the record, the format string alone says where we were
+		record->argsDropped = true;
+		glog_endFlightRecord(record);
+		return NULL;
+	}
+
+	record->numArgs = numArgs;
+	record->payloadLength = (uint32)payloadSize;
+	memcpy(record->argTypes, argTypes, numArgs);
+	flightPending = record;
+	return record->payload;
+}
+
+void _g_logger_endFlightRecord(void)
+{
+	glog_endFlightRecord(flightPending);
+	flightPending = NULL;
+}
+
+typedef enum glog_PrintfLength
+{
+	glog_PrintfLength_None = 0,
+	glog_PrintfLength_hh,
+	glog_PrintfLength_h,
+	glog_PrintfLength_l,
+	glog_PrintfLength_ll,
+	glog_PrintfLength_j,
+	glog_PrintfLength_z,
+	glog_PrintfLength_t,
+	glog_PrintfLength_L,
+} glog_PrintfLength;
+
+typedef struct glog_PrintfSpec
+{
+	bool starWidth;
+	bool starPrecision;
+	int precision;
+	glog_PrintfLength length;
+	char conversion;
+} glog_PrintfSpec;
+
+// Parses the conversion spec right after a '%' and returns a pointer to its conversion character.
+// Flags and widths get skipped, the flight recorder doesn't use them.
+static const char* glog_parsePrintfSpec(const char* c, glog_PrintfSpec* spec)
+{
+	spec->starWidth = false;
+	spec->starPrecision = false;
+	spec->precision = -1;
+	spec->length = glog_PrintfLength_None;
+
+	while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0')
+	{
+		c++;
+	}
+
+	if (*c == '*')
+	{
+		spec->starWidth = true;
+		c++;
+	}
+	while (*c >= '0' && *c <= '9')
+	{
+		c++;
+	}
+
+	if (*c == '.')
+	{
+		c++;
+		spec->precision = 0;
+		if (*c == '*')
+		{
+			spec->starPrecision = true;
+			c++;
+		}
+		while (*c >= '0' && *c <= '9')
+		{
+			spec->precision = spec->precision * 10 + (*c - '0');
+			c++;
+		}
+	}
+
+	switch (*c)
+	{
+	case 'h': spec->length = c[1] == 'h' ? glog_PrintfLength_hh : glog_PrintfLength_h; c += c[1] == 'h' ? 2 : 1; break;
+	case 'l': spec->length = c[1] == 'l' ? glog_PrintfLength_ll : glog_PrintfLength_l; c += c[1] == 'l' ? 2 : 1; break;
+	case 'j': spec->length = glog_PrintfLength_j; c++; break;
+	case 'z': spec->length = glog_PrintfLength_z; c++; break;
+	case 't': spec->length = glog_PrintfLength_t; c++; break;
+	case 'L': spec->length = glog_PrintfLength_L; c++; break;
+	default: break;
+	}
+
+	spec->conversion = *c;
+	return c;
+}
+
+static bool glog_pushFlightArg(glog_FlightRecord* record, glog_ArgType type, const void* data, size_t size)
+{
+	if (record->numArgs >= glog_maxFlightArgs || record->payloadLength + size > sizeof(record->payload))
+	{
+		record->argsDropped = true;
+		return false;
+	}
+
+	memcpy(record->payload + record->payloadLength, data, size);
+	record->payloadLength += (uint32)size;
+	record->argTypes[record->numArgs++] = (uint8)type;
+	return true;
+}
+
+// Strings are copied in the same layout cppPrint style records use, truncated to whatever room is left.
+// A precision (-1 for none) cuts them off too, the string doesn't have to be null terminated then.
+static bool glog_pushFlightString(glog_FlightRecord* record, const char* str, int64 precision)
+{
+	if (!str)
+	{
+		str = "(null)";
+	}
+
+	size_t room = sizeof(record->payload) - record->payloadLength;
+	if (record->numArgs >= glog_maxFlightArgs || room < sizeof(uint32) + 1)
+	{
+		record->argsDropped = true;
+		return false;
+	}
+
+	size_t maxLength = room - sizeof(uint32) - 1;
+	if (precision >= 0 && (uint64)precision < maxLength)
+	{
+		maxLength = (size_t)precision;
+	}
+	uint32 length = 0;
+	while (length < maxLength && str[length])
+	{
+		length++;
+	}
+
+	uint8* cursor = record->payload + record->payloadLength;
+	memcpy(cursor, &length, sizeof(uint32));
+	memcpy(cursor + sizeof(uint32), str, length);
+	cursor[sizeof(uint32) + length] = '\0';
+	record->payloadLength += (uint32)(sizeof(uint32) + length + 1);
+	record->argTypes[record->numArgs++] = (uint8)glog_ArgType_String;
+	return true;
+}
+
+static void glog_recordFlight(const char* filename, int line, g_logger_level level, const char* format, va_list args)
+{
+	glog_FlightRecord* record = glog_beginFlightRecord(filename, line, level, format, true);
+	if (!record)
+	{
+		return;
+	}
+
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+
+	bool capturing = true;
+	for (const char* c = format; capturing && *c; c++)
+	{
+		if (*c != '%')
+		{
+			continue;
+		}
+		if (c[1] == '%')
+		{
+			c++;
+			continue;
+		}
+
+		glog_PrintfSpec spec;
+		c = glog_parsePrintfSpec(c + 1, &spec);
+		if (*c == '\0')
+		{
+			break;
+		}
+
+		if (spec.starWidth)
+		{
+			int64 width = va_arg(argsCopy, int);
+			capturing = glog_pushFlightArg(record, glog_ArgType_I64, &width, sizeof(width));
+		}
+		int64 precision = spec.precision;
+		if (capturing && spec.starPrecision)
+		{
+			precision = va_arg(argsCopy, int);
+			capturing = glog_pushFlightArg(record, glog_ArgType_I64, &precision, sizeof(precision));
+		}
+		if (!capturing)
+		{
+			break;
+		}
+
+		switch (spec.conversion)
+		{
+		case 'd': case 'i':
+		{
+			int64 value;
+			switch (spec.length)
+			{
+			case glog_PrintfLength_l: value = (int64)va_arg(argsCopy, long); break;
+			case glog_PrintfLength_ll: value = (int64)va_arg(argsCopy, long long); break;
+			case glog_PrintfLength_j: value = (int64)va_arg(argsCopy, intmax_t); break;
+			case glog_PrintfLength_z: value = (int64)va_arg(argsCopy, size_t); break;
+			case glog_PrintfLength_t: value = (int64)va_arg(argsCopy, ptrdiff_t); break;
+			default: value = (int64)va_arg(argsCopy, int); break;
+			}
+			capturing = glog_pushFlightArg(record, glog_ArgType_I64, &value, sizeof(value));
+			break;
+		}
+		case 'u': case 'x': case 'X': case 'o':
+		{
+			uint64 value;
+			switch (spec.length)
+			{
+			case glog_PrintfLength_l: value = (uint64)va_arg(argsCopy, unsigned long); break;
+			case glog_PrintfLength_ll: value = (uint64)va_arg(argsCopy, unsigned long long); break;
+			case glog_PrintfLength_j: value = (uint64)va_arg(argsCopy, uintmax_t); break;
+			case glog_PrintfLength_z: value = (uint64)va_arg(argsCopy, size_t); break;
+			case glog_PrintfLength_t: value = (uint64)va_arg(argsCopy, ptrdiff_t); break;
+			case glog_PrintfLength_hh: value = (uint64)(unsigned char)va_arg(argsCopy, unsigned int); break;
+			case glog_PrintfLength_h: value = (uint64)(unsigned short)va_arg(argsCopy, unsigned int); break;
+			default: value = (uint64)va_arg(argsCopy, unsigned int); break;
+			}
+			capturing = glog_pushFlightArg(record, glog_ArgType_U64, &value, sizeof(value));
+			break;
+		}
+		case 'c':
+		{
+			char value = (char)va_arg(argsCopy, int);
+			capturing = glog_pushFlightArg(record, glog_ArgType_Char, &value, sizeof(value));
+			break;
+		}
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		{
+			double value = spec.length == glog_PrintfLength_L ? (double)va_arg(argsCopy, long double) : va_arg(argsCopy, double);
+			capturing = glog_pushFlightArg(record, glog_ArgType_F64, &value, sizeof(value));
+			break;
+		}
+		case 's':
+			capturing = glog_pushFlightString(record, va_arg(argsCopy, const char*), precision);
+			break;
+		case 'p':
+		{
+			const void* value = va_arg(argsCopy, const void*);
+			capturing = glog_pushFlightArg(record, glog_ArgType_Pointer, &value, sizeof(value));
+			break;
+		}
+		case 'n':
+			(void)va_arg(argsCopy, void*);
+			break;
+		default:
+			// Don't know what type this one takes, so nothing after it can be read either
+			record->argsDropped = true;
+			capturing = false;
+			break;
+		}
+	}
+
+	va_end(argsCopy);
+	glog_endFlightRecord(record);
+}
+
+#ifndef USE_GABE_CPP_PRINT
+void _g_logger_cStdDebug(g_logger_site* site, const char* format, ...)
+{
+	if (!gcu_atomic_loadU32(&flightEnabled))
+	{
+		return;
+	}
+
+	glog_registerSiteIfNeeded(site, format);
+
+	va_list args;
+	va_start(args, format);
+	glog_recordFlight(site->filename, site->line, g_logger_level_All, format, args);
+	va_end(args);
+}
+#endif
+
+typedef struct glog_FlightArg
+{
+	glog_ArgType type;
+	union
+	{
+		int64 i;
+		uint64 u;
+		double f;
+		const char* s;
+	} value;
+} glog_FlightArg;
+
+// Reads argument argIndex, which starts at *offset, out of a payload laid out the way cppPrint binary
+// records lay them out. Flight records and deferred records both use this.
+static bool glog_readArg(const uint8* argTypes, uint32 numArgs, const uint8* payload, uint32 payloadLength, uint32 argIndex, uint32* offset, glog_FlightArg* out)
+{
+	if (argIndex >= numArgs)
+	{
+		return false;
+	}
+
+	out->type = (glog_ArgType)argTypes[argIndex];
+	const uint8* cursor = payload + *offset;
+	size_t remaining = payloadLength - *offset;
+	size_t size = 0;
+	switch (out->type)
+	{
+	case glog_ArgType_I8: case glog_ArgType_U8: case glog_ArgType_Bool: case glog_ArgType_Char: size = 1; break;
+	case glog_ArgType_I16: case glog_ArgType_U16: size = 2; break;
+	case glog_ArgType_I32: case glog_ArgType_U32: case glog_ArgType_F32: size = 4; break;
+	case glog_ArgType_I64: case glog_ArgType_U64: case glog_ArgType_F64: size = 8; break;
+	case glog_ArgType_Pointer: size = sizeof(const void*); break;
+	case glog_ArgType_String:
+	{
+		uint32 length = 0;
+		if (remaining >= sizeof(uint32))
+		{
+			memcpy(&length, cursor, sizeof(uint32));
+		}
+		size = sizeof(uint32) + (size_t)length + 1;
+		break;
+	}
+	default:
+		return false;
+	}
+
+	if (size > remaining)
+	{
+		return false;
+	}
+
+	switch (out->type)
+	{
+	case glog_ArgType_I8: { int8 v; memcpy(&v, cursor, sizeof(v)); out->value.i = v; break; }
+	case glog_ArgType_I16: { int16 v; memcpy(&v, cursor, sizeof(v)); out->value.i = v; break; }
+	case glog_ArgType_I32: { int32 v; memcpy(&v, cursor, sizeof(v)); out->value.i = v; break; }
+	case glog_ArgType_I64: { int64 v; memcpy(&v, cursor, sizeof(v)); out->value.i = v; break; }
+	case glog_ArgType_U8: { uint8 v; memcpy(&v, cursor, sizeof(v)); out->value.u = v; break; }
+	case glog_ArgType_U16: { uint16 v; memcpy(&v, cursor, sizeof(v)); out->value.u = v; break; }
+	case glog_ArgType_U32: { uint32 v; memcpy(&v, cursor, sizeof(v)); out->value.u = v; break; }
+	case glog_ArgType_U64: { uint64 v; memcpy(&v, cursor, sizeof(v)); out->value.u = v; break; }
+	case glog_ArgType_F32: { float v; memcpy(&v, cursor, sizeof(v)); out->value.f = v; break; }
+	case glog_ArgType_F64: { double v; memcpy(&v, cursor, sizeof(v)); out->value.f = v; break; }
+	case glog_ArgType_Bool: { bool v; memcpy(&v, cursor, sizeof(v)); out->value.u = v ? 1 : 0; break; }
+	case glog_ArgType_Char: { char v; memcpy(&v, cursor, sizeof(v)); out->value.i = v; break; }
+	case glog_ArgType_Pointer: { const void* v; memcpy(&v, cursor, sizeof(v)); out->value.u = (uint64)(uintptr_t)v; break; }
+	case glog_ArgType_String: out->value.s = (const char*)(cursor + sizeof(uint32)); break;
+	default: break;
+	}
+
+	*offset += (uint32)size;
+	return true;
+}
+
+static bool glog_readFlightArg(const glog_FlightRecord* record, uint32 argIndex, uint32* offset, glog_FlightArg* out)
+{
+	return glog_readArg(record->argTypes, record->numArgs, record->payload, record->payloadLength, argIndex, offset, out);
+}
+
+// cppPrint style, or printf style when conversion isn't 0
+static void glog_appendFlightArg(gma_CrashLine* line, const glog_FlightArg* arg, char conversion, int precision)
+{
+	switch (arg->type)
+	{
+	case glog_ArgType_I8: case glog_ArgType_I16: case glog_ArgType_I32: case glog_ArgType_I64:
+		if (conversion == 'x' || conversion == 'X')
+		{
+			gma_CrashLine_appendBase(line, (uint64)arg->value.i, 16, conversion == 'X');
+		}
+		else
+		{
+			gma_CrashLine_appendInt(line, arg->value.i);
+		}
+		break;
+	case glog_ArgType_U8: case glog_ArgType_U16: case glog_ArgType_U32: case glog_ArgType_U64:
+		if (conversion == 'x' || conversion == 'X' || conversion == 'o')
+		{
+			gma_CrashLine_appendBase(line, arg->value.u, conversion == 'o' ? 8 : 16, conversion == 'X');
+		}
+		else
+		{
+			gma_CrashLine_appendUint(line, arg->value.u);
+		}
+		break;
+	case glog_ArgType_F32: case glog_ArgType_F64:
+		gma_CrashLine_appendDouble(line, arg->value.f, precision, conversion ? conversion : 'g');
+		break;
+	case glog_ArgType_Bool:
+		gma_CrashLine_appendStr(line, arg->value.u ? "true" : "false");
+		break;
+	case glog_ArgType_Char:
+		gma_CrashLine_appendChar(line, (char)arg->value.i);
+		break;
+	case glog_ArgType_Pointer:
+		gma_CrashLine_appendPtr(line, (const void*)(uintptr_t)arg->value.u);
+		break;
+	case glog_ArgType_String:
+		gma_CrashLine_appendStr(line, arg->value.s);
+		break;
+	default:
+		break;
+	}
+}
+
+// Keeps long messages from running off the end of the line buffer
+static void glog_flushFlightLineIfFull(gma_CrashLine* line, int fd)
+{
+	if (line->length > sizeof(line->data) / 2)
+	{
+		gma_CrashLine_flush(line, fd);
+	}
+}
+
+static void glog_appendFlightMessage(gma_CrashLine* line, int fd, const glog_FlightRecord* record)
+{
+	uint32 argIndex = 0;
+	uint32 offset = 0;
+	glog_FlightArg arg;
+	for (const char* c = record->format; c && *c; c++)
+	{
+		glog_flushFlightLineIfFull(line, fd);
+
+		if (record->isPrintf)
+		{
+			if (*c != '%')
+			{
+				gma_CrashLine_appendChar(line, *c);
+				continue;
+			}
+			if (c[1] == '%')
+			{
+				gma_CrashLine_appendChar(line, '%');
+				c++;
+				continue;
+			}
+
+			glog_PrintfSpec spec;
+			c = glog_parsePrintfSpec(c + 1, &spec);
+			if (*c == '\0')
+			{
+				break;
+			}
+
+			int precision = spec.precision;
+			if (spec.starWidth && glog_readFlightArg(record, argIndex, &offset, &arg))
+			{
+				argIndex++;
+			}
+			if (spec.starPrecision && glog_readFlightArg(record, argIndex, &offset, &arg))
+			{
+				argIndex++;
+				precision = (int)arg.value.i;
+			}
+
+			if (spec.conversion == 'n')
+			{
+				continue;
+			}
+			if (glog_readFlightArg(record, argIndex, &offset, &arg))
+			{
+				argIndex++;
+				glog_appendFlightArg(line, &arg, spec.conversion, precision);
+			}
+			else
+			{
+				gma_CrashLine_appendStr(line, "<?>");
+			}
+		}
+		else
+		{
+			if (*c != '{')
+			{
+				gma_CrashLine_appendChar(line, *c);
+				continue;
+			}
+
+			while (*c && *c != '}')
+			{
+				c++;
+			}
+			if (glog_readFlightArg(record, argIndex, &offset, &arg))
+			{
+				argIndex++;
+				glog_appendFlightArg(line, &arg, 0, -1);
+			}
+			else
+			{
+				gma_CrashLine_appendStr(line, "{?}");
+			}
+			if (*c == '\0')
+			{
+				break;
+			}
+		}
+	}
+
+	if (record->argsDropped)
+	{
+		gma_CrashLine_appendStr(line, " (some arguments weren't recorded)");
+	}
+}
+
+static void glog_writeFlightRecord(gma_CrashLine* line, int fd, const glog_FlightRecord* record)
+{
+	gma_CrashLine_appendChar(line, '[');
+	gma_CrashLine_appendInt(line, record->time.seconds);
+	gma_CrashLine_appendChar(line, '.');
+	for (uint32 divisor = 100000; divisor > 0; divisor /= 10)
+	{
+		gma_CrashLine_appendChar(line, (char)('0' + (record->time.microseconds / divisor) % 10));
+	}
+	gma_CrashLine_appendStr(line, "] ");
+	gma_CrashLine_appendStr(line, record->level == g_logger_level_All ? "debug" : glog_levelName((g_logger_level)record->level));
+	gma_CrashLine_appendChar(line, ' ');
+	gma_CrashLine_appendStr(line, record->filename);
+	gma_CrashLine_appendStr(line, " (line ");
+	gma_CrashLine_appendInt(line, record->line);
+	gma_CrashLine_appendStr(line, "): ");
+	glog_appendFlightMessage(line, fd, record);
+	gma_CrashLine_appendChar(line, '\n');
+	gma_CrashLine_flush(line, fd);
+}
+
+void g_logger_write_flight_recorder(int fd)
+{
+	if (fd < 0)
+	{
+		return;
+	}
+
+	gma_CrashLine line;
+	line.length = 0;
+	gma_CrashLine_appendStr(&line, "==== g_logger flight recorder ====\n");
+	gma_CrashLine_flush(&line, fd);
+
+	for (glog_FlightRing* ring = (glog_FlightRing*)(uintptr_t)gcu_atomic_loadU64(&flightRings); ring; ring = ring->next)
+	{
+		uint64 writePos = gcu_atomic_loadU64(&ring->writePos);
+		uint64 numSlots = ring->mask + 1;
+		uint64 firstPos = writePos > numSlots ? writePos - numSlots : 0;
+
+		gma_CrashLine_appendStr(&line, "---- Thread ");
+		gma_CrashLine_appendUint(&line, ring->threadId);
+		gma_CrashLine_appendStr(&line, ", last ");
+		gma_CrashLine_appendUint(&line, writePos - firstPos);
+		gma_CrashLine_appendStr(&line, " of ");
+		gma_CrashLine_appendUint(&line, writePos);
+		gma_CrashLine_appendStr(&line, " records ----\n");
+		gma_CrashLine_flush(&line, fd);
+
+		for (uint64 pos = firstPos; pos < writePos; pos++)
+		{
+			const glog_FlightRecord* slot = ring->records + (pos & ring->mask);
+			uint64 sequence = gcu_atomic_loadU64(&slot->sequence);
+			if (sequence != pos * 2 + 2)
+			{
+				// Being written right now, or already overwritten by a newer record
+				continue;
+			}
+
+			glog_FlightRecord record;
+			memcpy(&record, (const void*)slot, sizeof(record));
+			if (gcu_atomic_loadU64(&slot->sequence) != sequence)
+			{
+				continue;
+			}
+
+			glog_writeFlightRecord(&line, fd, &record);
+		}
+	}
+
+	gma_CrashLine_appendStr(&line, "==== end of g_logger flight recorder ====\n");
+	gma_CrashLine_flush(&line, fd);
+}
+
+static void glog_dumpFlightRecorder(void)
+{
+	if (gcu_atomic_loadU32(&flightEnabled))
+	{
+		g_logger_write_flight_recorder(flightRecorderFd);
+	}
+}
+
+// ----------------------------------
+// Async Logging Implementation Common C11
+// ----------------------------------
+// A bounded multi-producer/single-consumer ring (Dmitry Vyukov's bounded queue with one consumer).
+// Every slot carries a sequence number. A producer owns slot `pos` once it wins the CAS on enqueuePos
+// while slot.sequence == pos, formats the message directly into the slot, then publishes it by setting
+// slot.sequence = pos + 1. The writer thread consumes the slot when it sees that and hands it back to
+// producers by setting slot.sequence = pos + numSlots. Producers never take a lock or make a syscall.
+typedef struct glog_Record
+{
+	const char* filename;
+	int line;
+	g_logger_level level;
+	glog_Color color;
+	glog_Timestamp time;
+	uint64 threadId;
+	// Non-zero for deferred records. Then message holds the raw argument bytes instead of text.
+	uint32 siteId;
+	uint32 messageLength;
+	// Fields from the *_kv macros as a JSON fragment, stored right after the message
+	uint32 fieldsLength;
+	char message[GABE_LOGGER_ASYNC_MESSAGE_SIZE];
+} glog_Record;
+
+typedef struct glog_RingSlot
+{
+	volatile uint64 sequence;
+	glog_Record record;
+} glog_RingSlot;
+
+typedef struct glog_AsyncRing
+{
+	glog_RingSlot* slots;
+	uint64 mask;
+	g_logger_overflow_policy policy;
+	void* writerThread;
+	volatile uint32 running;
+
+	uint8 pad0[GABE_CPP_UTILS_CACHE_LINE_SIZE];
+	// Written by every producer
+	volatile uint64 enqueuePos;
+	// Producers in the middle of a push. g_logger_disable_async waits for this to hit zero before it
+	// frees the slots.
+	volatile uint32 numProducers;
+	uint8 pad1[GABE_CPP_UTILS_CACHE_LINE_SIZE - sizeof(uint64) - sizeof(uint32)];
+	// Only written by the writer thread
+	volatile uint64 dequeuePos;
+	volatile uint64 flushedPos;
+	uint8 pad2[GABE_CPP_UTILS_CACHE_LINE_SIZE - sizeof(uint64) * 2];
+	volatile uint64 numDropped;
+} glog_AsyncRing;
+
+static glog_AsyncRing asyncRing;
+static volatile uint32 asyncEnabled = 0;
+
+// Implemented per platform below. Called with logMutex held.
+static void glog_writeRecord(const glog_Record* record);
+
+// For the logger's own warnings and errors. Goes to the sinks like any other record, so it has to be
+// called with logMutex held too.
+static void glog_writeNotice(g_logger_level level, const char* filename, int line, const char* format, ...)
+{
+	glog_Record notice;
+	notice.filename = glog_basename(filename);
+	notice.line = line;
+	notice.level = level;
+	notice.color = glog_levelColor(level);
+	glog_now(&notice.time);
+	notice.threadId = gcu_thread_id();
+	notice.siteId = 0;
+	notice.fieldsLength = 0;
+
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(notice.message, sizeof(notice.message), format, args);
+	va_end(args);
+	if (length < 0)
+	{
+		length = 0;
+	}
+	else if ((size_t)length >= sizeof(notice.message))
+	{
+		length = (int)sizeof(notice.message) - 1;
+	}
+	notice.messageLength = (uint32)length;
+	glog_writeRecord(&notice);
+}
+
+// Every push happens between these two. Producers register before they look at asyncEnabled, so once
+// g_logger_disable_async clears the flag and sees no producers, nobody can still be writing a slot.
+// Returns false if async mode is off, in which case the caller logs synchronously instead.
+static bool glog_AsyncRing_enter(void)
+{
+	gcu_atomic_addU32(&asyncRing.numProducers, 1);
+	gcu_atomic_fence();
+	if (gcu_atomic_loadU32(&asyncEnabled))
+	{
+		return true;
+	}
+
+	gcu_atomic_addU32(&asyncRing.numProducers, (uint32)-1);
+	return false;
+}
+
+static void glog_AsyncRing_leave(void)
+{
+	gcu_atomic_addU32(&asyncRing.numProducers, (uint32)-1);
+}
+
+// Returns NULL if the ring is full and the policy says to drop the message
+static glog_RingSlot* glog_AsyncRing_beginPush(void)
+{
+	uint64 pos = gcu_atomic_loadU64(&asyncRing.enqueuePos);
+	for (;;)
+	{
+		glog_RingSlot* slot = asyncRing.slots + (pos & asyncRing.mask);
+		uint64 sequence = gcu_atomic_loadU64(&slot->sequence);
+		int64 diff = (int64)sequence - (int64)pos;
+		if (diff == 0)
+		{
+			// On failure pos gets updated with the current value, so just try again
+			if (gcu_atomic_casU64(&asyncRing.enqueuePos, &pos, pos + 1))
+			{
+				return slot;
+			}
+		}
+		else if (diff < 0)
+		{
+			// The writer thread hasn't consumed this slot yet, so the ring is full
+			// Nobody is left to make room once the writer thread stops, so blocking would be forever
+			if (asyncRing.policy == g_logger_overflow_Block && gcu_atomic_loadU32(&asyncRing.running))
+			{
+				gcu_thread_yield();
+				pos = gcu_atomic_loadU64(&asyncRing.enqueuePos);
+				continue;
+			}
+
+			if (asyncRing.policy == g_logger_overflow_DropAndCount)
+			{
+				gcu_atomic_addU64(&asyncRing.numDropped, 1);
+			}
+			return NULL;
+		}
+		else
+		{
+			// Another producer claimed this slot first
+			pos = gcu_atomic_loadU64(&asyncRing.enqueuePos);
+		}
+	}
+}
+
+static void glog_AsyncRing_endPush(glog_RingSlot* slot)
+{
+	// We own the slot, so sequence is still the position we claimed
+	gcu_atomic_storeU64(&slot->sequence, slot->sequence + 1);
+}
+
+// Returns false if async mode got turned off, and the caller should log synchronously instead
+static bool glog_pushAsync(const char* filename, int line, g_logger_level level, glog_Color color, const g_logger_kv* fields, uint32 numFields, const char* format, va_list args)
+{
+	if (!glog_AsyncRing_enter())
+	{
+		return false;
+	}
+
+	glog_RingSlot* slot = glog_AsyncRing_beginPush();
+	if (slot == NULL)
+	{
+		glog_AsyncRing_leave();
+		return true;
+	}
+
+	glog_Record* record = &slot->record;
+	record->filename = filename;
+	record->line = line;
+	record->level = level;
+	record->color = color;
+	record->threadId = gcu_thread_id();
+	record->siteId = 0;
+	record->fieldsLength = 0;
+	glog_now(&record->time);
+
+	int length = vsnprintf(record->message, sizeof(record->message), format, args);
+	if (length < 0)
+	{
+		length = 0;
+	}
+	else if ((size_t)length >= sizeof(record->message))
+	{
+		length = (int)sizeof(record->message) - 1;
+	}
+	record->messageLength = (uint32)length;
+
+	if (numFields > 0)
+	{
+		// The fields get at most half the slot. Past that, keep the leading fields that fit whole and
+		// mark the rest as cut off, so the pipeline still gets valid JSON and knows something's missing.
+		static const char truncatedMarker[] = ",\"_truncated\":true";
+		size_t maxFieldsLength = sizeof(record->message) / 2;
+		size_t keptLength = 0;
+
+		glog_Line fieldsLine;
+		glog_Line_beginIn(&fieldsLine, jsonLineBuffer, sizeof(jsonLineBuffer));
+		for (uint32 i = 0; i < numFields; i++)
+		{
+			if (i > 0)
+			{
+				glog_Line_append(&fieldsLine, ",", 1);
+			}
+			glog_Line_appendJsonFields(&fieldsLine, fields + i, 1);
+			if (fieldsLine.length + sizeof(truncatedMarker) - 1 <= maxFieldsLength)
+			{
+				keptLength = fieldsLine.length;
+			}
+		}
+
+		if (fieldsLine.length > maxFieldsLength)
+		{
+			// Skip the leading comma when not a single field fit
+			fieldsLine.length = keptLength;
+			size_t markerStart = keptLength == 0 ? 1 : 0;
+			glog_Line_append(&fieldsLine, truncatedMarker + markerStart, sizeof(truncatedMarker) - 1 - markerStart);
+		}
+
+		// Truncate the message to make room, the fields are usually what the pipeline is after
+		if (record->messageLength + fieldsLine.length > sizeof(record->message))
+		{
+			record->messageLength = (uint32)(sizeof(record->message) - fieldsLine.length);
+		}
+		memcpy(record->message + record->messageLength, fieldsLine.data, fieldsLine.length);
+		record->fieldsLength = (uint32)fieldsLine.length;
+		glog_Line_end(&fieldsLine);
+	}
+
+	glog_AsyncRing_endPush(slot);
+	glog_AsyncRing_leave();
+	return true;
+}
+
+// Appends the record's message, plus " {fields}" if it came from one of the *_kv macros
+static void glog_Line_appendRecordMessage(glog_Line* line, const glog_Record* record)
+{
+	glog_Line_append(line, record->message, record->messageLength);
+	if (record->fieldsLength > 0)
+	{
+		glog_Line_append(line, " {", 2);
+		glog_Line_append(line, record->message + record->messageLength, record->fieldsLength);
+		glog_Line_append(line, "}", 1);
+	}
+}
+
+static void glog_writeRecordJson(const glog_Record* record)
+{
+	glog_writeJson(record->filename, record->line, record->level, &record->time, record->threadId,
+		record->message, record->messageLength, NULL,
+		record->message + record->messageLength, record->fieldsLength);
+}
+
+// ----------------------------------
+// io_uring Log Writer Implementation Linux
+// ----------------------------------
+// With g_logger_set_io_uring_writer on, the async writer thread never calls write(2) for file sinks. It
+// copies every record into one of two registered buffers, and once per batch submits the buffer as a
+// chain of linked IORING_OP_WRITE_FIXED requests (plus fdatasyncs, depending on the fsync policy). The
+// kernel works on one buffer while the writer fills the other.
+//
+// The writes use offset -1, which means "at the file position" just like write(2). Linking keeps the
+// writes of a buffer in order, and a buffer is only submitted once the one before it has completed. So
+// if a write comes back short (which also cancels the rest of the chain) the writer can finish that
+// buffer with plain writes without anything landing out of order. Only the writer thread touches the
+// ring. Every other thread keeps writing directly, that only happens for assertion failures, which
+// flush first.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define GLOG_HAS_IO_URING
+#endif
+#endif
+
+static volatile uint32 uringRequested = 0;
+static g_logger_fsync_policy uringFsyncPolicy = g_logger_fsync_Never;
+static uint32 uringFsyncIntervalMs = 0;
+
+#ifdef GLOG_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+
+#define glog_uringQueueDepth 64
+#define glog_uringMaxExtents 32
+// Extent index for fsyncs in user_data
+#define glog_uringFsyncIndex 0xFF
+
+// A run of bytes in a buffer that all go to the same file
+typedef struct glog_UringExtent
+{
+	int fd;
+	uint32 start;
+	uint32 length;
+	int32 result;
+} glog_UringExtent;
+
+typedef struct glog_UringBuffer
+{
+	char* data;
+	uint32 length;
+	glog_UringExtent extents[glog_uringMaxExtents];
+	uint32 numExtents;
+	// Completions still to come, writes and fsyncs
+	uint32 numPending;
+	// The async ring position that's written once this buffer completes
+	uint64 flushPos;
+} glog_UringBuffer;
+
+typedef struct glog_Uring
+{
+	int ringFd;
+	bool fixedBuffers;
+
+	void* sqRing;
+	size_t sqRingSize;
+	void* cqRing;
+	size_t cqRingSize;
+	struct io_uring_sqe* sqes;
+	size_t sqesSize;
+
+	volatile uint32* sqHead;
+	volatile uint32* sqTail;
+	uint32 sqMask;
+	uint32* sqArray;
+	volatile uint32* cqHead;
+	volatile uint32* cqTail;
+	uint32 cqMask;
+	struct io_uring_cqe* cqes;
+
+	glog_UringBuffer buffers[2];
+	// The buffer being filled. The other one is either with the kernel or empty.
+	uint32 current;
+	uint64 completedPos;
+
+	int dirtyFds[GABE_LOGGER_MAX_SINKS];
+	uint32 numDirtyFds;
+	uint64 lastFsyncNs;
+} glog_Uring;
+
+// Only ever touched by the writer thread
+static glog_Uring uring;
+static GCU_THREAD_LOCAL bool isUringWriter = false;
+
+static int glog_Uring_enter(uint32 toSubmit, uint32 minComplete)
+{
+	int result;
+	do
+	{
+		result = (int)syscall(__NR_io_uring_enter, uring.ringFd, toSubmit, minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	} while (result < 0 && errno == EINTR);
+	return result;
+}
+
+static struct io_uring_sqe* glog_Uring_nextSqe(uint32 index)
+{
+	uint32 tail = *uring.sqTail + index;
+	struct io_uring_sqe* sqe = uring.sqes + (tail & uring.sqMask);
+	memset(sqe, 0, sizeof(*sqe));
+	uring.sqArray[tail & uring.sqMask] = tail & uring.sqMask;
+	return sqe;
+}
+
+// Finishes whatever the kernel didn't write, in order. Only called once every request is back.
+static void glog_Uring_finishBuffer(glog_UringBuffer* buffer)
+{
+	for (uint32 i = 0; i < buffer->numExtents; i++)
+	{
+		glog_UringExtent* extent = buffer->extents + i;
+		uint32 written = extent->result > 0 ? (uint32)extent->result : 0;
+		if (written < extent->length)
+		{
+			gcu_writeAll(extent->fd, buffer->data + extent->start + written, extent->length - written);
+		}
+	}
+
+	buffer->length = 0;
+	buffer->numExtents = 0;
+	uring.completedPos = buffer->flushPos;
+}
+
+static void glog_Uring_reap(bool wait)
+{
+	uint32 head = *uring.cqHead;
+	if (wait && head == gcu_atomic_loadU32(uring.cqTail))
+	{
+		glog_Uring_enter(0, 1);
+	}
+
+	uint32 tail = gcu_atomic_loadU32(uring.cqTail);
+	for (; head != tail; head++)
+	{
+		const struct io_uring_cqe* cqe = uring.cqes + (head & uring.cqMask);
+		glog_UringBuffer* buffer = uring.buffers + (cqe->user_data >> 8);
+		uint32 extentIndex = (uint32)(cqe->user_data & 0xFF);
+		if (extentIndex != glog_uringFsyncIndex)
+		{
+			buffer->extents[extentIndex].result = cqe->res;
+		}
+
+		buffer->numPending--;
+		if (buffer->numPending == 0)
+		{
+			glog_Uring_finishBuffer(buffer);
+		}
+	}
+	gcu_atomic_storeU32(uring.cqHead, head);
+}
+
+static void glog_Uring_waitBuffer(const glog_UringBuffer* buffer)
+{
+	while (buffer->numPending > 0)
+	{
+		glog_Uring_reap(true);
+	}
+}
+
+static bool glog_Uring_fsyncDue(void)
+{
+	switch (uringFsyncPolicy)
+	{
+	case g_logger_fsync_EveryBatch:
+		return true;
+	case g_logger_fsync_Interval:
+		return glog_monotonicNs() - uring.lastFsyncNs >= (uint64)uringFsyncIntervalMs * 1000000ull;
+	default:
+		return false;
+	}
+}
+
+// Hands the buffer being filled to the kernel. flushPos is how far the async ring will be written
+// once it completes.
+static void glog_Uring_submit(uint64 flushPos)
+{
+	uint32 bufferIndex = uring.current;
+	glog_UringBuffer* buffer = uring.buffers + bufferIndex;
+	if (!isUringWriter || buffer->numExtents == 0)
+	{
+		return;
+	}
+
+	// Keeps every file in order, the previous buffer has to land first
+	glog_Uring_waitBuffer(uring.buffers + (bufferIndex ^ 1));
+
+	bool fsync = uring.numDirtyFds > 0 && glog_Uring_fsyncDue();
+	uint32 numRequests = buffer->numExtents + (fsync ? uring.numDirtyFds : 0);
+	for (uint32 i = 0; i < numRequests; i++)
+	{
+		struct io_uring_sqe* sqe = glog_Uring_nextSqe(i);
+		if (i < buffer->numExtents)
+		{
+			const glog_UringExtent* extent = buffer->extents + i;
+			sqe->opcode = uring.fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+			sqe->fd = extent->fd;
+			sqe->addr = (uint64)(uintptr_t)(buffer->data + extent->start);
+			sqe->len = extent->length;
+			sqe->off = (uint64)-1;
+			sqe->buf_index = uring.fixedBuffers ? (uint16)bufferIndex : 0;
+			sqe->user_data = ((uint64)bufferIndex << 8) | i;
+		}
+		else
+		{
+			sqe->opcode = IORING_OP_FSYNC;
+			sqe->fd = uring.dirtyFds[i - buffer->numExtents];
+			sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+			sqe->user_data = ((uint64)bufferIndex << 8) | glog_uringFsyncIndex;
+		}
+
+		if (i + 1 < numRequests)
+		{
+			sqe->flags = IOSQE_IO_LINK;
+		}
+	}
+
+	uint32 tail = *uring.sqTail;
+	gcu_atomic_storeU32(uring.sqTail, tail + numRequests);
+	int numSubmitted = glog_Uring_enter(numRequests, 0);
+	if (numSubmitted < 0)
+	{
+		numSubmitted = 0;
+	}
+
+	if ((uint32)numSubmitted < numRequests)
+	{
+		// Take back whatever the kernel didn't consume, finishBuffer writes those extents by hand
+		gcu_atomic_storeU32(uring.sqTail, tail + (uint32)numSubmitted);
+		for (uint32 i = (uint32)numSubmitted; i < buffer->numExtents; i++)
+		{
+			buffer->extents[i].result = 0;
+		}
+	}
+
+	if (fsync)
+	{
+		uring.numDirtyFds = 0;
+		uring.lastFsyncNs = glog_monotonicNs();
+	}
+
+	buffer->flushPos = flushPos;
+	buffer->numPending = (uint32)numSubmitted;
+	if (buffer->numPending == 0)
+	{
+		glog_Uring_finishBuffer(buffer);
+	}
+	uring.current = bufferIndex ^ 1;
+}
+
+// Waits until everything staged so far is written
+static void glog_Uring_waitIdle(void)
+{
+	if (!isUringWriter)
+	{
+		return;
+	}
+
+	glog_Uring_submit(asyncRing.dequeuePos);
+	glog_Uring_waitBuffer(uring.buffers);
+	glog_Uring_waitBuffer(uring.buffers + 1);
+}
+
+static bool glog_Uring_isBusy(void)
+{
+	return isUringWriter && (uring.buffers[0].numPending > 0 || uring.buffers[1].numPending > 0);
+}
+
+// The async ring position that's actually been written, for g_logger_flush
+static uint64 glog_Uring_flushedPos(uint64 dequeuePos)
+{
+	if (!isUringWriter)
+	{
+		return dequeuePos;
+	}
+
+	return glog_Uring_isBusy() || uring.buffers[uring.current].numExtents > 0 ? uring.completedPos : dequeuePos;
+}
+
+// Returns false when the record wasn't staged and has to be written the normal way
+static bool glog_Uring_stage(int fd, const glog_Span* parts, size_t numParts)
+{
+	if (!isUringWriter)
+	{
+		return false;
+	}
+
+	size_t length = glog_Span_totalLength(parts, numParts);
+	if (length > GABE_LOGGER_URING_BUFFER_SIZE)
+	{
+		// Too big to stage. Everything before it has to be written first, then the caller writes it.
+		glog_Uring_waitIdle();
+		return false;
+	}
+
+	glog_UringBuffer* buffer = uring.buffers + uring.current;
+	bool extendsLast = buffer->numExtents > 0 && buffer->extents[buffer->numExtents - 1].fd == fd;
+	if (buffer->length + length > GABE_LOGGER_URING_BUFFER_SIZE || (!extendsLast && buffer->numExtents >= glog_uringMaxExtents))
+	{
+		// The record being written hasn't been dequeued yet, so dequeuePos is exactly what's in the buffer
+		glog_Uring_submit(asyncRing.dequeuePos);
+		buffer = uring.buffers + uring.current;
+		extendsLast = false;
+	}
+
+	if (!extendsLast)
+	{
+		glog_UringExtent* extent = buffer->extents + buffer->numExtents++;
+		extent->fd = fd;
+		extent->start = buffer->length;
+		extent->length = 0;
+		extent->result = 0;
+	}
+
+	glog_UringExtent* extent = buffer->extents + buffer->numExtents - 1;
+	for (size_t i = 0; i < numParts; i++)
+	{
+		memcpy(buffer->data + buffer->length, parts[i].data, parts[i].length);
+		buffer->length += (uint32)parts[i].length;
+	}
+	extent->length += (uint32)length;
+
+	bool isDirty = false;
+	for (uint32 i = 0; i < uring.numDirtyFds; i++)
+	{
+		isDirty = isDirty || uring.dirtyFds[i] == fd;
+	}
+	if (!isDirty && uring.numDirtyFds < GABE_LOGGER_MAX_SINKS)
+	{
+		uring.dirtyFds[uring.numDirtyFds++] = fd;
+	}
+
+	return true;
+}
+
+static void glog_Uring_unmap(void)
+{
+	if (uring.sqes)
+	{
+		munmap(uring.sqes, uring.sqesSize);
+	}
+	if (uring.cqRing && uring.cqRing != uring.sqRing)
+	{
+		munmap(uring.cqRing, uring.cqRingSize);
+	}
+	if (uring.sqRing)
+	{
+		munmap(uring.sqRing, uring.sqRingSize);
+	}
+	close(uring.ringFd);
+
+	free(uring.buffers[0].data);
+	free(uring.buffers[1].data);
+	memset(&uring, 0, sizeof(uring));
+}
+
+// Runs on the writer thread when it starts. Leaves the writer on plain writes if anything goes wrong.
+static void glog_Uring_init(void)
+{
+	if (!gcu_atomic_loadU32(&uringRequested))
+	{
+		return;
+	}
+
+	memset(&uring, 0, sizeof(uring));
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	uring.ringFd = (int)syscall(__NR_io_uring_setup, glog_uringQueueDepth, &params);
+	if (uring.ringFd < 0)
+	{
+		return;
+	}
+
+	uring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32);
+	uring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMap && uring.cqRingSize > uring.sqRingSize)
+	{
+		uring.sqRingSize = uring.cqRingSize;
+	}
+
+	uring.sqRing = mmap(NULL, uring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring.ringFd, IORING_OFF_SQ_RING);
+	uring.cqRing = singleMap
+		? uring.sqRing
+		: mmap(NULL, uring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring.ringFd, IORING_OFF_CQ_RING);
+	uring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	uring.sqes = (struct io_uring_sqe*)mmap(NULL, uring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring.ringFd, IORING_OFF_SQES);
+	uring.buffers[0].data = (char*)malloc(GABE_LOGGER_URING_BUFFER_SIZE);
+	uring.buffers[1].data = (char*)malloc(GABE_LOGGER_URING_BUFFER_SIZE);
+	if (uring.sqRing == MAP_FAILED || uring.cqRing == MAP_FAILED || uring.sqes == MAP_FAILED || !uring.buffers[0].data || !uring.buffers[1].data)
+	{
+		uring.sqRing = uring.sqRing == MAP_FAILED ? NULL : uring.sqRing;
+		uring.cqRing = uring.cqRing == MAP_FAILED ? NULL : uring.cqRing;
+		uring.sqes = uring.sqes == MAP_FAILED ? NULL : uring.sqes;
+		glog_Uring_unmap();
+		return;
+	}
+
+	char* sq = (char*)uring.sqRing;
+	char* cq = (char*)uring.cqRing;
+	uring.sqHead = (volatile uint32*)(sq + params.sq_off.head);
+	uring.sqTail = (volatile uint32*)(sq + params.sq_off.tail);
+	uring.sqMask = *(uint32*)(sq + params.sq_off.ring_mask);
+	uring.sqArray = (uint32*)(sq + params.sq_off.array);
+	uring.cqHead = (volatile uint32*)(cq + params.cq_off.head);
+	uring.cqTail = (volatile uint32*)(cq + params.cq_off.tail);
+	uring.cqMask = *(uint32*)(cq + params.cq_off.ring_mask);
+	uring.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	// Registering pins the buffers so the kernel doesn't have to map them on every write. That can
+	// fail on a tight RLIMIT_MEMLOCK, plain writes from the same buffers still work then.
+	struct iovec registered[2];
+	for (int i = 0; i < 2; i++)
+	{
+		registered[i].iov_base = uring.buffers[i].data;
+		registered[i].iov_len = GABE_LOGGER_URING_BUFFER_SIZE;
+	}
+	uring.fixedBuffers = syscall(__NR_io_uring_register, uring.ringFd, IORING_REGISTER_BUFFERS, registered, 2) == 0;
+
+	uring.lastFsyncNs = glog_monotonicNs();
+	isUringWriter = true;
+}
+
+// Runs on the writer thread right before it exits
+static void glog_Uring_free(void)
+{
+	if (!isUringWriter)
+	{
+		return;
+	}
+
+	glog_Uring_waitIdle();
+	if (uringFsyncPolicy != g_logger_fsync_Never)
+	{
+		for (uint32 i = 0; i < uring.numDirtyFds; i++)
+		{
+			fdatasync(uring.dirtyFds[i]);
+		}
+	}
+
+	isUringWriter = false;
+	glog_Uring_unmap();
+}
+
+static bool glog_Uring_isSupported(void)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int ringFd = (int)syscall(__NR_io_uring_setup, 1, &params);
+	if (ringFd < 0)
+	{
+		return false;
+	}
+	close(ringFd);
+
+	// Offset -1 only means "the file position" since 5.6
+	return (params.features & IORING_FEAT_RW_CUR_POS) != 0;
+}
+#else
+static inline void glog_Uring_submit(uint64 flushPos) { (void)flushPos; }
+static inline void glog_Uring_waitIdle(void) { }
+static inline bool glog_Uring_isBusy(void) { return false; }
+static inline uint64 glog_Uring_flushedPos(uint64 dequeuePos) { return dequeuePos; }
+static inline void glog_Uring_reap(bool wait) { (void)wait; }
+static inline bool glog_Uring_stage(int fd, const glog_Span* parts, size_t numParts) { (void)fd; (void)parts; (void)numParts; return false; }
+static inline void glog_Uring_init(void) { }
+static inline void glog_Uring_free(void) { }
+static inline bool glog_Uring_isSupported(void) { return false; }
+#endif
+
+bool g_logger_set_io_uring_writer(bool enabled, g_logger_fsync_policy fsyncPolicy, uint32 fsyncIntervalMs)
+{
+	if (enabled && !glog_Uring_isSupported())
+	{
+		gcu_atomic_storeU32(&uringRequested, 0);
+		return false;
+	}
+
+	uringFsyncPolicy = fsyncPolicy;
+	uringFsyncIntervalMs = fsyncIntervalMs;
+	gcu_atomic_storeU32(&uringRequested, enabled ? 1 : 0);
+	return true;
+}
+
+// ----------------------------------
+// Deferred Formatting Implementation Common C11
+// ----------------------------------
+// cppPrint style log calls copy their raw arguments into the ring together with the id of their call
+// site. The writer thread either formats them through the decode function the site registered, or, if
+// a binary log file is set, writes them out untouched so they can be formatted offline.
+//
+// Binary log file layout (all integers little endian, as written by the host):
+//   header:      "GLOGBIN1" u32 version
+//   site:        u8 tag = 1, u32 id, u32 level, u32 line, u8 color,
+//                u16 filenameLength, filename bytes, u16 formatLength, format bytes,
+//                u8 numArgs, u8 argTypes[numArgs]
+//   record:      u8 tag = 2, u32 siteId, i64 unixTime, u32 microseconds, u32 payloadLength, payload bytes
+// A site is always written before the first record that uses it.
+#define glog_binaryFileVersion 2
+#define glog_binaryTagSite 1
+#define glog_binaryTagRecord 2
+
+static volatile uint32 deferredFormatting = 0;
+static FILE* binaryLogFile = NULL;
+
+// Sites get written to the binary log file the first time one of their records does
+static uint32 numBinarySitesWritten = 0;
+
+void g_logger_set_deferred_formatting(bool enabled)
+{
+	gcu_atomic_storeU32(&deferredFormatting, enabled ? 1 : 0);
+}
+
+bool g_logger_set_binary_log_file(const char* filepath)
+{
+	g_logger_flush();
+	g_thread_mutexLock(&logMutex);
+
+	if (binaryLogFile)
+	{
+		fclose(binaryLogFile);
+		binaryLogFile = NULL;
+	}
+
+	bool success = true;
+	if (filepath)
+	{
+		binaryLogFile = fopen(filepath, "wb");
+		if (binaryLogFile)
+		{
+			uint32 version = glog_binaryFileVersion;
+			fwrite("GLOGBIN1", 1, 8, binaryLogFile);
+			fwrite(&version, sizeof(version), 1, binaryLogFile);
+		}
+		else
+		{
+			printf("Failed to open binary log file '%s'.\n", filepath);
+			success = false;
+		}
+	}
+	numBinarySitesWritten = 0;
 
-	fopen_s(&logFile, logFilePath, "wb");
-	if (!logFile)
+	g_thread_mutexUnlock(&logMutex);
+	return success;
+}
+
+static void glog_freeDeferredFormatting(void)
+{
+	if (binaryLogFile)
 	{
-		printf("Failed to open file '%s' to log to. Please make sure the log directory exists, otherwise this will fail.\n", logFilePath);
-		free(logFilePath);
-		logFilePath = NULL;
+		fclose(binaryLogFile);
+		binaryLogFile = NULL;
 	}
+	numBinarySitesWritten = 0;
+}
 
-#undef maxPath
+bool _g_logger_isDeferred(void)
+{
+	return gcu_atomic_loadU32(&deferredFormatting) && gcu_atomic_loadU32(&asyncEnabled);
+}
+
+bool _g_logger_beginBinaryRecord(const g_logger_site* site, size_t payloadSize, uint8** outPayload, void** outRecordHandle)
+{
+	*outPayload = NULL;
+	if (!glog_AsyncRing_enter())
+	{
+		return false;
+	}
+
+	glog_RingSlot* slot = glog_AsyncRing_beginPush();
+	if (slot == NULL)
+	{
+		glog_AsyncRing_leave();
+		return true;
+	}
+
+	glog_Record* record = &slot->record;
+	record->filename = site->filename;
+	record->line = site->line;
+	record->level = site->level;
+	record->threadId = gcu_thread_id();
+	record->siteId = gcu_atomic_loadU32(&site->id);
+	record->messageLength = (uint32)payloadSize;
+	record->fieldsLength = 0;
+	glog_now(&record->time);
+
+	*outRecordHandle = (void*)slot;
+	*outPayload = (uint8*)record->message;
+	return true;
+}
+
+void _g_logger_endBinaryRecord(void* recordHandle)
+{
+	glog_AsyncRing_endPush((glog_RingSlot*)recordHandle);
+	glog_AsyncRing_leave();
+}
+
+static void glog_writeBinarySite(const g_logger_site* site)
+{
+	uint8 tag = glog_binaryTagSite;
+#ifdef USE_GABE_CPP_PRINT
+	uint8 color = (uint8)glog_consoleColor(site->level);
+#else
+	// Only cppPrint style calls get deferred, so this never actually gets written
+	uint8 color = 0;
+#endif
+	// Sites that can't be deferred never get records, so there's no point describing their arguments
+	uint8 numArgs = site->argTypes ? site->numArgs : 0;
+	uint32 id = site->id;
+	uint32 level = (uint32)site->level;
+	uint32 line = (uint32)site->line;
+	uint16 filenameLength = (uint16)strlen(site->filename);
+	uint16 formatLength = (uint16)strlen(site->format);
+
+	fwrite(&tag, sizeof(tag), 1, binaryLogFile);
+	fwrite(&id, sizeof(id), 1, binaryLogFile);
+	fwrite(&level, sizeof(level), 1, binaryLogFile);
+	fwrite(&line, sizeof(line), 1, binaryLogFile);
+	fwrite(&color, sizeof(color), 1, binaryLogFile);
+	fwrite(&filenameLength, sizeof(filenameLength), 1, binaryLogFile);
+	fwrite(site->filename, 1, filenameLength, binaryLogFile);
+	fwrite(&formatLength, sizeof(formatLength), 1, binaryLogFile);
+	fwrite(site->format, 1, formatLength, binaryLogFile);
+	fwrite(&numArgs, sizeof(numArgs), 1, binaryLogFile);
+	fwrite(site->argTypes, 1, numArgs, binaryLogFile);
+}
+
+#ifdef USE_GABE_CPP_PRINT
+// Formats one argument for the sinks cppPrint can't write to. Integers honor x, X and o, floats
+// honor a precision and f, e or g, and everything else gets its default formatting.
+static void glog_Line_appendDeferredArg(glog_Line* line, const glog_FlightArg* arg, const char* modifiers, size_t modifiersLength)
+{
+	int precision = -1;
+	char conversion = 0;
+	for (size_t i = 0; i < modifiersLength; i++)
+	{
+		char m = modifiers[i];
+		if (m == '.')
+		{
+			precision = 0;
+			while (i + 1 < modifiersLength && modifiers[i + 1] >= '0' && modifiers[i + 1] <= '9')
+			{
+				precision = precision * 10 + (modifiers[i + 1] - '0');
+				i++;
+			}
+		}
+		else if ((m >= 'a' && m <= 'z') || (m >= 'A' && m <= 'Z'))
+		{
+			conversion = m;
+		}
+	}
+
+	switch (arg->type)
+	{
+	case glog_ArgType_I8: case glog_ArgType_I16: case glog_ArgType_I32: case glog_ArgType_I64:
+		if (conversion == 'x' || conversion == 'X' || conversion == 'o')
+		{
+			glog_Line_appendf(line, conversion == 'x' ? "%llx" : conversion == 'X' ? "%llX" : "%llo", (unsigned long long)arg->value.i);
+		}
+		else
+		{
+			glog_Line_appendf(line, "%lld", (long long)arg->value.i);
+		}
+		break;
+	case glog_ArgType_U8: case glog_ArgType_U16: case glog_ArgType_U32: case glog_ArgType_U64:
+		if (conversion == 'x' || conversion == 'X' || conversion == 'o')
+		{
+			glog_Line_appendf(line, conversion == 'x' ? "%llx" : conversion == 'X' ? "%llX" : "%llo", (unsigned long long)arg->value.u);
+		}
+		else
+		{
+			glog_Line_appendf(line, "%llu", (unsigned long long)arg->value.u);
+		}
+		break;
+	case glog_ArgType_F32: case glog_ArgType_F64:
+	{
+		const char* format = "%.*g";
+		if (conversion == 'f' || conversion == 'F')
+		{
+			format = "%.*f";
+		}
+		else if (conversion == 'e' || conversion == 'E')
+		{
+			format = conversion == 'e' ? "%.*e" : "%.*E";
+		}
+		glog_Line_appendf(line, format, precision < 0 ? 6 : precision, arg->value.f);
+		break;
+	}
+	case glog_ArgType_Bool:
+		glog_Line_appendStr(line, arg->value.u ? "true" : "false");
+		break;
+	case glog_ArgType_Char:
+	{
+		char c = (char)arg->value.i;
+		glog_Line_append(line, &c, 1);
+		break;
+	}
+	case glog_ArgType_Pointer:
+		glog_Line_appendf(line, "0x%016llx", (unsigned long long)arg->value.u);
+		break;
+	case glog_ArgType_String:
+		glog_Line_appendStr(line, arg->value.s);
+		break;
+	default:
+		break;
+	}
+}
+
+// Walks the format string the same way cppPrint does, "{{" is a literal brace
+static void glog_appendDeferredMessage(glog_Line* line, const g_logger_site* site, const glog_Record* record)
+{
+	uint32 argIndex = 0;
+	uint32 offset = 0;
+	glog_FlightArg arg;
+	const char* literalStart = site->format;
+	for (const char* c = site->format; *c; c++)
+	{
+		if (*c != '{')
+		{
+			continue;
+		}
+
+		glog_Line_append(line, literalStart, (size_t)(c - literalStart));
+		if (c[1] == '{')
+		{
+			glog_Line_append(line, "{", 1);
+			c++;
+			literalStart = c + 1;
+			continue;
+		}
+
+		const char* modifiers = c + 1;
+		while (*c && *c != '}')
+		{
+			c++;
+		}
+		if (glog_readArg(site->argTypes, site->numArgs, (const uint8*)record->message, record->messageLength, argIndex, &offset, &arg))
+		{
+			argIndex++;
+			glog_Line_appendDeferredArg(line, &arg, modifiers, (size_t)(c - modifiers));
+		}
+		else
+		{
+			glog_Line_appendStr(line, "{?}");
+		}
+		if (*c == '\0')
+		{
+			literalStart = c;
+			break;
+		}
+		literalStart = c + 1;
+	}
+	glog_Line_appendStr(line, literalStart);
+}
+#endif
+
+// Called with logMutex held
+static void glog_writeBinaryRecord(const glog_Record* record)
+{
+	if (binaryLogFile)
+	{
+		while (numBinarySitesWritten < record->siteId)
+		{
+			glog_writeBinarySite(sites[numBinarySitesWritten]);
+			numBinarySitesWritten++;
+		}
+
+		uint8 tag = glog_binaryTagRecord;
+		fwrite(&tag, sizeof(tag), 1, binaryLogFile);
+		fwrite(&record->siteId, sizeof(record->siteId), 1, binaryLogFile);
+		fwrite(&record->time.seconds, sizeof(record->time.seconds), 1, binaryLogFile);
+		fwrite(&record->time.microseconds, sizeof(record->time.microseconds), 1, binaryLogFile);
+		fwrite(&record->messageLength, sizeof(record->messageLength), 1, binaryLogFile);
+		fwrite(record->message, 1, record->messageLength, binaryLogFile);
+		return;
+	}
+
+#ifdef USE_GABE_CPP_PRINT
+	// Registration can realloc the table, the lock we're holding keeps it still
+	const g_logger_site* site = sites[record->siteId - 1];
+
+	char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+	glog_formatTimestamp(&record->time, buf, sizeof(buf));
+
+	// cppPrint can only print to stdout, so the decoder handles the console and the other sinks get the
+	// message formatted by glog_appendDeferredMessage
+	if (glog_consoleWants(site->level))
+	{
+		CppUtils::IO::setForegroundColor(glog_consoleColor(site->level));
+		CppUtils::IO::printf("{} (line {}) Log: \n", site->filename, site->line);
+		CppUtils::IO::resetColor();
+		CppUtils::IO::printf("[{}]: ", buf);
+		site->decode(site->format, (const uint8*)record->message, record->messageLength);
+		CppUtils::IO::printf("\n");
+	}
+
+	glog_Line fileLine;
+	glog_Line_beginRecord(&fileLine, NULL, NULL, site->filename, site->line, "Log", buf);
+	glog_appendDeferredMessage(&fileLine, site, record);
+	size_t messageLength = fileLine.length - fileLine.messageStart;
+	glog_Line_appendStr(&fileLine, "\n");
+	glog_writeToSinks(&fileLine, site->level, glog_levelColor(site->level), site->filename, site->line, true);
+
+	glog_writeJson(site->filename, site->line, site->level, &record->time, record->threadId, fileLine.data + fileLine.messageStart, messageLength, NULL, NULL, 0);
+	glog_Line_end(&fileLine);
+#endif
+}
+
+static bool glog_AsyncRing_drain(void)
+{
+	bool wroteAny = false;
+	for (;;)
+	{
+		uint64 pos = asyncRing.dequeuePos;
+		glog_RingSlot* slot = asyncRing.slots + (pos & asyncRing.mask);
+		if (gcu_atomic_loadU64(&slot->sequence) != pos + 1)
+		{
+			break;
+		}
+
+		// Sinks only get added and removed under the lock, so hold it while the record goes out to them
+		g_thread_mutexLock(&logMutex);
+		if (slot->record.siteId != 0)
+		{
+			glog_writeBinaryRecord(&slot->record);
+		}
+		else
+		{
+			glog_writeRecord(&slot->record);
+		}
+		g_thread_mutexUnlock(&logMutex);
+		gcu_atomic_storeU64(&slot->sequence, pos + asyncRing.mask + 1);
+		gcu_atomic_storeU64(&asyncRing.dequeuePos, pos + 1);
+		wroteAny = true;
+	}
+
+	return wroteAny;
+}
+
+static void glog_asyncWriterThread(void* userData)
+{
+	(void)userData;
+	isAsyncWriter = true;
+	glog_Uring_init();
+
+	uint64 numDroppedReported = 0;
+	uint32 numIdleLoops = 0;
+	for (;;)
+	{
+		// Read this before draining so that nothing published before shutdown gets left behind
+		bool running = gcu_atomic_loadU32(&asyncRing.running) != 0;
+		bool wroteAny = glog_AsyncRing_drain();
+
+		uint64 numDropped = gcu_atomic_loadU64(&asyncRing.numDropped);
+		if (numDropped != numDroppedReported)
+		{
+			g_thread_mutexLock(&logMutex);
+			glog_writeNotice(g_logger_level_Warning, __FILE__, __LINE__,
+				"Dropped %llu log messages because the async ring buffer was full.",
+				(unsigned long long)(numDropped - numDroppedReported));
+			g_thread_mutexUnlock(&logMutex);
+
+			numDroppedReported = numDropped;
+			wroteAny = true;
+		}
+
+		if (wroteAny)
+		{
+			fflush(stdout);
+			if (binaryLogFile)
+			{
+				fflush(binaryLogFile);
+			}
+			glog_Uring_submit(asyncRing.dequeuePos);
+			gcu_atomic_storeU64(&asyncRing.flushedPos, glog_Uring_flushedPos(asyncRing.dequeuePos));
+			numIdleLoops = 0;
+			continue;
+		}
+
+		// Writes still with the kernel only count as flushed once they complete
+		if (glog_Uring_isBusy())
+		{
+			glog_Uring_reap(false);
+			gcu_atomic_storeU64(&asyncRing.flushedPos, glog_Uring_flushedPos(asyncRing.dequeuePos));
+		}
+
+		if (!running)
+		{
+			break;
+		}
+
+		// Back off so an idle logger doesn't burn a core, but stays responsive under bursts
+		if (numIdleLoops < 64)
+		{
+			numIdleLoops++;
+			gcu_thread_yield();
+		}
+		else
+		{
+			gcu_thread_sleepMs(1);
+		}
+	}
+
+	glog_Uring_free();
+}
+
+void g_logger_enable_async(uint32 numRecords, g_logger_overflow_policy policy)
+{
+	if (gcu_atomic_loadU32(&asyncEnabled))
+	{
+		return;
+	}
+
+	uint64 numSlots = 2;
+	while (numSlots < numRecords)
+	{
+		numSlots *= 2;
+	}
+
+	glog_RingSlot* slots = (glog_RingSlot*)malloc(sizeof(glog_RingSlot) * numSlots);
+	if (!slots)
+	{
+		printf("Failed to allocate the async logger ring buffer. Out of memory. Staying synchronous.\n");
+		return;
+	}
+
+	for (uint64 i = 0; i < numSlots; i++)
+	{
+		slots[i].sequence = i;
+	}
+
+	asyncRing.slots = slots;
+	asyncRing.mask = numSlots - 1;
+	asyncRing.policy = policy;
+	asyncRing.enqueuePos = 0;
+	asyncRing.dequeuePos = 0;
+	asyncRing.flushedPos = 0;
+	asyncRing.numDropped = 0;
+	gcu_atomic_storeU32(&asyncRing.running, 1);
+
+	asyncRing.writerThread = gcu_thread_start(glog_asyncWriterThread, NULL);
+	if (!asyncRing.writerThread)
+	{
+		printf("Failed to start the async logger writer thread. Staying synchronous.\n");
+		free(asyncRing.slots);
+		asyncRing.slots = NULL;
+		return;
+	}
+
+	gcu_atomic_storeU32(&asyncEnabled, 1);
+}
+
+void g_logger_disable_async(void)
+{
+	if (!gcu_atomic_loadU32(&asyncEnabled))
+	{
+		return;
+	}
+
+	gcu_atomic_storeU32(&asyncEnabled, 0);
+	gcu_atomic_fence();
+
+	// Wait for the producers that saw it enabled to finish their pushes. The writer thread is still
+	// draining, so producers blocked on a full ring get through too.
+	while (gcu_atomic_loadU32(&asyncRing.numProducers) != 0)
+	{
+		gcu_thread_yield();
+	}
+
+	gcu_atomic_storeU32(&asyncRing.running, 0);
+	gcu_thread_join(asyncRing.writerThread);
+	asyncRing.writerThread = NULL;
+
+	// Catch anything a producer published after the writer thread's last pass
+	glog_AsyncRing_drain();
+	fflush(stdout);
+
+	free(asyncRing.slots);
+	asyncRing.slots = NULL;
+
+	if (binaryLogFile)
+	{
+		fflush(binaryLogFile);
+	}
+}
+
+void g_logger_flush(void)
+{
+	if (gcu_atomic_loadU32(&asyncEnabled))
+	{
+		uint64 target = gcu_atomic_loadU64(&asyncRing.enqueuePos);
+		while (gcu_atomic_loadU64(&asyncRing.flushedPos) < target && gcu_atomic_loadU32(&asyncRing.running))
+		{
+			gcu_thread_yield();
+		}
+		return;
+	}
+
+	fflush(stdout);
+}
+
+uint64 g_logger_get_dropped_count(void)
+{
+	return gcu_atomic_loadU64(&asyncRing.numDropped);
 }
 
 
@@ -959,75 +7394,113 @@ void g_logger_set_log_directory(const char* directory)
 #ifdef USE_GABE_CPP_PRINT
 using namespace CppUtils;
 
-void _g_logger_printPreamble(const char* filename, int line, char* buf, size_t bufSize, CppUtils::ConsoleColor color)
+static void glog_writeRecord(const glog_Record* record)
 {
-	g_thread_lockMutex(logMutex);
+	char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+	glog_formatTimestamp(&record->time, buf, sizeof(buf));
 
-	IO::setForegroundColor(color);
-	IO::printf("{} (line {}) Log: \n", filename, line);
-	IO::resetColor();
+	glog_Line line;
+	glog_Line_beginRecord(&line, NULL, NULL, record->filename, record->line, "Log", buf);
+	glog_Line_appendRecordMessage(&line, record);
+	glog_Line_append(&line, "\n", 1);
+	glog_writeToSinks(&line, record->level, record->color, record->filename, record->line, false);
+	glog_Line_end(&line);
 
-	time_t now;
-	time(&now);
-	struct tm localTime;
-	localtime_s(&localTime, &now);
-	strftime(buf, bufSize, "%Y-%m-%d %I:%M:%S", &localTime);
-	IO::printf("[{}]: ", buf);
+	glog_writeRecordJson(record);
 }
 
-void _g_logger_printPostamble(const char* filename, int line, char* buf, size_t)
+static void glog_writeConsole(const glog_Line* line, uint32 format, glog_Color color)
 {
-	IO::printf("\n");
-
-	if (logFile)
+	if (format & g_logger_format_Location)
 	{
-		fprintf(logFile, "%s (line %d) Log: \n", filename, line);
-		fprintf(logFile, "[%s]: ", buf);
+		if (format & g_logger_format_Color)
+		{
+			IO::setForegroundColor(color);
+		}
+		IO::_printfInternal(line->data + line->headerStart, line->headerEnd - line->headerStart);
+		if (format & g_logger_format_Color)
+		{
+			IO::resetColor();
+		}
+	}
 
-		// TODO: Implement me for printing to files
-		//va_list fargs;
-		//va_start(fargs, format);
-		//vfprintf(logFile, format, fargs);
-		//va_end(fargs);
+	size_t bodyStart = (format & g_logger_format_Timestamp) ? line->bodyStart : line->messageStart;
+	IO::_printfInternal(line->data + bodyStart, line->length - bodyStart);
+}
 
-		fprintf(logFile, "\n");
-	}
+// The record a cppPrint log call is printing into, from the preamble to the postamble. Only touched
+// with logMutex held.
+static glog_Line gabeLine;
+static glog_MessageSpans gabeSpans;
 
-	g_thread_releaseMutex(logMutex);
+static void glog_appendCaptured(void* userData, const char* s, size_t length)
+{
+	glog_Line_append((glog_Line*)userData, s, length);
 }
 
-void _g_logger_assertGabePreamble(const char* filename, int line, char* buf, size_t bufSize)
+static void glog_beginGabeRecord(const char* filename, int line, const char* kind)
 {
-	g_thread_lockMutex(logMutex);
+	char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+	glog_formatNow(buf, sizeof(buf));
+	glog_Line_beginRecord(&gabeLine, NULL, NULL, filename, line, kind, buf);
+	IO::setCapture(glog_appendCaptured, &gabeLine);
+}
 
-	IO::setForegroundColor(CppUtils::ConsoleColor::DARKRED);
-	IO::printf("{} (line {}) Assertion Failure: \n", filename, line);
-	IO::resetColor();
+// Stops capturing and finishes the record the same way glog_Line_appendMessage does
+static void glog_endGabeMessage(const g_logger_kv* fields, uint32 numFields)
+{
+	IO::setCapture(nullptr, nullptr);
 
-	time_t now;
-	time(&now);
-	struct tm localTime;
-	localtime_s(&localTime, &now);
-	strftime(buf, bufSize, "%Y-%m-%d %I:%M:%S", &localTime);
-	IO::printf("[{}]: ", buf);
+	gabeSpans.messageStart = gabeLine.messageStart;
+	gabeSpans.messageLength = gabeLine.length - gabeLine.messageStart;
+	gabeSpans.fieldsStart = gabeLine.length;
+	gabeSpans.fieldsLength = 0;
+	if (numFields > 0)
+	{
+		glog_Line_append(&gabeLine, " {", 2);
+		gabeSpans.fieldsStart = gabeLine.length;
+		glog_Line_appendJsonFields(&gabeLine, fields, numFields);
+		gabeSpans.fieldsLength = gabeLine.length - gabeSpans.fieldsStart;
+		glog_Line_append(&gabeLine, "}", 1);
+	}
+	glog_Line_append(&gabeLine, "\n", 1);
+}
+
+void _g_logger_printPreamble(const g_logger_site* site)
+{
+	g_thread_mutexLock(&logMutex);
+	glog_beginGabeRecord(site->filename, site->line, "Log");
 }
 
-void _g_logger_assertGabePostamble(const char* filename, int line, char* buf, size_t)
+void _g_logger_printPostamble(const g_logger_site* site, const g_logger_kv* fields, uint32 numFields)
 {
-	IO::printf("\n");
+	glog_endGabeMessage(fields, numFields);
 
-	if (logFile)
-	{
-		fprintf(logFile, "%s (line %d) Assertion Failure: \n", filename, line);
-		fprintf(logFile, "[%s]: ", buf);
+	glog_Timestamp now;
+	glog_now(&now);
+	glog_writeToSinks(&gabeLine, site->level, glog_levelColor(site->level), site->filename, site->line, false);
+	glog_writeJsonForLine(&gabeLine, &gabeSpans, site->filename, site->line, site->level, &now);
+	glog_Line_end(&gabeLine);
+
+	g_thread_mutexUnlock(&logMutex);
+}
 
-		//va_list fargs;
-		//va_start(fargs, format);
-		//vfprintf(logFile, format, fargs);
-		//va_end(fargs);
+void _g_logger_assertGabePreamble(const char* filename, int line)
+{
+	filename = glog_basename(filename);
+	g_logger_flush();
+	g_thread_mutexLock(&logMutex);
+	glog_beginGabeRecord(filename, line, "Assertion Failure");
+}
 
-		fprintf(logFile, "\n");
-	}
+void _g_logger_assertGabePostamble(const char* filename, int line)
+{
+	filename = glog_basename(filename);
+	glog_endGabeMessage(NULL, 0);
+
+	glog_writeToSinks(&gabeLine, g_logger_level_Assert, CppUtils::ConsoleColor::DARKRED, filename, line, false);
+	glog_Line_end(&gabeLine);
+	glog_dumpFlightRecorder();
 
 	_CrtDbgBreak();
 
@@ -1039,52 +7512,130 @@ void _g_logger_assertGabePostamble(const char* filename, int line, char* buf, si
 	//	MB_ICONEXCLAMATION | MB_OK
 	//);
 
-	g_thread_releaseMutex(logMutex);
+	g_thread_mutexUnlock(&logMutex);
 	g_logger_free();
 	exit(-1);
 }
 #else // end USE_GABE_CPP_PRINT
 
-void _g_logger_cStdCommonPrint(const char* filename, int line, g_logger_level level, WORD color, const char* format, ...)
+// The console color has to change between the header and the body, so the console still gets two
+// writes. The log files get the whole record in one.
+static void glog_writeConsole(const glog_Line* line, uint32 format, glog_Color color)
 {
-	if (g_logger_get_level() <= level)
+	if (format & g_logger_format_Location)
 	{
-		g_thread_lockMutex(logMutex);
+		if (format & g_logger_format_Color)
+		{
+			SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), color);
+		}
+		fwrite(line->data + line->headerStart, 1, line->headerEnd - line->headerStart, stdout);
+		if (format & g_logger_format_Color)
+		{
+			SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 0x0F);
+		}
+	}
+
+	size_t bodyStart = (format & g_logger_format_Timestamp) ? line->bodyStart : line->messageStart;
+	fwrite(line->data + bodyStart, 1, line->length - bodyStart, stdout);
+}
 
-		SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), color);
-		printf("%s (line %d) Info: \n", filename, line);
-		SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), 0x0F);
+static void glog_writeRecord(const glog_Record* record)
+{
+	char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+	glog_formatTimestamp(&record->time, buf, sizeof(buf));
 
-		time_t now;
-		time(&now);
-		char buf[20] = { 0 };
-		struct tm localTime;
-		localtime_s(&localTime, &now);
-		strftime(buf, sizeof(buf), "%Y-%m-%d %I:%M:%S", &localTime);
-		printf("[%s]: ", buf);
+	glog_Line line;
+	glog_Line_beginRecord(&line, NULL, NULL, record->filename, record->line, "Info", buf);
+	glog_Line_appendRecordMessage(&line, record);
+	glog_Line_append(&line, "\n", 1);
+	glog_writeToSinks(&line, record->level, record->color, record->filename, record->line, false);
+	glog_Line_end(&line);
 
-		va_list args;
-		va_start(args, format);
-		vprintf(format, args);
-		va_end(args);
+	glog_writeRecordJson(record);
+}
+
+static void glog_printUnthrottled(g_logger_site* site, const char* format, ...);
+
+static void glog_vprint(g_logger_site* site, bool throttle, const g_logger_kv* fields, uint32 numFields, const char* format, va_list args)
+{
+	glog_registerSiteIfNeeded(site, format);
+	const char* filename = site->filename;
+	int line = site->line;
+	g_logger_level level = site->level;
+	glog_Color color = glog_levelColor(level);
+
+	// Before the level check, the flight recorder keeps everything
+	if (gcu_atomic_loadU32(&flightEnabled))
+	{
+		glog_recordFlight(filename, line, level, format, args);
+	}
+
+	if (_g_logger_siteMinLevel(site) > level)
+	{
+		return;
+	}
 
-		printf("\n");
+	if (throttle)
+	{
+		uint32 numSuppressed;
+		if (!_g_logger_checkRateLimit(&site->rate, level, &numSuppressed))
+		{
+			return;
+		}
 
-		if (logFile)
+		if (numSuppressed > 0)
 		{
-			fprintf(logFile, "%s (line %d) Info: \n", filename, line);
-			fprintf(logFile, "[%s]: ", buf);
+			glog_printUnthrottled(site, "suppressed %u messages from this site", numSuppressed);
+		}
+	}
 
-			va_list fargs;
-			va_start(fargs, format);
-			vfprintf(logFile, format, fargs);
-			va_end(fargs);
+	if (gcu_atomic_loadU32(&asyncEnabled) && glog_pushAsync(filename, line, level, color, fields, numFields, format, args))
+	{
+		return;
+	}
+
+	glog_Timestamp now;
+	glog_now(&now);
+	char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+	glog_formatTimestamp(&now, buf, sizeof(buf));
+
+	// Format before taking the lock, only the writes need it
+	glog_Line logLine;
+	glog_MessageSpans spans;
+	glog_Line_beginRecord(&logLine, NULL, NULL, filename, line, "Info", buf);
+	glog_Line_appendMessage(&logLine, &spans, fields, numFields, format, args);
+	glog_Line_append(&logLine, "\n", 1);
+
+	g_thread_mutexLock(&logMutex);
+	glog_writeToSinks(&logLine, level, color, filename, line, false);
+	glog_writeJsonForLine(&logLine, &spans, filename, line, level, &now);
+	g_thread_mutexUnlock(&logMutex);
+
+	glog_Line_end(&logLine);
+}
 
-			fprintf(logFile, "\n");
-		}
+static void glog_printUnthrottled(g_logger_site* site, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	glog_vprint(site, false, NULL, 0, format, args);
+	va_end(args);
+}
 
-		g_thread_releaseMutex(logMutex);
-	}
+void _g_logger_cStdCommonPrint(g_logger_site* site, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	glog_vprint(site, true, NULL, 0, format, args);
+	va_end(args);
+}
+
+void _g_logger_cStdKvPrint(g_logger_site* site, const g_logger_kv* fields, uint32 numFields, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	glog_vprint(site, true, fields, numFields, format, args);
+	va_end(args);
 }
 
 void _g_logger_assert(const char* filename, int line, int condition, const char* format, ...)
@@ -1093,7 +7644,9 @@ void _g_logger_assert(const char* filename, int line, int condition, const char*
 	{
 		if (!condition)
 		{
-			g_thread_lockMutex(logMutex);
+			filename = glog_basename(filename);
+			g_logger_flush();
+			g_thread_mutexLock(&logMutex);
 
 #define fullErrorMessageBufferSize 4096
 			char fullErrorMessageBuffer[fullErrorMessageBufferSize];
@@ -1115,12 +7668,8 @@ void _g_logger_assert(const char* filename, int line, int condition, const char*
 			printf("%s (line %d) Assertion Failure: \n", filename, line);
 			SetConsoleTextAttribute(console, csbi.wAttributes);
 
-			time_t now;
-			time(&now);
-			char buf[20] = { 0 };
-			struct tm localTime;
-			localtime_s(&localTime, &now);
-			strftime(buf, sizeof(buf), "%Y-%m-%d %I:%M:%S", &localTime);
+			char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+			glog_formatNow(buf, sizeof(buf));
 			printf("[%s]: ", buf);
 			sprintf_s(
 				fullErrorMessageBuffer + offset,
@@ -1150,18 +7699,19 @@ void _g_logger_assert(const char* filename, int line, int condition, const char*
 			offset = strlen(fullErrorMessageBuffer);
 			printf("\n");
 
-			if (logFile)
-			{
-				fprintf(logFile, "%s (line %d) Assertion Failure: \n", filename, line);
-				fprintf(logFile, "[%s]: ", buf);
-
-				va_list fargs;
-				va_start(fargs, format);
-				vfprintf(logFile, format, fargs);
-				va_end(fargs);
-
-				fprintf(logFile, "\n");
+			glog_Line fileLine;
+			glog_Line_beginRecord(&fileLine, NULL, NULL, filename, line, "Assertion Failure", buf);
+			va_list fargs;
+			va_start(fargs, format);
+			glog_Line_appendv(&fileLine, format, fargs);
+			va_end(fargs);
+			glog_Line_append(&fileLine, "\n", 1);
+			glog_writeToSinks(&fileLine, g_logger_level_Assert, g_logger_FOREGROUND_RED, filename, line, true);
+			glog_Line_end(&fileLine);
 
+			const char* logFilePath = glog_logDirectoryFilePath();
+			if (logFilePath)
+			{
 				sprintf_s(
 					fullErrorMessageBuffer + offset,
 					fullErrorMessageBufferSize - offset,
@@ -1169,6 +7719,7 @@ void _g_logger_assert(const char* filename, int line, int condition, const char*
 					logFilePath
 				);
 			}
+			glog_dumpFlightRecorder();
 
 			_CrtDbgBreak();
 
@@ -1179,7 +7730,7 @@ void _g_logger_assert(const char* filename, int line, int condition, const char*
 				MB_ICONEXCLAMATION | MB_OK
 			);
 
-			g_thread_releaseMutex(logMutex);
+			g_thread_mutexUnlock(&logMutex);
 			g_logger_free();
 			exit(-1);
 		}
@@ -1208,41 +7759,112 @@ namespace ColorCode
 	const char* KWHT = "\x1B[37m";
 }
 
-void _g_logger_cStdCommonPrint(const char* filename, int line, g_logger_level level, const char* color, const char* format, ...)
+// One writev(2) for the console, color codes included
+static void glog_writeConsole(const glog_Line* line, uint32 format, glog_Color)
 {
-	if (g_logger_get_level() <= level)
-	{
-		g_thread_lockMutex(logMutex);
+	glog_Span parts[3];
+	size_t numParts = glog_Line_sinkParts(line, format, parts);
 
-		printf("%s%s (line %d) Log: \n", color, filename, line);
+	glog_writeParts(STDOUT_FILENO, parts, numParts);
+}
 
-		std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-		char buf[20] = { 0 };
-		std::strftime(buf, sizeof(buf), "%Y-%m-%d %I:%M:%S", std::localtime(&now));
-		printf("%s[%s]: ", ColorCode::KNRM, buf);
+static void glog_writeRecord(const glog_Record* record)
+{
+	char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+	glog_formatTimestamp(&record->time, buf, sizeof(buf));
 
-		va_list args;
-		va_start(args, format);
-		vprintf(format, args);
-		va_end(args);
+	glog_Line line;
+	glog_Line_beginRecord(&line, record->color, ColorCode::KNRM, record->filename, record->line, "Log", buf);
+	glog_Line_appendRecordMessage(&line, record);
+	glog_Line_append(&line, "\n", 1);
+	glog_writeToSinks(&line, record->level, record->color, record->filename, record->line, false);
+	glog_Line_end(&line);
 
-		printf("\n");
+	glog_writeRecordJson(record);
+}
 
-		if (logFile)
-		{
-			fprintf(logFile, "%s (line %d) Log: \n", filename, line);
-			fprintf(logFile, "[%s]: ", buf);
+static void glog_printUnthrottled(g_logger_site* site, const char* format, ...);
 
-			va_list fargs;
-			va_start(fargs, format);
-			vfprintf(logFile, format, fargs);
-			va_end(fargs);
+static void glog_vprint(g_logger_site* site, bool throttle, const g_logger_kv* fields, uint32 numFields, const char* format, va_list args)
+{
+	glog_registerSiteIfNeeded(site, format);
+	const char* filename = site->filename;
+	int line = site->line;
+	g_logger_level level = site->level;
+	glog_Color color = glog_levelColor(level);
+
+	// Before the level check, the flight recorder keeps everything
+	if (gcu_atomic_loadU32(&flightEnabled))
+	{
+		glog_recordFlight(filename, line, level, format, args);
+	}
+
+	if (_g_logger_siteMinLevel(site) > level)
+	{
+		return;
+	}
+
+	if (throttle)
+	{
+		uint32 numSuppressed;
+		if (!_g_logger_checkRateLimit(&site->rate, level, &numSuppressed))
+		{
+			return;
+		}
 
-			fprintf(logFile, "\n");
+		if (numSuppressed > 0)
+		{
+			glog_printUnthrottled(site, "suppressed %u messages from this site", numSuppressed);
 		}
+	}
 
-		g_thread_releaseMutex(logMutex);
+	if (gcu_atomic_loadU32(&asyncEnabled) && glog_pushAsync(filename, line, level, color, fields, numFields, format, args))
+	{
+		return;
 	}
+
+	glog_Timestamp now;
+	glog_now(&now);
+	char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+	glog_formatTimestamp(&now, buf, sizeof(buf));
+
+	// Format before taking the lock, only the writes need it
+	glog_Line logLine;
+	glog_MessageSpans spans;
+	glog_Line_beginRecord(&logLine, color, ColorCode::KNRM, filename, line, "Log", buf);
+	glog_Line_appendMessage(&logLine, &spans, fields, numFields, format, args);
+	glog_Line_append(&logLine, "\n", 1);
+
+	g_thread_mutexLock(&logMutex);
+	glog_writeToSinks(&logLine, level, color, filename, line, false);
+	glog_writeJsonForLine(&logLine, &spans, filename, line, level, &now);
+	g_thread_mutexUnlock(&logMutex);
+
+	glog_Line_end(&logLine);
+}
+
+static void glog_printUnthrottled(g_logger_site* site, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	glog_vprint(site, false, NULL, 0, format, args);
+	va_end(args);
+}
+
+void _g_logger_cStdCommonPrint(g_logger_site* site, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	glog_vprint(site, true, NULL, 0, format, args);
+	va_end(args);
+}
+
+void _g_logger_cStdKvPrint(g_logger_site* site, const g_logger_kv* fields, uint32 numFields, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	glog_vprint(site, true, fields, numFields, format, args);
+	va_end(args);
 }
 
 void _g_logger_assert(const char* filename, int line, int condition, const char* format, ...)
@@ -1251,38 +7873,27 @@ void _g_logger_assert(const char* filename, int line, int condition, const char*
 	{
 		if (!condition)
 		{
-			g_thread_lockMutex(logMutex);
+			filename = glog_basename(filename);
+			g_logger_flush();
+			g_thread_mutexLock(&logMutex);
 
-			printf("%s%s (line %d) Assertion Failure: \n", ColorCode::KRED, filename, line);
-
-			std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-			char buf[20] = { 0 };
-			std::strftime(buf, sizeof(buf), "%Y-%m-%d %I:%M:%S", std::localtime(&now));
-			printf("%s[%s]: ", ColorCode::KNRM, buf);
+			char buf[GABE_LOGGER_TIMESTAMP_SIZE] = { 0 };
+			glog_formatNow(buf, sizeof(buf));
 
+			glog_Line logLine;
+			glog_Line_beginRecord(&logLine, ColorCode::KRED, ColorCode::KNRM, filename, line, "Assertion Failure", buf);
 			va_list args;
 			va_start(args, format);
-			vprintf(format, args);
+			glog_Line_appendv(&logLine, format, args);
 			va_end(args);
-
-			printf("\n");
-
-			if (logFile)
-			{
-				fprintf(logFile, "%s (line %d) Log: \n", filename, line);
-				fprintf(logFile, "[%s]: ", buf);
-
-				va_list fargs;
-				va_start(fargs, format);
-				vfprintf(logFile, format, fargs);
-				va_end(fargs);
-
-				fprintf(logFile, "\n");
-			}
+			glog_Line_append(&logLine, "\n", 1);
+			glog_writeToSinks(&logLine, g_logger_level_Assert, ColorCode::KRED, filename, line, false);
+			glog_Line_end(&logLine);
+			glog_dumpFlightRecorder();
 
 			std::raise(SIGINT);
+			g_thread_mutexUnlock(&logMutex);
 			g_logger_free();
-			g_thread_releaseMutex(logMutex);
 
 			exit(-1);
 		}
@@ -1298,6 +7909,64 @@ void _g_logger_assert(const char* filename, int line, int condition, const char*
 // ----------------------------------
 #ifdef _WIN32 
 
+typedef struct gcu_ThreadStart
+{
+	gcu_ThreadFn fn;
+	void* userData;
+} gcu_ThreadStart;
+
+static DWORD WINAPI gcu_threadEntry(LPVOID param)
+{
+	gcu_ThreadStart start = *(gcu_ThreadStart*)param;
+	free(param);
+	start.fn(start.userData);
+	return 0;
+}
+
+static void* gcu_thread_start(gcu_ThreadFn fn, void* userData)
+{
+	gcu_ThreadStart* start = (gcu_ThreadStart*)malloc(sizeof(gcu_ThreadStart));
+	if (!start)
+	{
+		return NULL;
+	}
+	start->fn = fn;
+	start->userData = userData;
+
+	HANDLE thread = CreateThread(NULL, 0, gcu_threadEntry, start, 0, NULL);
+	if (!thread)
+	{
+		free(start);
+		return NULL;
+	}
+
+	return (void*)thread;
+}
+
+static void gcu_thread_join(void* thread)
+{
+	if (thread)
+	{
+		WaitForSingleObject((HANDLE)thread, INFINITE);
+		CloseHandle((HANDLE)thread);
+	}
+}
+
+static void gcu_thread_yield(void)
+{
+	SwitchToThread();
+}
+
+static void gcu_thread_sleepMs(uint32 milliseconds)
+{
+	Sleep(milliseconds);
+}
+
+static uint64 gcu_thread_id(void)
+{
+	return (uint64)GetCurrentThreadId();
+}
+
 GABE_CPP_UTILS_API void* g_thread_createMutex(void)
 {
 	CRITICAL_SECTION* criticalSection = (CRITICAL_SECTION*)g_memory_allocate(sizeof(CRITICAL_SECTION));
@@ -1328,51 +7997,394 @@ GABE_CPP_UTILS_API void g_thread_freeMutex(void* mtx)
 	}
 }
 
-static void* g_thread_createMutexUntracked(void)
+// WaitOnAddress lives in its own import library
+#pragma comment(lib, "Synchronization.lib")
+
+static void gcu_thread_waitOnAddress(volatile uint32* address, uint32 expected)
+{
+	WaitOnAddress(address, &expected, sizeof(uint32), INFINITE);
+}
+
+static void gcu_thread_wakeOneOnAddress(volatile uint32* address)
+{
+	WakeByAddressSingle((PVOID)address);
+}
+
+static void gcu_thread_wakeAllOnAddress(volatile uint32* address)
+{
+	WakeByAddressAll((PVOID)address);
+}
+
+#elif defined(__linux__) // End ThreadImpl _WIN32
+// Begin ThreadImpl Linux
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/futex.h>
+
+typedef struct gcu_ThreadStart
+{
+	gcu_ThreadFn fn;
+	void* userData;
+} gcu_ThreadStart;
+
+static void* gcu_threadEntry(void* param)
+{
+	gcu_ThreadStart start = *(gcu_ThreadStart*)param;
+	free(param);
+	start.fn(start.userData);
+	return NULL;
+}
+
+static void* gcu_thread_start(gcu_ThreadFn fn, void* userData)
 {
-	CRITICAL_SECTION* criticalSection = (CRITICAL_SECTION*)malloc(sizeof(CRITICAL_SECTION));
-	if (criticalSection)
+	gcu_ThreadStart* start = (gcu_ThreadStart*)malloc(sizeof(gcu_ThreadStart));
+	pthread_t* thread = (pthread_t*)malloc(sizeof(pthread_t));
+	if (!start || !thread)
 	{
-		InitializeCriticalSection(criticalSection);
+		free(start);
+		free(thread);
+		return NULL;
 	}
+	start->fn = fn;
+	start->userData = userData;
 
-	return (void*)criticalSection;
+	if (pthread_create(thread, NULL, gcu_threadEntry, start) != 0)
+	{
+		free(start);
+		free(thread);
+		return NULL;
+	}
+
+	return (void*)thread;
 }
 
-static void g_thread_freeMutexUntracked(void* mtx)
+static void gcu_thread_join(void* thread)
 {
-	if (mtx)
+	if (thread)
 	{
-		CRITICAL_SECTION* critical = (CRITICAL_SECTION*)mtx;
-		DeleteCriticalSection(critical);
-		free(mtx);
+		pthread_join(*(pthread_t*)thread, NULL);
+		free(thread);
 	}
 }
 
-#elif defined(__linux__) // End ThreadImpl _WIN32
-// Begin ThreadImpl Linux
+static void gcu_thread_yield(void)
+{
+	sched_yield();
+}
+
+static void gcu_thread_sleepMs(uint32 milliseconds)
+{
+	struct timespec duration;
+	duration.tv_sec = milliseconds / 1000;
+	duration.tv_nsec = (long)(milliseconds % 1000) * 1000000L;
+	nanosleep(&duration, NULL);
+}
+
+static uint64 gcu_thread_id(void)
+{
+	// gettid is a real syscall, so only make it once per thread
+	static GCU_THREAD_LOCAL uint64 threadId = 0;
+	if (threadId == 0)
+	{
+		threadId = (uint64)syscall(SYS_gettid);
+	}
+	return threadId;
+}
+
+static void gcu_thread_waitOnAddress(volatile uint32* address, uint32 expected)
+{
+	// Private futexes skip the shared memory lookup, these never leave the process
+	syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void gcu_thread_wakeOneOnAddress(volatile uint32* address)
+{
+	syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static void gcu_thread_wakeAllOnAddress(volatile uint32* address)
+{
+	syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 0x7fffffff, NULL, NULL, 0);
+}
 
-GABE_CPP_UTILS_API void* g_thread_createMutex() n
+GABE_CPP_UTILS_API void* g_thread_createMutex(void)
 {
-	g_logger_assert(false, "TODO: Implement me.");
+	pthread_mutex_t* mutex = (pthread_mutex_t*)g_memory_allocate(sizeof(pthread_mutex_t));
+	pthread_mutex_init(mutex, NULL);
+
+	return (void*)mutex;
 }
 
 GABE_CPP_UTILS_API void g_thread_lockMutex(void* mtx)
 {
-	g_logger_assert(false, "TODO: Implement me.");
+	pthread_mutex_lock((pthread_mutex_t*)mtx);
 }
 
 GABE_CPP_UTILS_API void g_thread_releaseMutex(void* mtx)
 {
-	g_logger_assert(false, "TODO: Implement me.");
+	pthread_mutex_unlock((pthread_mutex_t*)mtx);
 }
 
 GABE_CPP_UTILS_API void g_thread_freeMutex(void* mtx)
 {
-	g_logger_assert(false, "TODO: Implement me.");
+	if (mtx)
+	{
+		pthread_mutex_destroy((pthread_mutex_t*)mtx);
+		g_memory_free(mtx);
+	}
 }
 
 #endif // End ThreadImpl Linux
+
+// ----------------------------------
+// Embedded locks Common C11
+// ----------------------------------
+GABE_CPP_UTILS_API void g_thread_mutexLock(g_thread_mutex* mtx)
+{
+	uint32 unlocked = 0;
+	if (gcu_atomic_casU32(&mtx->state, &unlocked, 1))
+	{
+		return;
+	}
+
+	// Most critical sections are over before a trip through the kernel would be, so spin first. Like
+	// glibc's adaptive mutexes, spin for about twice as long as it usually takes and keep a running
+	// average of how long that was.
+	uint32 averageSpins = gcu_atomic_loadU32(&mtx->spins);
+	uint32 maxSpins = averageSpins * 2 + 10;
+	if (maxSpins > GABE_THREAD_MUTEX_MAX_SPINS)
+	{
+		maxSpins = GABE_THREAD_MUTEX_MAX_SPINS;
+	}
+
+	bool acquired = false;
+	uint32 numSpins = 0;
+	while (!acquired && numSpins < maxSpins)
+	{
+		gcu_atomic_pause();
+		numSpins++;
+
+		// Only try the CAS once it looks free, so the spinners don't keep stealing the cache line
+		unlocked = 0;
+		acquired = gcu_atomic_loadU32(&mtx->state) == 0 && gcu_atomic_casU32(&mtx->state, &unlocked, 1);
+	}
+
+	if (!acquired)
+	{
+		// Mark it as contended before sleeping, so whoever unlocks it next knows to wake somebody up
+		while (gcu_atomic_exchangeU32(&mtx->state, 2) != 0)
+		{
+			gcu_thread_waitOnAddress(&mtx->state, 2);
+		}
+	}
+
+	// We own the lock now, so nobody else is writing this
+	gcu_atomic_storeU32(&mtx->spins, (uint32)((int32)averageSpins + ((int32)numSpins - (int32)averageSpins) / 8));
+}
+
+GABE_CPP_UTILS_API bool g_thread_mutexTryLock(g_thread_mutex* mtx)
+{
+	uint32 unlocked = 0;
+	return gcu_atomic_casU32(&mtx->state, &unlocked, 1);
+}
+
+GABE_CPP_UTILS_API void g_thread_mutexUnlock(g_thread_mutex* mtx)
+{
+	if (gcu_atomic_exchangeU32(&mtx->state, 0) == 2)
+	{
+		gcu_thread_wakeOneOnAddress(&mtx->state);
+	}
+}
+
+GABE_CPP_UTILS_API void g_thread_spinlockLock(g_thread_spinlock* lock)
+{
+	uint32 ticket = gcu_atomic_addU32(&lock->nextTicket, 1);
+	uint32 numSpins = 0;
+	while (gcu_atomic_loadU32(&lock->nowServing) != ticket)
+	{
+		gcu_atomic_pause();
+
+		// The lock holder might not be running at all when there are more threads than cores
+		numSpins++;
+		if ((numSpins & 63) == 0)
+		{
+			gcu_thread_yield();
+		}
+	}
+}
+
+GABE_CPP_UTILS_API bool g_thread_spinlockTryLock(g_thread_spinlock* lock)
+{
+	uint32 ticket = gcu_atomic_loadU32(&lock->nowServing);
+	return gcu_atomic_casU32(&lock->nextTicket, &ticket, ticket + 1);
+}
+
+GABE_CPP_UTILS_API void g_thread_spinlockUnlock(g_thread_spinlock* lock)
+{
+	// Only the thread holding the lock ever writes this
+	gcu_atomic_storeU32(&lock->nowServing, gcu_atomic_loadU32(&lock->nowServing) + 1);
+}
+
+#define GCU_RWLOCK_WRITER 0x80000000u
+
+static bool gcu_thread_rwlockReadersMustWait(g_thread_rwlock* lock, uint32 state)
+{
+	// Writers go first as soon as one is waiting, otherwise a steady stream of readers could keep
+	// the count above zero forever
+	return (state & GCU_RWLOCK_WRITER) != 0 || gcu_atomic_loadU32(&lock->numWaitingWriters) != 0;
+}
+
+GABE_CPP_UTILS_API void g_thread_rwlockReadLock(g_thread_rwlock* lock)
+{
+	for (;;)
+	{
+		uint32 state = gcu_atomic_loadU32(&lock->state);
+		if (!gcu_thread_rwlockReadersMustWait(lock, state))
+		{
+			if (gcu_atomic_casU32(&lock->state, &state, state + 1))
+			{
+				return;
+			}
+
+			// Another reader got in first, just try again
+			continue;
+		}
+
+		// Read the wake sequence before checking the state again. If the writer finishes in between,
+		// it has already bumped the sequence and the wait returns straight away.
+		gcu_atomic_addU32(&lock->numSleepingReaders, 1);
+		gcu_atomic_fence();
+		uint32 wakeSequence = gcu_atomic_loadU32(&lock->readerWakeSequence);
+		if (gcu_thread_rwlockReadersMustWait(lock, gcu_atomic_loadU32(&lock->state)))
+		{
+			gcu_thread_waitOnAddress(&lock->readerWakeSequence, wakeSequence);
+		}
+		gcu_atomic_addU32(&lock->numSleepingReaders, (uint32)-1);
+	}
+}
+
+GABE_CPP_UTILS_API bool g_thread_rwlockTryReadLock(g_thread_rwlock* lock)
+{
+	uint32 state = gcu_atomic_loadU32(&lock->state);
+	return !gcu_thread_rwlockReadersMustWait(lock, state) && gcu_atomic_casU32(&lock->state, &state, state + 1);
+}
+
+GABE_CPP_UTILS_API void g_thread_rwlockReadUnlock(g_thread_rwlock* lock)
+{
+	// The last reader out lets the writer that's waiting for them in. Only the writer holding
+	// writerMutex ever sleeps on the state, so waking one is enough.
+	if (gcu_atomic_addU32(&lock->state, (uint32)-1) - 1 == GCU_RWLOCK_WRITER)
+	{
+		gcu_thread_wakeOneOnAddress(&lock->state);
+	}
+}
+
+GABE_CPP_UTILS_API void g_thread_rwlockWriteLock(g_thread_rwlock* lock)
+{
+	// Announce ourselves before queueing on the mutex, so new readers start waiting right away
+	gcu_atomic_addU32(&lock->numWaitingWriters, 1);
+	g_thread_mutexLock(&lock->writerMutex);
+	uint32 state = gcu_atomic_addU32(&lock->state, GCU_RWLOCK_WRITER) + GCU_RWLOCK_WRITER;
+	gcu_atomic_addU32(&lock->numWaitingWriters, (uint32)-1);
+
+	// No new readers can get in now, wait for the ones already inside to leave
+	while (state != GCU_RWLOCK_WRITER)
+	{
+		gcu_thread_waitOnAddress(&lock->state, state);
+		state = gcu_atomic_loadU32(&lock->state);
+	}
+}
+
+GABE_CPP_UTILS_API bool g_thread_rwlockTryWriteLock(g_thread_rwlock* lock)
+{
+	if (!g_thread_mutexTryLock(&lock->writerMutex))
+	{
+		return false;
+	}
+
+	uint32 unlocked = 0;
+	if (gcu_atomic_casU32(&lock->state, &unlocked, GCU_RWLOCK_WRITER))
+	{
+		return true;
+	}
+
+	g_thread_mutexUnlock(&lock->writerMutex);
+	return false;
+}
+
+GABE_CPP_UTILS_API void g_thread_rwlockWriteUnlock(g_thread_rwlock* lock)
+{
+	gcu_atomic_storeU32(&lock->state, 0);
+	g_thread_mutexUnlock(&lock->writerMutex);
+
+	// Same handshake as the reader side: bump the sequence, then check for sleepers. Either we see
+	// the reader's count or the reader sees the new sequence, never neither.
+	gcu_atomic_addU32(&lock->readerWakeSequence, 1);
+	gcu_atomic_fence();
+	if (gcu_atomic_loadU32(&lock->numSleepingReaders) != 0)
+	{
+		gcu_thread_wakeAllOnAddress(&lock->readerWakeSequence);
+	}
+}
+
+#undef GCU_RWLOCK_WRITER
+
+GABE_CPP_UTILS_API void g_thread_seqlockWriteBegin(g_thread_seqlock* lock)
+{
+	uint32 numSpins = 0;
+	for (;;)
+	{
+		uint32 sequence = gcu_atomic_loadU32(&lock->sequence);
+		if ((sequence & 1) == 0 && gcu_atomic_casU32(&lock->sequence, &sequence, sequence + 1))
+		{
+			// The CAS alone doesn't keep the caller's stores to the data from being seen before the odd
+			// sequence on weaker CPUs, and then a reader could pair new data with the old sequence
+			gcu_atomic_fence();
+			return;
+		}
+
+		gcu_atomic_pause();
+		numSpins++;
+		if ((numSpins & 63) == 0)
+		{
+			gcu_thread_yield();
+		}
+	}
+}
+
+GABE_CPP_UTILS_API void g_thread_seqlockWriteEnd(g_thread_seqlock* lock)
+{
+	// Only the writer touches the sequence while it's odd
+	gcu_atomic_storeU32(&lock->sequence, gcu_atomic_loadU32(&lock->sequence) + 1);
+}
+
+GABE_CPP_UTILS_API uint32 g_thread_seqlockReadBegin(const g_thread_seqlock* lock)
+{
+	uint32 numSpins = 0;
+	uint32 sequence = gcu_atomic_loadU32(&lock->sequence);
+	while ((sequence & 1) != 0)
+	{
+		// A write is in the middle of happening, there's no point copying anything until it's done
+		gcu_atomic_pause();
+		numSpins++;
+		if ((numSpins & 63) == 0)
+		{
+			gcu_thread_yield();
+		}
+		sequence = gcu_atomic_loadU32(&lock->sequence);
+	}
+
+	return sequence;
+}
+
+GABE_CPP_UTILS_API bool g_thread_seqlockReadRetry(const g_thread_seqlock* lock, uint32 sequence)
+{
+	// Keeps the reads of the data from sinking below the second read of the sequence
+	gcu_atomic_fence();
+	return gcu_atomic_loadU32(&lock->sequence) != sequence;
+}
 #endif // CPP_UTILS_IMPL
 
 /*
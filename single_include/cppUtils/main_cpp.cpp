@@ -25,6 +25,9 @@
 using namespace CppUtils;
 
 #include <cppUtils/cppMaybe.hpp>
+#include <cppUtils/cppHandlePool.hpp>
+#include <cppUtils/cppThreadPool.hpp>
+#include <cppUtils/cppQueues.hpp>
 
 // -------------------- String Test Suite --------------------
 namespace StringTestSuite
@@ -673,6 +676,163 @@ namespace MaybeTestSuite
 	}
 }
 
+// -------------------- Handle Pool Test Suite --------------------
+namespace HandlePoolTestSuite
+{
+	struct PooledObject
+	{
+		int value;
+	};
+
+	DEFINE_TEST(handlePool_CreateShouldResolve)
+	{
+		HandlePool<PooledObject> pool = {};
+		Handle<PooledObject> a = pool.create(PooledObject{ 1 });
+		Handle<PooledObject> b = pool.create(PooledObject{ 2 });
+
+		ASSERT_FALSE(a.isNull());
+		ASSERT_NOT_EQUAL(a, b);
+		ASSERT_EQUAL(pool.size(), 2);
+		ASSERT_NOT_NULL(pool.get(a));
+		ASSERT_EQUAL(pool.get(a)->value, 1);
+		ASSERT_EQUAL(pool.get(b)->value, 2);
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(handlePool_StaleHandleShouldNotResolve)
+	{
+		HandlePool<PooledObject> pool = {};
+		Handle<PooledObject> a = pool.create(PooledObject{ 1 });
+
+		ASSERT_TRUE(pool.destroy(a));
+		ASSERT_NULL(pool.get(a));
+		ASSERT_FALSE(pool.destroy(a));
+
+		// The slot gets reused, but the old handle has the wrong generation
+		Handle<PooledObject> b = pool.create(PooledObject{ 2 });
+		ASSERT_EQUAL(a.index, b.index);
+		ASSERT_NOT_EQUAL(a.generation, b.generation);
+		ASSERT_NULL(pool.get(a));
+		ASSERT_EQUAL(pool.get(b)->value, 2);
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(handlePool_NullHandleShouldNotResolve)
+	{
+		HandlePool<PooledObject> pool = {};
+		pool.create(PooledObject{ 1 });
+
+		Handle<PooledObject> nullHandle = {};
+		ASSERT_TRUE(nullHandle.isNull());
+		ASSERT_NULL(pool.get(nullHandle));
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(handlePool_DestroyShouldKeepDenseStoragePacked)
+	{
+		HandlePool<PooledObject> pool = {};
+		Handle<PooledObject> handles[100];
+		for (int i = 0; i < 100; i++)
+		{
+			handles[i] = pool.create(PooledObject{ i });
+		}
+
+		for (int i = 0; i < 100; i += 2)
+		{
+			ASSERT_TRUE(pool.destroy(handles[i]));
+		}
+
+		ASSERT_EQUAL(pool.size(), 50);
+		int sum = 0;
+		for (const PooledObject& obj : pool)
+		{
+			ASSERT_EQUAL(obj.value % 2, 1);
+			sum += obj.value;
+		}
+		ASSERT_EQUAL(sum, 2500);
+
+		for (int i = 1; i < 100; i += 2)
+		{
+			ASSERT_EQUAL(pool.get(handles[i])->value, i);
+		}
+
+		for (uint32_t i = 0; i < pool.size(); i++)
+		{
+			ASSERT_EQUAL(pool.get(pool.handleAt(i)), pool.begin() + i);
+		}
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(handlePool_HandleShouldRoundTripThroughU64)
+	{
+		HandlePool<PooledObject> pool = {};
+		Handle<PooledObject> a = pool.create(PooledObject{ 7 });
+
+		ASSERT_EQUAL(Handle<PooledObject>::fromU64(a.toU64()), a);
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(handlePool_CreateShouldCopyAnElementWhileGrowing)
+	{
+		HandlePool<std::string> pool = {};
+		Handle<std::string> first = pool.create("a string that's too long for the small buffer");
+		for (int i = 1; i < 8; i++)
+		{
+			pool.create("filler");
+		}
+
+		// The pool is full, so this grows it while the argument still points into the old storage
+		Handle<std::string> copy = pool.create(*pool.get(first));
+		ASSERT_EQUAL(pool.size(), 9);
+		ASSERT_TRUE(*pool.get(copy) == "a string that's too long for the small buffer");
+		ASSERT_TRUE(*pool.get(first) == *pool.get(copy));
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(handlePool_ObjectsShouldBeAligned)
+	{
+		struct alignas(64) AlignedObject
+		{
+			int value;
+		};
+
+		HandlePool<AlignedObject> pool = {};
+		for (int i = 0; i < 20; i++)
+		{
+			AlignedObject* obj = pool.get(pool.create(AlignedObject{ i }));
+			ASSERT_EQUAL((uintptr_t)obj % alignof(AlignedObject), 0);
+		}
+
+		pool.free();
+		END_TEST;
+	}
+
+	void setupHandlePoolTestSuite()
+	{
+		Tests::TestSuite& testSuite = Tests::addTestSuite("cppHandlePool.hpp");
+
+		ADD_TEST(testSuite, handlePool_CreateShouldResolve);
+		ADD_TEST(testSuite, handlePool_StaleHandleShouldNotResolve);
+		ADD_TEST(testSuite, handlePool_NullHandleShouldNotResolve);
+		ADD_TEST(testSuite, handlePool_DestroyShouldKeepDenseStoragePacked);
+		ADD_TEST(testSuite, handlePool_HandleShouldRoundTripThroughU64);
+		ADD_TEST(testSuite, handlePool_CreateShouldCopyAnElementWhileGrowing);
+		ADD_TEST(testSuite, handlePool_ObjectsShouldBeAligned);
+	}
+}
+
 // -------------------- Print Test Suite --------------------
 namespace PrintTestSuite
 {
@@ -1364,10 +1524,425 @@ namespace PrintTestSuite
 // -------------------- Thread Pool Test Suite --------------------
 namespace ThreadPoolTestSuite
 {
+	DEFINE_TEST(threadPool_SubmitShouldRunEveryTask)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
 
-	DEFINE_TEST(dummy)
+		std::atomic<uint32_t> numRun = 0;
+		for (uint32_t i = 0; i < 10000; i++)
+		{
+			pool.submit([&numRun]() { numRun++; });
+		}
+		pool.wait();
+
+		ASSERT_EQUAL(numRun.load(), 10000);
+
+		pool.free();
+		END_TEST;
+	}
+
+	struct TreeNode
 	{
-		ASSERT_TRUE(false);
+		ThreadPool* pool;
+		std::atomic<uint32_t>* numLeaves;
+		uint32_t depth;
+
+		void operator()() const
+		{
+			if (depth == 0)
+			{
+				(*numLeaves)++;
+				return;
+			}
+
+			pool->submit(TreeNode{ pool, numLeaves, depth - 1 });
+			pool->submit(TreeNode{ pool, numLeaves, depth - 1 });
+		}
+	};
+
+	DEFINE_TEST(threadPool_TasksShouldBeAbleToSubmitTasks)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		std::atomic<uint32_t> numLeaves = 0;
+		pool.submit(TreeNode{ &pool, &numLeaves, 12 });
+		pool.wait();
+
+		ASSERT_EQUAL(numLeaves.load(), 1 << 12);
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(threadPool_FullPoolShouldRunTasksInline)
+	{
+		ThreadPool pool = {};
+		pool.init(2, 4);
+
+		std::atomic<uint32_t> numRun = 0;
+		std::atomic<bool> release = false;
+		// Keep the workers busy so the task slots fill up
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			pool.submit([&release]()
+			{
+				while (!release.load())
+				{
+					std::this_thread::yield();
+				}
+			});
+		}
+
+		std::thread::id submitter = std::this_thread::get_id();
+		std::atomic<uint32_t> numRunInline = 0;
+		for (uint32_t i = 0; i < 100; i++)
+		{
+			pool.submit([&numRun, &numRunInline, submitter]()
+			{
+				numRun++;
+				if (std::this_thread::get_id() == submitter)
+				{
+					numRunInline++;
+				}
+			});
+		}
+		release = true;
+		pool.wait();
+
+		ASSERT_EQUAL(numRun.load(), 100);
+		ASSERT_TRUE(numRunInline.load() > 0);
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(threadPool_ParkedWorkersShouldWakeUp)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		std::atomic<uint32_t> numRun = 0;
+		for (uint32_t round = 0; round < 5; round++)
+		{
+			// Long enough for every worker to give up spinning and park
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+			std::thread::id submitter = std::this_thread::get_id();
+			std::atomic<bool> ranOnWorker = false;
+			pool.submit([&numRun, &ranOnWorker, submitter]()
+			{
+				numRun++;
+				ranOnWorker = std::this_thread::get_id() != submitter;
+			});
+
+			// Don't help here, a worker has to wake up and take it
+			while (numRun.load() != round + 1)
+			{
+				std::this_thread::yield();
+			}
+			pool.wait();
+			ASSERT_TRUE(ranOnWorker.load());
+		}
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(threadPool_ParallelForShouldVisitEveryIndexOnce)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		const size_t numIndices = 100000;
+		std::vector<uint8_t> visits(numIndices, 0);
+		pool.parallelFor(0, numIndices, 64, [&visits](size_t i) { visits[i]++; });
+
+		bool everyIndexOnce = true;
+		for (size_t i = 0; i < numIndices; i++)
+		{
+			everyIndexOnce = everyIndexOnce && visits[i] == 1;
+		}
+		ASSERT_TRUE(everyIndexOnce);
+
+		// Empty ranges and the automatic grain
+		pool.parallelFor(10, 10, 0, [&visits](size_t i) { visits[i]++; });
+		pool.parallelFor(0, numIndices, 0, [&visits](size_t i) { visits[i]++; });
+		ASSERT_EQUAL(visits[10], 2);
+		ASSERT_EQUAL(visits[numIndices - 1], 2);
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(threadPool_ParallelForShouldWorkInsideTasks)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		std::atomic<uint32_t> sum = 0;
+		pool.parallelFor(0, 16, 1, [&pool, &sum](size_t)
+		{
+			pool.parallelFor(0, 1000, 16, [&sum](size_t i) { sum += (uint32_t)i; });
+		});
+
+		ASSERT_EQUAL(sum.load(), 16 * 499500);
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(threadPool_ParallelReduceShouldCombineInOrder)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		uint64_t sum = pool.parallelReduce(0, 1000000, 0, (uint64_t)0,
+			[](size_t i) { return (uint64_t)i; },
+			[](uint64_t a, uint64_t b) { return a + b; });
+		ASSERT_EQUAL(sum, 499999500000ull);
+
+		// Concatenating digits isn't commutative, so this only matches if the pieces are combined left to right
+		std::string digits = pool.parallelReduce(0, 2000, 7, std::string(),
+			[](size_t i) { return std::string(1, (char)('0' + i % 10)); },
+			[](const std::string& a, const std::string& b) { return a + b; });
+		std::string expected;
+		for (size_t i = 0; i < 2000; i++)
+		{
+			expected += (char)('0' + i % 10);
+		}
+		ASSERT_TRUE(digits == expected);
+
+		pool.free();
+		END_TEST;
+	}
+
+	struct GraphStage
+	{
+		std::atomic<uint32_t>* clock;
+		uint32_t* finishedAt;
+	};
+
+	DEFINE_TEST(taskGraph_NodesShouldRunAfterTheirDependencies)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		// Ten layers of twenty nodes, every node depends on three nodes from the layer before it
+		const uint32_t numLayers = 10;
+		const uint32_t layerWidth = 20;
+		std::atomic<uint32_t> clock = 0;
+		uint32_t finishedAt[numLayers * layerWidth] = {};
+		bool startedTooEarly = false;
+
+		TaskGraph graph = {};
+		for (uint32_t layer = 0; layer < numLayers; layer++)
+		{
+			for (uint32_t i = 0; i < layerWidth; i++)
+			{
+				uint32_t nodeIndex = layer * layerWidth + i;
+				uint32_t* finishedAtPtr = finishedAt;
+				std::atomic<uint32_t>* clockPtr = &clock;
+				bool* startedTooEarlyPtr = &startedTooEarly;
+				uint32_t node = graph.addNode([nodeIndex, finishedAtPtr, clockPtr, startedTooEarlyPtr, layerWidth]()
+				{
+					if (nodeIndex >= layerWidth)
+					{
+						uint32_t previousLayer = nodeIndex - nodeIndex % layerWidth - layerWidth;
+						for (uint32_t j = 0; j < 3; j++)
+						{
+							if (finishedAtPtr[previousLayer + (nodeIndex + j) % layerWidth] == 0)
+							{
+								*startedTooEarlyPtr = true;
+							}
+						}
+					}
+					finishedAtPtr[nodeIndex] = ++(*clockPtr);
+				});
+
+				if (layer > 0)
+				{
+					for (uint32_t j = 0; j < 3; j++)
+					{
+						graph.addEdge((layer - 1) * layerWidth + (i + j) % layerWidth, node);
+					}
+				}
+			}
+		}
+
+		// Same graph every "frame"
+		for (uint32_t frame = 0; frame < 20; frame++)
+		{
+			for (uint32_t i = 0; i < numLayers * layerWidth; i++)
+			{
+				finishedAt[i] = 0;
+			}
+
+			ASSERT_TRUE(graph.run(pool));
+			ASSERT_FALSE(startedTooEarly);
+		}
+		ASSERT_EQUAL(clock.load(), 20 * numLayers * layerWidth);
+
+		graph.free();
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(taskGraph_CycleShouldNotRun)
+	{
+		ThreadPool pool = {};
+		pool.init(2);
+
+		std::atomic<uint32_t> numRun = 0;
+		TaskGraph graph = {};
+		uint32_t a = graph.addNode([&numRun]() { numRun++; });
+		uint32_t b = graph.addNode([&numRun]() { numRun++; });
+		uint32_t c = graph.addNode([&numRun]() { numRun++; });
+		graph.addEdge(a, b);
+		graph.addEdge(b, c);
+		graph.addEdge(c, b);
+
+		ASSERT_FALSE(graph.run(pool));
+		ASSERT_EQUAL(numRun.load(), 0);
+
+		graph.free();
+		pool.free();
+		END_TEST;
+	}
+
+	enum class FutureError : uint8_t
+	{
+		TooBig,
+		Odd,
+	};
+
+	DEFINE_TEST(future_AsyncShouldResolveToMaybe)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		{
+			Future<uint32_t, FutureError> value = pool.async([]() { return Maybe<uint32_t, FutureError>(42u); });
+			Future<uint32_t, FutureError> error = pool.async([]() { return Maybe<uint32_t, FutureError>(FutureError::TooBig); });
+
+			ASSERT_TRUE(value.get().hasValue());
+			ASSERT_EQUAL(value.get().value(), 42);
+			ASSERT_FALSE(error.get().hasValue());
+			ASSERT_TRUE(error.get().error() == FutureError::TooBig);
+			ASSERT_TRUE(value.isReady());
+		}
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(future_ThenShouldChainAndPassErrorsThrough)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		{
+			auto halve = [](const uint32_t& value)
+			{
+				return value % 2 == 0
+					? Maybe<uint32_t, FutureError>(value / 2)
+					: Maybe<uint32_t, FutureError>(FutureError::Odd);
+			};
+
+			std::atomic<uint32_t> numCalls = 0;
+			auto countedHalve = [&numCalls, halve](const uint32_t& value) { numCalls++; return halve(value); };
+
+			Future<uint32_t, FutureError> quarter = pool.async([]() { return Maybe<uint32_t, FutureError>(100u); })
+				.then(countedHalve)
+				.then(countedHalve);
+			ASSERT_TRUE(quarter.get().hasValue());
+			ASSERT_EQUAL(quarter.get().value(), 25);
+
+			// 25 is odd, so the last step never runs and the error comes straight through
+			Future<uint32_t, FutureError> failed = quarter.then(countedHalve).then(countedHalve);
+			ASSERT_FALSE(failed.get().hasValue());
+			ASSERT_TRUE(failed.get().error() == FutureError::Odd);
+			ASSERT_EQUAL(numCalls.load(), 3);
+
+			// Changing the value type along the way
+			Future<float, FutureError> asFloat = quarter.then([](const uint32_t& value) { return Maybe<float, FutureError>((float)value * 0.5f); });
+			ASSERT_TRUE(asFloat.get().hasValue());
+			ASSERT_TRUE(asFloat.get().value() == 12.5f);
+		}
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(future_WhenAllShouldWaitForEveryFuture)
+	{
+		// Few blocks per thread, so most of the futures have to fall back to the heap
+		ThreadPool pool = {};
+		pool.init(4, 8);
+
+		{
+			const uint32_t numFutures = 200;
+			std::atomic<uint32_t> numResolved = 0;
+			Future<uint32_t, FutureError> futures[numFutures];
+			for (uint32_t i = 0; i < numFutures; i++)
+			{
+				futures[i] = pool.async([&numResolved, i]() { numResolved++; return Maybe<uint32_t, FutureError>(i); });
+			}
+
+			Future<uint32_t, FutureError> all = whenAll(futures, numFutures);
+			ASSERT_TRUE(all.get().hasValue());
+			ASSERT_EQUAL(all.get().value(), numFutures);
+			ASSERT_EQUAL(numResolved.load(), numFutures);
+
+			futures[numFutures / 2] = pool.async([]() { return Maybe<uint32_t, FutureError>(FutureError::TooBig); });
+			Future<uint32_t, FutureError> failed = whenAll(futures, numFutures);
+			ASSERT_FALSE(failed.get().hasValue());
+			ASSERT_TRUE(failed.get().error() == FutureError::TooBig);
+		}
+
+		pool.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(future_WhenAnyShouldResolveWithTheFirstFuture)
+	{
+		ThreadPool pool = {};
+		pool.init(4);
+
+		{
+			std::atomic<bool> release = false;
+			Future<uint32_t, FutureError> futures[3];
+			futures[0] = pool.async([&release]()
+			{
+				while (!release.load())
+				{
+					std::this_thread::yield();
+				}
+				return Maybe<uint32_t, FutureError>(0u);
+			});
+			futures[1] = pool.async([]() { return Maybe<uint32_t, FutureError>(1u); });
+			futures[2] = pool.async([&release]()
+			{
+				while (!release.load())
+				{
+					std::this_thread::yield();
+				}
+				return Maybe<uint32_t, FutureError>(2u);
+			});
+
+			Future<uint32_t, FutureError> any = whenAny(futures, 3);
+			while (!any.isReady())
+			{
+				std::this_thread::yield();
+			}
+			ASSERT_EQUAL(any.get().value(), 1);
+
+			release = true;
+			pool.wait();
+		}
+
+		pool.free();
 		END_TEST;
 	}
 
@@ -1375,7 +1950,806 @@ namespace ThreadPoolTestSuite
 	{
 		Tests::TestSuite& testSuite = Tests::addTestSuite("cppThreadPool.hpp");
 
-		ADD_TEST(testSuite, dummy);
+		ADD_TEST(testSuite, threadPool_SubmitShouldRunEveryTask);
+		ADD_TEST(testSuite, threadPool_TasksShouldBeAbleToSubmitTasks);
+		ADD_TEST(testSuite, threadPool_FullPoolShouldRunTasksInline);
+		ADD_TEST(testSuite, threadPool_ParkedWorkersShouldWakeUp);
+		ADD_TEST(testSuite, threadPool_ParallelForShouldVisitEveryIndexOnce);
+		ADD_TEST(testSuite, threadPool_ParallelForShouldWorkInsideTasks);
+		ADD_TEST(testSuite, threadPool_ParallelReduceShouldCombineInOrder);
+		ADD_TEST(testSuite, taskGraph_NodesShouldRunAfterTheirDependencies);
+		ADD_TEST(testSuite, taskGraph_CycleShouldNotRun);
+		ADD_TEST(testSuite, future_AsyncShouldResolveToMaybe);
+		ADD_TEST(testSuite, future_ThenShouldChainAndPassErrorsThrough);
+		ADD_TEST(testSuite, future_WhenAllShouldWaitForEveryFuture);
+		ADD_TEST(testSuite, future_WhenAnyShouldResolveWithTheFirstFuture);
+	}
+
+}
+
+// -------------------- Queues Test Suite --------------------
+namespace QueuesTestSuite
+{
+	DEFINE_TEST(spscQueue_ShouldBeFifoAndStopWhenFull)
+	{
+		SpscQueue<uint32_t> queue = {};
+		queue.init(5);
+		ASSERT_EQUAL(queue.capacity(), 8);
+
+		// Go around the ring a few times so the indices wrap
+		uint32_t next = 0;
+		uint32_t expected = 0;
+		for (uint32_t lap = 0; lap < 3; lap++)
+		{
+			while (queue.push(next))
+			{
+				next++;
+			}
+			ASSERT_EQUAL(queue.size(), 8);
+
+			uint32_t value;
+			for (uint32_t i = 0; i < 5; i++)
+			{
+				ASSERT_TRUE(queue.pop(value));
+				ASSERT_EQUAL(value, expected);
+				expected++;
+			}
+		}
+
+		uint32_t value;
+		while (queue.pop(value))
+		{
+			ASSERT_EQUAL(value, expected);
+			expected++;
+		}
+		ASSERT_EQUAL(expected, next);
+		ASSERT_EQUAL(queue.size(), 0);
+
+		queue.free();
+
+		// Whatever is left over gets destroyed by free(), so this shouldn't leak
+		SpscQueue<std::string> strings = {};
+		strings.init(4);
+		ASSERT_TRUE(strings.push(std::string(64, 'a')));
+		ASSERT_TRUE(strings.push(std::string(100, 'b')));
+		std::string first;
+		ASSERT_TRUE(strings.pop(first));
+		ASSERT_EQUAL(first, std::string(64, 'a'));
+		strings.free();
+
+		END_TEST;
+	}
+
+	DEFINE_TEST(spscQueue_ConsumerShouldSeeProducerOrder)
+	{
+		SpscQueue<uint32_t> queue = {};
+		queue.init(64);
+
+		constexpr uint32_t numItems = 200000;
+		std::thread producer([&queue]()
+		{
+			for (uint32_t i = 0; i < numItems; i++)
+			{
+				while (!queue.push(i))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		uint32_t expected = 0;
+		bool inOrder = true;
+		while (expected < numItems)
+		{
+			uint32_t value;
+			if (!queue.pop(value))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			inOrder = inOrder && value == expected;
+			expected++;
+		}
+		producer.join();
+
+		ASSERT_TRUE(inOrder);
+		ASSERT_EQUAL(queue.size(), 0);
+
+		queue.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(mpmcQueue_EveryPushShouldBePoppedOnce)
+	{
+		MpmcQueue<uint32_t> queue = {};
+		queue.init(128);
+
+		constexpr uint32_t numProducers = 4;
+		constexpr uint32_t numConsumers = 4;
+		constexpr uint32_t itemsPerProducer = 50000;
+		constexpr uint32_t numItems = numProducers * itemsPerProducer;
+
+		std::atomic<uint32_t> numPopped = 0;
+		std::atomic<uint64_t> sum = 0;
+		std::vector<std::atomic<uint8_t>> seen(numItems);
+		std::vector<std::thread> threads;
+		for (uint32_t p = 0; p < numProducers; p++)
+		{
+			threads.emplace_back([&queue, p]()
+			{
+				for (uint32_t i = p * itemsPerProducer; i < (p + 1) * itemsPerProducer; i++)
+				{
+					while (!queue.push(i))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		for (uint32_t c = 0; c < numConsumers; c++)
+		{
+			threads.emplace_back([&]()
+			{
+				while (numPopped.load() < numItems)
+				{
+					uint32_t value;
+					if (!queue.pop(value))
+					{
+						std::this_thread::yield();
+						continue;
+					}
+
+					seen[value]++;
+					sum += value;
+					numPopped++;
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		ASSERT_EQUAL(numPopped.load(), numItems);
+		ASSERT_EQUAL(sum.load(), (uint64_t)numItems * (numItems - 1) / 2);
+		bool everyItemOnce = true;
+		for (std::atomic<uint8_t>& count : seen)
+		{
+			everyItemOnce = everyItemOnce && count.load() == 1;
+		}
+		ASSERT_TRUE(everyItemOnce);
+		ASSERT_EQUAL(queue.size(), 0);
+
+		queue.free();
+		END_TEST;
+	}
+
+	DEFINE_TEST(queues_BatchesShouldStopAtCapacity)
+	{
+		uint32_t items[20];
+		for (uint32_t i = 0; i < 20; i++)
+		{
+			items[i] = i;
+		}
+
+		SpscQueue<uint32_t> spsc = {};
+		spsc.init(16);
+		MpmcQueue<uint32_t> mpmc = {};
+		mpmc.init(16);
+
+		ASSERT_EQUAL(spsc.pushBatch(items, 10), 10);
+		ASSERT_EQUAL(spsc.pushBatch(items + 10, 10), 6);
+		ASSERT_EQUAL(spsc.pushBatch(items, 1), 0);
+		ASSERT_EQUAL(mpmc.pushBatch(items, 10), 10);
+		ASSERT_EQUAL(mpmc.pushBatch(items + 10, 10), 6);
+		ASSERT_EQUAL(mpmc.pushBatch(items, 1), 0);
+
+		uint32_t out[20];
+		ASSERT_EQUAL(spsc.popBatch(out, 20), 16);
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			ASSERT_EQUAL(out[i], i);
+		}
+		ASSERT_EQUAL(mpmc.popBatch(out, 4), 4);
+		ASSERT_EQUAL(mpmc.popBatch(out + 4, 20), 12);
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			ASSERT_EQUAL(out[i], i);
+		}
+		ASSERT_EQUAL(spsc.popBatch(out, 20), 0);
+		ASSERT_EQUAL(mpmc.popBatch(out, 20), 0);
+
+		// Batches and single pushes share the same sequence numbers, so they can be mixed
+		ASSERT_TRUE(mpmc.push(100u));
+		ASSERT_EQUAL(mpmc.pushBatch(items, 3), 3);
+		uint32_t value;
+		ASSERT_TRUE(mpmc.pop(value));
+		ASSERT_EQUAL(value, 100);
+		ASSERT_EQUAL(mpmc.popBatch(out, 20), 3);
+		ASSERT_EQUAL(out[2], 2);
+
+		spsc.free();
+		mpmc.free();
+		END_TEST;
+	}
+
+	void setupQueuesTestSuite()
+	{
+		Tests::TestSuite& testSuite = Tests::addTestSuite("cppQueues.hpp");
+
+		ADD_TEST(testSuite, spscQueue_ShouldBeFifoAndStopWhenFull);
+		ADD_TEST(testSuite, spscQueue_ConsumerShouldSeeProducerOrder);
+		ADD_TEST(testSuite, mpmcQueue_EveryPushShouldBePoppedOnce);
+		ADD_TEST(testSuite, queues_BatchesShouldStopAtCapacity);
+	}
+
+}
+
+// -------------------- Thread Utils Test Suite --------------------
+#include <shared_mutex>
+
+namespace ThreadUtilsTestSuite
+{
+	template<typename Lock>
+	static uint32_t incrementWithThreads(Lock& lock, uint32_t numThreads, uint32_t incrementsPerThread)
+	{
+		uint32_t counter = 0;
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&lock, &counter, incrementsPerThread]()
+			{
+				for (uint32_t i = 0; i < incrementsPerThread; i++)
+				{
+					std::lock_guard<Lock> guard(lock);
+					counter++;
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		return counter;
+	}
+
+	DEFINE_TEST(mutex_ShouldGuardASharedCounter)
+	{
+		g_thread_mutex mtx = { 0, 0 };
+		ASSERT_EQUAL(incrementWithThreads(mtx, 4, 100000), 400000);
+		ASSERT_EQUAL(mtx.state, 0);
+		END_TEST;
+	}
+
+	DEFINE_TEST(mutex_TryLockShouldFailWhileLocked)
+	{
+		g_thread_mutex mtx = { 0, 0 };
+		g_thread_mutexLock(&mtx);
+		bool lockedElsewhere = true;
+		std::thread([&mtx, &lockedElsewhere]() { lockedElsewhere = g_thread_mutexTryLock(&mtx); }).join();
+		ASSERT_FALSE(lockedElsewhere);
+		g_thread_mutexUnlock(&mtx);
+
+		ASSERT_TRUE(g_thread_mutexTryLock(&mtx));
+		g_thread_mutexUnlock(&mtx);
+		END_TEST;
+	}
+
+	DEFINE_TEST(spinlock_ShouldGuardASharedCounter)
+	{
+		g_thread_spinlock lock = { 0, 0 };
+		ASSERT_EQUAL(incrementWithThreads(lock, 4, 100000), 400000);
+
+		ASSERT_TRUE(g_thread_spinlockTryLock(&lock));
+		ASSERT_FALSE(g_thread_spinlockTryLock(&lock));
+		g_thread_spinlockUnlock(&lock);
+		ASSERT_EQUAL(lock.nextTicket, lock.nowServing);
+		END_TEST;
+	}
+
+	DEFINE_TEST(rwlock_ReadersShouldNeverSeeAHalfFinishedWrite)
+	{
+		g_thread_rwlock lock = {};
+		// Writers keep doubled == value * 2, readers check it
+		uint32_t value = 0;
+		uint32_t doubled = 0;
+		std::atomic<uint32_t> numBadReads{ 0 };
+		std::atomic<uint32_t> numWritersLeft{ 2 };
+
+		std::vector<std::thread> threads;
+		for (int w = 0; w < 2; w++)
+		{
+			threads.emplace_back([&]()
+			{
+				for (uint32_t i = 0; i < 20000; i++)
+				{
+					std::lock_guard<g_thread_rwlock> guard(lock);
+					value++;
+					doubled = value * 2;
+				}
+				numWritersLeft--;
+			});
+		}
+		for (int r = 0; r < 3; r++)
+		{
+			threads.emplace_back([&]()
+			{
+				while (numWritersLeft.load() > 0)
+				{
+					std::shared_lock<g_thread_rwlock> guard(lock);
+					if (doubled != value * 2)
+					{
+						numBadReads++;
+					}
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		ASSERT_EQUAL(numBadReads.load(), 0);
+		ASSERT_EQUAL(value, 40000);
+		ASSERT_EQUAL(lock.state, 0);
+		END_TEST;
+	}
+
+	DEFINE_TEST(rwlock_TryLocksShouldRespectWhoHoldsIt)
+	{
+		g_thread_rwlock lock = {};
+
+		// Readers share it, writers don't
+		g_thread_rwlockReadLock(&lock);
+		ASSERT_TRUE(g_thread_rwlockTryReadLock(&lock));
+		ASSERT_FALSE(g_thread_rwlockTryWriteLock(&lock));
+		g_thread_rwlockReadUnlock(&lock);
+		g_thread_rwlockReadUnlock(&lock);
+
+		g_thread_rwlockWriteLock(&lock);
+		ASSERT_FALSE(g_thread_rwlockTryReadLock(&lock));
+		ASSERT_FALSE(g_thread_rwlockTryWriteLock(&lock));
+		g_thread_rwlockWriteUnlock(&lock);
+
+		ASSERT_TRUE(g_thread_rwlockTryWriteLock(&lock));
+		g_thread_rwlockWriteUnlock(&lock);
+		ASSERT_EQUAL(lock.state, 0);
+		END_TEST;
+	}
+
+	DEFINE_TEST(rwlock_WaitingWriterShouldKeepNewReadersOut)
+	{
+		g_thread_rwlock lock = {};
+		std::atomic<bool> writerDone{ false };
+
+		g_thread_rwlockReadLock(&lock);
+		std::thread writer([&lock, &writerDone]()
+		{
+			g_thread_rwlockWriteLock(&lock);
+			writerDone = true;
+			g_thread_rwlockWriteUnlock(&lock);
+		});
+
+		// New readers get turned away as soon as the writer shows up, even though we still hold it
+		while (g_thread_rwlockTryReadLock(&lock))
+		{
+			g_thread_rwlockReadUnlock(&lock);
+			std::this_thread::yield();
+		}
+		ASSERT_FALSE(writerDone.load());
+		ASSERT_FALSE(g_thread_rwlockTryReadLock(&lock));
+
+		g_thread_rwlockReadUnlock(&lock);
+		writer.join();
+		ASSERT_TRUE(writerDone.load());
+
+		ASSERT_TRUE(g_thread_rwlockTryReadLock(&lock));
+		g_thread_rwlockReadUnlock(&lock);
+		ASSERT_EQUAL(lock.state, 0);
+		END_TEST;
+	}
+
+	DEFINE_TEST(seqlock_ReadersShouldNeverSeeATornWrite)
+	{
+		g_thread_seqlock lock = {};
+		// Relaxed atomics so a read that overlaps a write is only thrown away, not a data race
+		std::atomic<uint32_t> value{ 0 };
+		std::atomic<uint32_t> doubled{ 0 };
+		std::atomic<bool> writerDone{ false };
+		std::atomic<uint32_t> numBadReads{ 0 };
+
+		std::vector<std::thread> threads;
+		threads.emplace_back([&]()
+		{
+			for (uint32_t i = 1; i <= 50000; i++)
+			{
+				lock.writeBegin();
+				value.store(i, std::memory_order_relaxed);
+				doubled.store(i * 2, std::memory_order_relaxed);
+				lock.writeEnd();
+			}
+			writerDone = true;
+		});
+		for (int r = 0; r < 2; r++)
+		{
+			threads.emplace_back([&]()
+			{
+				while (!writerDone.load())
+				{
+					uint32_t valueCopy;
+					uint32_t doubledCopy;
+					uint32_t sequence;
+					do
+					{
+						sequence = lock.readBegin();
+						valueCopy = value.load(std::memory_order_relaxed);
+						doubledCopy = doubled.load(std::memory_order_relaxed);
+					} while (lock.readRetry(sequence));
+
+					if (doubledCopy != valueCopy * 2)
+					{
+						numBadReads++;
+					}
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		ASSERT_EQUAL(numBadReads.load(), 0);
+
+		// Once the writer is done a read has to see its last write
+		uint32_t sequence = lock.readBegin();
+		uint32_t finalValue = value.load(std::memory_order_relaxed);
+		uint32_t finalDoubled = doubled.load(std::memory_order_relaxed);
+		ASSERT_FALSE(lock.readRetry(sequence));
+		ASSERT_EQUAL(finalValue, 50000);
+		ASSERT_EQUAL(finalDoubled, 100000);
+		END_TEST;
+	}
+
+	DEFINE_TEST(seqlock_ReadShouldCopyTheWholeValue)
+	{
+		struct Pair
+		{
+			uint64_t first;
+			uint64_t second;
+		};
+
+		g_thread_seqlock lock = {};
+		Pair shared = { 1, 2 };
+		lock.writeBegin();
+		shared.second = 3;
+		lock.writeEnd();
+
+		Pair copy = g_thread_seqlockRead(&lock, shared);
+		ASSERT_EQUAL(copy.first, 1);
+		ASSERT_EQUAL(copy.second, 3);
+		END_TEST;
+	}
+
+	void setupThreadUtilsTestSuite()
+	{
+		Tests::TestSuite& testSuite = Tests::addTestSuite("cppUtils.hpp threads");
+
+		ADD_TEST(testSuite, mutex_ShouldGuardASharedCounter);
+		ADD_TEST(testSuite, mutex_TryLockShouldFailWhileLocked);
+		ADD_TEST(testSuite, spinlock_ShouldGuardASharedCounter);
+		ADD_TEST(testSuite, rwlock_ReadersShouldNeverSeeAHalfFinishedWrite);
+		ADD_TEST(testSuite, rwlock_TryLocksShouldRespectWhoHoldsIt);
+		ADD_TEST(testSuite, rwlock_WaitingWriterShouldKeepNewReadersOut);
+		ADD_TEST(testSuite, seqlock_ReadersShouldNeverSeeATornWrite);
+		ADD_TEST(testSuite, seqlock_ReadShouldCopyTheWholeValue);
+	}
+
+}
+
+// -------------------- Logger Test Suite --------------------
+// These reach into the implementation's statics, which works since this file defines GABE_CPP_UTILS_IMPL
+namespace LoggerTestSuite
+{
+	static std::string jsonEscaped(const char* str, size_t length)
+	{
+		char buffer[256];
+		glog_Line line;
+		glog_Line_beginIn(&line, buffer, sizeof(buffer));
+		glog_Line_appendJsonEscaped(&line, str, length);
+		std::string escaped(line.data, line.length);
+		glog_Line_end(&line);
+		return escaped;
+	}
+
+	static std::string jsonFields(const g_logger_kv* fields, uint32 numFields)
+	{
+		char buffer[256];
+		glog_Line line;
+		glog_Line_beginIn(&line, buffer, sizeof(buffer));
+		glog_Line_appendJsonFields(&line, fields, numFields);
+		std::string json(line.data, line.length);
+		glog_Line_end(&line);
+		return json;
+	}
+
+	static std::string readMemorySink(g_logger_sink sink)
+	{
+		char buffer[512];
+		size_t length = g_logger_read_memory_sink(sink, buffer, sizeof(buffer));
+		return std::string(buffer, length);
+	}
+
+	DEFINE_TEST(jsonEscape_ShouldOnlyEscapeWhatJsonNeeds)
+	{
+		const char input[] = "Plain text that spans a few words, \"quoted\", C:\\path\n\tand \x01 then caf\xc3\xa9";
+		std::string escaped = jsonEscaped(input, sizeof(input) - 1);
+		ASSERT_EQUAL(escaped, std::string("Plain text that spans a few words, \\\"quoted\\\", C:\\\\path\\n\\tand \\u0001 then caf\xc3\xa9"));
+
+		ASSERT_EQUAL(jsonEscaped("", 0), std::string(""));
+		END_TEST;
+	}
+
+	DEFINE_TEST(jsonEscape_ShouldFindSpecialBytesAtEveryOffset)
+	{
+		// The escaper checks 8 bytes at a time, so move the quote through every position in a couple of words
+		for (size_t offset = 0; offset < 24; offset++)
+		{
+			std::string input(24, 'a');
+			input[offset] = '"';
+
+			std::string expected = input.substr(0, offset) + "\\\"" + input.substr(offset + 1);
+			ASSERT_EQUAL(jsonEscaped(input.c_str(), input.size()), expected);
+		}
+
+		END_TEST;
+	}
+
+	DEFINE_TEST(jsonFields_NanAndInfinityShouldBeNull)
+	{
+		g_logger_kv fields[] = {
+			g_logger_kv_float("nan", NAN),
+			g_logger_kv_float("inf", INFINITY),
+			g_logger_kv_float("negInf", -INFINITY),
+			g_logger_kv_float("ms", 1.5),
+			g_logger_kv_int("status", -404),
+			g_logger_kv_str("path", "/a\"b"),
+		};
+
+		ASSERT_EQUAL(jsonFields(fields, 6), std::string("\"nan\":null,\"inf\":null,\"negInf\":null,\"ms\":1.5,\"status\":-404,\"path\":\"/a\\\"b\""));
+		END_TEST;
+	}
+
+	DEFINE_TEST(configureChannels_ShouldSetGlobalAndChannelLevels)
+	{
+		bool configured = g_logger_configure_channels(" Warning , testNet = log ; testRender=4,");
+		g_logger_level globalLevel = g_logger_get_level();
+		g_logger_level netLevel = g_logger_get_channel_level("testNet");
+		g_logger_level renderLevel = g_logger_get_channel_level("testRender");
+
+		// Unknown levels fail, but the entries around them still get applied
+		bool configuredBadLevel = g_logger_configure_channels("testNet=loud,testRender=info");
+		g_logger_level netLevelAfter = g_logger_get_channel_level("testNet");
+		g_logger_level renderLevelAfter = g_logger_get_channel_level("testRender");
+
+		g_logger_configure_channels("all");
+
+		ASSERT_TRUE(configured);
+		ASSERT_EQUAL(globalLevel, g_logger_level_Warning);
+		ASSERT_EQUAL(netLevel, g_logger_level_Log);
+		ASSERT_EQUAL(renderLevel, g_logger_level_Error);
+		ASSERT_FALSE(configuredBadLevel);
+		// Its entry failed, so it follows the global level again, which the second config left alone
+		ASSERT_EQUAL(netLevelAfter, g_logger_level_Warning);
+		ASSERT_EQUAL(renderLevelAfter, g_logger_level_Info);
+		ASSERT_EQUAL(g_logger_get_channel_level("testRender"), g_logger_level_All);
+		END_TEST;
+	}
+
+	DEFINE_TEST(memorySink_ShouldOnlyGetWhatPassesTheChannelLevel)
+	{
+		g_logger_sink sink = g_logger_add_memory_sink(4096, g_logger_level_All, g_logger_format_Message);
+		g_logger_configure_channels("testSink=error");
+		g_logger_channel_info("testSink", "Filtered out %d", 1);
+		g_logger_channel_error("testSink", "Kept %d", 2);
+		g_logger_info("Also kept %s", "3");
+		g_logger_flush();
+
+		std::string contents = readMemorySink(sink);
+		g_logger_remove_sink(sink);
+		g_logger_configure_channels("all");
+
+		ASSERT_EQUAL(contents, std::string("Kept 2\nAlso kept 3\n"));
+		END_TEST;
+	}
+
+	DEFINE_TEST(memorySink_ShouldKeepTheNewestBytes)
+	{
+		g_logger_sink sink = g_logger_add_memory_sink(32, g_logger_level_All, g_logger_format_Message);
+		for (int i = 0; i < 10; i++)
+		{
+			g_logger_info("Message %d", i);
+		}
+		g_logger_flush();
+
+		std::string contents = readMemorySink(sink);
+		char small[8];
+		size_t smallLength = g_logger_read_memory_sink(sink, small, sizeof(small));
+		g_logger_remove_sink(sink);
+
+		// 10 bytes a message, so the buffer wrapped around a few times
+		ASSERT_EQUAL(contents, std::string("6\nMessage 7\nMessage 8\nMessage 9\n"));
+		ASSERT_EQUAL(std::string(small, smallLength), std::string("ssage 9\n"));
+		ASSERT_EQUAL(g_logger_read_memory_sink(g_logger_console_sink, small, sizeof(small)), 0);
+		END_TEST;
+	}
+
+	DEFINE_TEST(flightRecorder_ShouldApplyPrecisions)
+	{
+		FILE* dump = NULL;
+#ifdef _WIN32
+		tmpfile_s(&dump);
+#else
+		dump = tmpfile();
+#endif
+		ASSERT_NOT_NULL(dump);
+
+		g_logger_enable_flight_recorder(16, -1);
+		g_logger_debug("Precision %.2f %.3s %.*f %d", 3.14159, "abcdef", 1, 9.87654, 7);
+#ifdef _WIN32
+		g_logger_write_flight_recorder(_fileno(dump));
+#else
+		g_logger_write_flight_recorder(fileno(dump));
+#endif
+		glog_freeFlightRecorder();
+
+		char contents[4096];
+		rewind(dump);
+		size_t length = fread(contents, 1, sizeof(contents) - 1, dump);
+		contents[length] = '\0';
+		fclose(dump);
+
+		ASSERT_NOT_NULL(strstr(contents, "Precision 3.14 abc 9.9 7"));
+		END_TEST;
+	}
+
+	DEFINE_TEST(binaryPayload_ShouldRoundTrip)
+	{
+		// Flight records and deferred records share this layout, and glog_readArg decodes both
+		glog_FlightRecord record;
+		memset(&record, 0, sizeof(record));
+
+		int64 i = -12345678901;
+		uint64 u = 0xFEDCBA9876543210ull;
+		double f = -2.5;
+		char c = 'g';
+		const void* p = &record;
+		ASSERT_TRUE(glog_pushFlightArg(&record, glog_ArgType_I64, &i, sizeof(i)));
+		ASSERT_TRUE(glog_pushFlightArg(&record, glog_ArgType_U64, &u, sizeof(u)));
+		ASSERT_TRUE(glog_pushFlightArg(&record, glog_ArgType_F64, &f, sizeof(f)));
+		ASSERT_TRUE(glog_pushFlightArg(&record, glog_ArgType_Char, &c, sizeof(c)));
+		ASSERT_TRUE(glog_pushFlightArg(&record, glog_ArgType_Pointer, &p, sizeof(p)));
+		ASSERT_TRUE(glog_pushFlightString(&record, "hello", -1));
+		ASSERT_TRUE(glog_pushFlightString(&record, "truncated", 5));
+		ASSERT_TRUE(glog_pushFlightString(&record, nullptr, -1));
+
+		uint32 offset = 0;
+		glog_FlightArg arg;
+		ASSERT_TRUE(glog_readFlightArg(&record, 0, &offset, &arg));
+		ASSERT_EQUAL(arg.value.i, i);
+		ASSERT_TRUE(glog_readFlightArg(&record, 1, &offset, &arg));
+		ASSERT_EQUAL(arg.value.u, u);
+		ASSERT_TRUE(glog_readFlightArg(&record, 2, &offset, &arg));
+		ASSERT_EQUAL(arg.value.f, f);
+		ASSERT_TRUE(glog_readFlightArg(&record, 3, &offset, &arg));
+		ASSERT_EQUAL(arg.value.i, 'g');
+		ASSERT_TRUE(glog_readFlightArg(&record, 4, &offset, &arg));
+		ASSERT_EQUAL(arg.value.u, (uint64)(uintptr_t)p);
+		ASSERT_TRUE(glog_readFlightArg(&record, 5, &offset, &arg));
+		ASSERT_EQUAL(std::string(arg.value.s), std::string("hello"));
+		ASSERT_TRUE(glog_readFlightArg(&record, 6, &offset, &arg));
+		ASSERT_EQUAL(std::string(arg.value.s), std::string("trunc"));
+		ASSERT_TRUE(glog_readFlightArg(&record, 7, &offset, &arg));
+		ASSERT_EQUAL(std::string(arg.value.s), std::string("(null)"));
+
+		// Everything got read, and reading past the end fails instead of running off the payload
+		ASSERT_EQUAL(offset, record.payloadLength);
+		ASSERT_FALSE(glog_readFlightArg(&record, 8, &offset, &arg));
+		END_TEST;
+	}
+
+	DEFINE_TEST(binaryPayload_TruncatedPayloadShouldNotDecode)
+	{
+		uint8 argTypes[] = { (uint8)glog_ArgType_String };
+		uint8 payload[16];
+		uint32 length = 100;
+		memcpy(payload, &length, sizeof(length));
+
+		uint32 offset = 0;
+		glog_FlightArg arg;
+		ASSERT_FALSE(glog_readArg(argTypes, 1, payload, sizeof(payload), 0, &offset, &arg));
+		ASSERT_EQUAL(offset, 0);
+		END_TEST;
+	}
+
+#ifdef USE_GABE_CPP_PRINT
+	DEFINE_TEST(deferredPayload_ShouldRoundTrip)
+	{
+		// Encoded the way cppPrint style calls capture their arguments for deferred formatting
+		int8 i8 = -5;
+		uint16 u16 = 65000;
+		float f32 = 0.25f;
+		bool b = true;
+		const char* str = "deferred";
+		std::string cppStr = "std::string";
+
+		uint8 payload[128];
+		uint8* cursor = payload;
+		_g_logger_writeArg(cursor, i8);
+		_g_logger_writeArg(cursor, u16);
+		_g_logger_writeArg(cursor, f32);
+		_g_logger_writeArg(cursor, b);
+		_g_logger_writeArg(cursor, str);
+		_g_logger_writeArg(cursor, cppStr);
+		size_t payloadSize = (size_t)(cursor - payload);
+		ASSERT_EQUAL(payloadSize, _g_logger_argSize(i8) + _g_logger_argSize(u16) + _g_logger_argSize(f32)
+			+ _g_logger_argSize(b) + _g_logger_argSize(str) + _g_logger_argSize(cppStr));
+
+		// The typed reader the writer thread uses
+		const uint8* readCursor = payload;
+		ASSERT_EQUAL(_g_logger_readArg<int8>(readCursor), i8);
+		ASSERT_EQUAL(_g_logger_readArg<uint16>(readCursor), u16);
+		ASSERT_EQUAL(_g_logger_readArg<float>(readCursor), f32);
+		ASSERT_EQUAL(_g_logger_readArg<bool>(readCursor), b);
+		ASSERT_EQUAL(std::string(_g_logger_readArg<const char*>(readCursor)), std::string(str));
+		ASSERT_EQUAL(std::string(_g_logger_readArg<std::string>(readCursor)), cppStr);
+		ASSERT_EQUAL(readCursor, payload + payloadSize);
+
+		// And the untyped one deferred records and the decoder go through
+		const uint8 argTypes[] = {
+			(uint8)_g_logger_argType<int8>(), (uint8)_g_logger_argType<uint16>(), (uint8)_g_logger_argType<float>(),
+			(uint8)_g_logger_argType<bool>(), (uint8)_g_logger_argType<const char*>(), (uint8)_g_logger_argType<std::string>(),
+		};
+		uint32 offset = 0;
+		glog_FlightArg arg;
+		ASSERT_TRUE(glog_readArg(argTypes, 6, payload, (uint32)payloadSize, 0, &offset, &arg));
+		ASSERT_EQUAL(arg.value.i, i8);
+		ASSERT_TRUE(glog_readArg(argTypes, 6, payload, (uint32)payloadSize, 1, &offset, &arg));
+		ASSERT_EQUAL(arg.value.u, u16);
+		ASSERT_TRUE(glog_readArg(argTypes, 6, payload, (uint32)payloadSize, 2, &offset, &arg));
+		ASSERT_EQUAL(arg.value.f, f32);
+		ASSERT_TRUE(glog_readArg(argTypes, 6, payload, (uint32)payloadSize, 3, &offset, &arg));
+		ASSERT_EQUAL(arg.value.u, 1);
+		ASSERT_TRUE(glog_readArg(argTypes, 6, payload, (uint32)payloadSize, 4, &offset, &arg));
+		ASSERT_EQUAL(std::string(arg.value.s), std::string(str));
+		ASSERT_TRUE(glog_readArg(argTypes, 6, payload, (uint32)payloadSize, 5, &offset, &arg));
+		ASSERT_EQUAL(std::string(arg.value.s), cppStr);
+		ASSERT_EQUAL(offset, payloadSize);
+		END_TEST;
+	}
+#endif
+
+	void setupLoggerTestSuite()
+	{
+		Tests::TestSuite& testSuite = Tests::addTestSuite("cppUtils.hpp logger");
+
+		ADD_TEST(testSuite, jsonEscape_ShouldOnlyEscapeWhatJsonNeeds);
+		ADD_TEST(testSuite, jsonEscape_ShouldFindSpecialBytesAtEveryOffset);
+		ADD_TEST(testSuite, jsonFields_NanAndInfinityShouldBeNull);
+		ADD_TEST(testSuite, configureChannels_ShouldSetGlobalAndChannelLevels);
+		ADD_TEST(testSuite, memorySink_ShouldOnlyGetWhatPassesTheChannelLevel);
+		ADD_TEST(testSuite, memorySink_ShouldKeepTheNewestBytes);
+		ADD_TEST(testSuite, flightRecorder_ShouldApplyPrecisions);
+		ADD_TEST(testSuite, binaryPayload_ShouldRoundTrip);
+		ADD_TEST(testSuite, binaryPayload_TruncatedPayloadShouldNotDecode);
+#ifdef USE_GABE_CPP_PRINT
+		ADD_TEST(testSuite, deferredPayload_ShouldRoundTrip);
+#endif
 	}
 
 }
@@ -1440,8 +2814,12 @@ namespace CppUtilsTestSuite
 
 using namespace StringTestSuite;
 using namespace MaybeTestSuite;
+using namespace HandlePoolTestSuite;
 using namespace PrintTestSuite;
 using namespace ThreadPoolTestSuite;
+using namespace QueuesTestSuite;
+using namespace ThreadUtilsTestSuite;
+using namespace LoggerTestSuite;
 using namespace CppUtilsTestSuite;
 
 #include <vector>
@@ -1484,8 +2862,12 @@ void mainFunc()
 	{
 		setupCppStringsTestSuite();
 		//setupMaybeTestSuite();
+		setupHandlePoolTestSuite();
 		//setupPrintTestSuite();
-		//setupThreadPoolTestSuite();
+		setupThreadPoolTestSuite();
+		setupQueuesTestSuite();
+		setupThreadUtilsTestSuite();
+		setupLoggerTestSuite();
 		//setupCppUtilsTestSuite();
 
 		Tests::runTests();
@@ -0,0 +1,392 @@
+// ===================================================================================
+// Lock benchmark
+// Measures throughput (lock/unlock pairs per second) of g_thread_mutex and
+// g_thread_spinlock against the platform mutex behind g_thread_createMutex (a pthread
+// mutex on Linux, a critical section on Windows) and std::mutex, for 1 to N threads
+// hammering the same lock.
+//
+// A second table runs a read mostly load, where one lock in every writeEvery is a write,
+// and compares g_thread_mutex to g_thread_rwlock, std::shared_mutex and g_thread_seqlock.
+//
+// Usage: CppUtilsLockBench [locksPerThread] [maxThreads] [workOutsideLock] [writeEvery]
+//
+// workOutsideLock is how many iterations of busy work each thread does between locks.
+// 0 is worst case contention, bigger numbers look more like a real program.
+//
+// Build in release, the numbers from a debug build are meaningless.
+// ===================================================================================
+#define GABE_CPP_UTILS_IMPL
+#include <cppUtils/cppUtils.hpp>
+#undef GABE_CPP_UTILS_IMPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using BenchClock = std::chrono::steady_clock;
+
+enum class LockSetup
+{
+	Mutex,
+	Spinlock,
+	Platform,
+	StdMutex,
+};
+
+static const char* lockSetupName(LockSetup setup)
+{
+	switch (setup)
+	{
+	case LockSetup::Mutex: return "g_mutex";
+	case LockSetup::Spinlock: return "g_spinlock";
+#ifdef _WIN32
+	case LockSetup::Platform: return "critsec";
+#else
+	case LockSetup::Platform: return "pthread";
+#endif
+	case LockSetup::StdMutex: return "std::mutex";
+	}
+
+	return "unknown";
+}
+
+// Gives the platform mutex the same lock()/unlock() shape as the others
+struct PlatformMutex
+{
+	void* mtx;
+
+	void lock() { g_thread_lockMutex(mtx); }
+	void unlock() { g_thread_releaseMutex(mtx); }
+};
+
+// Stands in for the work a thread does between critical sections, the result only exists so the
+// compiler can't delete the loop
+static uint32 busyWork(uint32 seed, uint32 numIterations)
+{
+	for (uint32 i = 0; i < numIterations; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+	}
+	return seed;
+}
+
+template<typename Lock>
+static double runBench(Lock& lock, uint32 numThreads, uint32 locksPerThread, uint32 workOutsideLock)
+{
+	std::vector<std::thread> threads;
+	std::atomic<uint32> numReady{ 0 };
+	std::atomic<bool> go{ false };
+	std::atomic<uint32> sink{ 0 };
+	// A couple of cache lines of shared state so the critical section does something real
+	uint64 shared[16] = {};
+	uint64 numLocks = 0;
+
+	for (uint32 t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			uint32 seed = t + 1;
+			numReady++;
+			while (!go.load(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+
+			for (uint32 i = 0; i < locksPerThread; i++)
+			{
+				lock.lock();
+				numLocks++;
+				shared[i & 15] += seed;
+				lock.unlock();
+
+				seed = busyWork(seed, workOutsideLock);
+			}
+			sink += seed;
+		});
+	}
+
+	while (numReady.load() < numThreads)
+	{
+		std::this_thread::yield();
+	}
+
+	BenchClock::time_point start = BenchClock::now();
+	go.store(true, std::memory_order_release);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	if (numLocks != (uint64)numThreads * locksPerThread)
+	{
+		fprintf(stderr, "The lock let two threads in at once, the numbers below are wrong\n");
+	}
+
+	return (double)numThreads * locksPerThread / seconds;
+}
+
+static double runSetup(LockSetup setup, uint32 numThreads, uint32 locksPerThread, uint32 workOutsideLock)
+{
+	switch (setup)
+	{
+	case LockSetup::Mutex:
+	{
+		g_thread_mutex mtx = { 0, 0 };
+		return runBench(mtx, numThreads, locksPerThread, workOutsideLock);
+	}
+	case LockSetup::Spinlock:
+	{
+		g_thread_spinlock lock = { 0, 0 };
+		return runBench(lock, numThreads, locksPerThread, workOutsideLock);
+	}
+	case LockSetup::Platform:
+	{
+		PlatformMutex mtx = { g_thread_createMutex() };
+		double result = runBench(mtx, numThreads, locksPerThread, workOutsideLock);
+		g_thread_freeMutex(mtx.mtx);
+		return result;
+	}
+	case LockSetup::StdMutex:
+	{
+		std::mutex mtx;
+		return runBench(mtx, numThreads, locksPerThread, workOutsideLock);
+	}
+	}
+
+	return 0.0;
+}
+
+enum class ReadMostlySetup
+{
+	Mutex,
+	RwLock,
+	StdSharedMutex,
+	Seqlock,
+};
+
+static const char* readMostlySetupName(ReadMostlySetup setup)
+{
+	switch (setup)
+	{
+	case ReadMostlySetup::Mutex: return "g_mutex";
+	case ReadMostlySetup::RwLock: return "g_rwlock";
+	case ReadMostlySetup::StdSharedMutex: return "std::shared";
+	case ReadMostlySetup::Seqlock: return "g_seqlock";
+	}
+
+	return "unknown";
+}
+
+// Wrap each lock in read()/write() so the bench loop below is the same for all of them
+template<typename Lock>
+struct ExclusiveReads
+{
+	Lock lock;
+
+	template<typename Fn> void read(Fn&& fn) { std::lock_guard<Lock> guard(lock); fn(); }
+	template<typename Fn> void write(Fn&& fn) { std::lock_guard<Lock> guard(lock); fn(); }
+};
+
+template<typename Lock>
+struct SharedReads
+{
+	Lock lock;
+
+	template<typename Fn> void read(Fn&& fn) { std::shared_lock<Lock> guard(lock); fn(); }
+	template<typename Fn> void write(Fn&& fn) { std::lock_guard<Lock> guard(lock); fn(); }
+};
+
+struct SeqlockReads
+{
+	g_thread_seqlock lock;
+
+	template<typename Fn> void read(Fn&& fn)
+	{
+		uint32 sequence;
+		do
+		{
+			sequence = lock.readBegin();
+			fn();
+		} while (lock.readRetry(sequence));
+	}
+
+	template<typename Fn> void write(Fn&& fn)
+	{
+		lock.writeBegin();
+		fn();
+		lock.writeEnd();
+	}
+};
+
+template<typename Guard>
+static double runReadMostlyBench(Guard& guard, uint32 numThreads, uint32 locksPerThread, uint32 workOutsideLock, uint32 writeEvery)
+{
+	std::vector<std::thread> threads;
+	std::atomic<uint32> numReady{ 0 };
+	std::atomic<bool> go{ false };
+	std::atomic<uint64> sink{ 0 };
+	// Stands in for a config or routing table. Writes keep every entry equal so reads can check it.
+	volatile uint64 shared[16] = {};
+	uint64 numWrites = 0;
+	std::atomic<uint64> numBadReads{ 0 };
+
+	for (uint32 t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			uint32 seed = t + 1;
+			uint64 sum = 0;
+			numReady++;
+			while (!go.load(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+
+			for (uint32 i = 0; i < locksPerThread; i++)
+			{
+				if ((i + t) % writeEvery == 0)
+				{
+					guard.write([&]()
+					{
+						numWrites++;
+						for (uint32 entry = 0; entry < 16; entry++)
+						{
+							shared[entry] = shared[entry] + seed;
+						}
+					});
+				}
+				else
+				{
+					uint64 first = 0;
+					uint64 last = 0;
+					guard.read([&]()
+					{
+						first = shared[0];
+						last = shared[15];
+					});
+					numBadReads += first != last ? 1 : 0;
+					sum += first;
+				}
+
+				seed = busyWork(seed, workOutsideLock);
+			}
+			sink += sum;
+		});
+	}
+
+	while (numReady.load() < numThreads)
+	{
+		std::this_thread::yield();
+	}
+
+	BenchClock::time_point start = BenchClock::now();
+	go.store(true, std::memory_order_release);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	uint64 expectedWrites = 0;
+	for (uint32 t = 0; t < numThreads; t++)
+	{
+		for (uint32 i = 0; i < locksPerThread; i++)
+		{
+			expectedWrites += (i + t) % writeEvery == 0 ? 1 : 0;
+		}
+	}
+	if (numWrites != expectedWrites || numBadReads.load() != 0)
+	{
+		fprintf(stderr, "A reader saw a half finished write, the numbers below are wrong\n");
+	}
+
+	return (double)numThreads * locksPerThread / seconds;
+}
+
+static double runReadMostlySetup(ReadMostlySetup setup, uint32 numThreads, uint32 locksPerThread, uint32 workOutsideLock, uint32 writeEvery)
+{
+	switch (setup)
+	{
+	case ReadMostlySetup::Mutex:
+	{
+		ExclusiveReads<g_thread_mutex> guard = {};
+		return runReadMostlyBench(guard, numThreads, locksPerThread, workOutsideLock, writeEvery);
+	}
+	case ReadMostlySetup::RwLock:
+	{
+		SharedReads<g_thread_rwlock> guard = {};
+		return runReadMostlyBench(guard, numThreads, locksPerThread, workOutsideLock, writeEvery);
+	}
+	case ReadMostlySetup::StdSharedMutex:
+	{
+		SharedReads<std::shared_mutex> guard;
+		return runReadMostlyBench(guard, numThreads, locksPerThread, workOutsideLock, writeEvery);
+	}
+	case ReadMostlySetup::Seqlock:
+	{
+		SeqlockReads guard = {};
+		return runReadMostlyBench(guard, numThreads, locksPerThread, workOutsideLock, writeEvery);
+	}
+	}
+
+	return 0.0;
+}
+
+int main(int argc, char** argv)
+{
+	uint32 locksPerThread = argc > 1 ? (uint32)strtoul(argv[1], nullptr, 10) : 1000000;
+	uint32 maxThreads = argc > 2 ? (uint32)strtoul(argv[2], nullptr, 10) : (uint32)std::thread::hardware_concurrency();
+	uint32 workOutsideLock = argc > 3 ? (uint32)strtoul(argv[3], nullptr, 10) : 50;
+	uint32 writeEvery = argc > 4 ? (uint32)strtoul(argv[4], nullptr, 10) : 100;
+	if (locksPerThread == 0 || maxThreads == 0 || writeEvery == 0)
+	{
+		fprintf(stderr, "Usage: %s [locksPerThread] [maxThreads] [workOutsideLock] [writeEvery]\n", argv[0]);
+		return 1;
+	}
+
+	fprintf(stderr, "%u locks per thread, up to %u threads, %u iterations of work between locks.\n\n", locksPerThread, maxThreads, workOutsideLock);
+	fprintf(stderr, "%-10s %7s %14s\n", "lock", "threads", "locks/sec");
+
+	const LockSetup setups[] = { LockSetup::Mutex, LockSetup::Spinlock, LockSetup::Platform, LockSetup::StdMutex };
+	for (LockSetup setup : setups)
+	{
+		// 1, 2, 4, ... and always maxThreads itself
+		for (uint32 numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+		{
+			double locksPerSecond = runSetup(setup, numThreads, locksPerThread, workOutsideLock);
+			fprintf(stderr, "%-10s %7u %14.0f\n", lockSetupName(setup), numThreads, locksPerSecond);
+
+			if (numThreads == maxThreads)
+			{
+				break;
+			}
+		}
+	}
+
+	fprintf(stderr, "\nRead mostly, one write in every %u locks.\n\n", writeEvery);
+	fprintf(stderr, "%-11s %7s %14s\n", "lock", "threads", "locks/sec");
+
+	const ReadMostlySetup readMostlySetups[] = { ReadMostlySetup::Mutex, ReadMostlySetup::RwLock, ReadMostlySetup::StdSharedMutex, ReadMostlySetup::Seqlock };
+	for (ReadMostlySetup setup : readMostlySetups)
+	{
+		for (uint32 numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+		{
+			double locksPerSecond = runReadMostlySetup(setup, numThreads, locksPerThread, workOutsideLock, writeEvery);
+			fprintf(stderr, "%-11s %7u %14.0f\n", readMostlySetupName(setup), numThreads, locksPerSecond);
+
+			if (numThreads == maxThreads)
+			{
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,242 @@
+// ===================================================================================
+// Logger benchmark
+// Measures throughput (messages per second) and caller side latency (p50/p99/p999)
+// of the g_logger_* macros for 1 to N producer threads and a handful of sink setups.
+//
+// Usage: CppUtilsLogBench [messagesPerThread] [maxThreads] > /dev/null
+//        CppUtilsLogBenchBinary [messagesPerThread] [maxThreads] > /dev/null
+//
+// Results go to stderr. Redirect stdout so the console runs don't measure your
+// terminal, and build in release, the numbers from a debug build are meaningless.
+//
+// NOTE: Binary sink runs need cppPrint style logging, which switches every log call
+//       in the program over. So they get their own build of this file,
+//       CppUtilsLogBenchBinary (GABE_LOG_BENCH_BINARY), and CppUtilsLogBench times
+//       printf style logging for the other sinks. cppPrint only builds on Windows
+//       for now, so CMake only creates the binary build there.
+// ===================================================================================
+#if defined(GABE_LOG_BENCH_BINARY) && defined(_WIN32)
+#define USE_GABE_CPP_PRINT
+
+#define GABE_CPP_PRINT_IMPL
+#include <cppUtils/cppPrint.hpp>
+#undef GABE_CPP_PRINT_IMPL
+#endif
+
+#define GABE_CPP_UTILS_IMPL
+#include <cppUtils/cppUtils.hpp>
+#undef GABE_CPP_UTILS_IMPL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using BenchClock = std::chrono::steady_clock;
+
+// cppPrint style logging uses {} instead of printf specifiers
+#ifdef USE_GABE_CPP_PRINT
+#define BENCH_FORMAT(printfFormat, cppPrintFormat) cppPrintFormat
+#else
+#define BENCH_FORMAT(printfFormat, cppPrintFormat) printfFormat
+#endif
+
+enum class SinkSetup
+{
+	Console,
+	File,
+	Async,
+	Binary,
+};
+
+static const char* sinkSetupName(SinkSetup setup)
+{
+	switch (setup)
+	{
+	case SinkSetup::Console: return "console";
+	case SinkSetup::File: return "file";
+	case SinkSetup::Async: return "async";
+	case SinkSetup::Binary: return "binary";
+	}
+
+	return "unknown";
+}
+
+struct BenchResult
+{
+	double messagesPerSecond;
+	uint64 p50;
+	uint64 p99;
+	uint64 p999;
+	uint64 max;
+};
+
+static const char* benchPaths[] = { "/api/v1/users", "/static/app.js", "/health", "/api/v1/orders/checkout" };
+
+// Cycles through the kinds of calls a real program makes: a plain string, ints, floats and a mix of all three
+static void logMessage(uint32 threadIndex, uint32 i)
+{
+	const char* path = benchPaths[i & 3];
+	switch (i & 3)
+	{
+	case 0:
+		g_logger_info("Worker started processing the next batch");
+		break;
+	case 1:
+		g_logger_info(BENCH_FORMAT("Thread %u finished job %u with status %d", "Thread {} finished job {} with status {}"), threadIndex, i, (int)(i % 500));
+		break;
+	case 2:
+		g_logger_info(BENCH_FORMAT("Frame %u took %f ms, %f%% of budget", "Frame {} took {} ms, {}% of budget"), i, (double)(i % 1000) * 0.016, (double)(i % 100));
+		break;
+	case 3:
+		g_logger_info(BENCH_FORMAT("Request %u for %s from thread %u took %f ms", "Request {} for {} from thread {} took {} ms"), i, path, threadIndex, (double)(i % 250) * 0.1);
+		break;
+	}
+}
+
+static bool setupSinks(SinkSetup setup)
+{
+	g_logger_init();
+
+	switch (setup)
+	{
+	case SinkSetup::Console:
+		return true;
+	case SinkSetup::File:
+		g_logger_set_sink_level(g_logger_console_sink, g_logger_level_None);
+		return g_logger_add_file_sink("logBench.log", g_logger_level_All, g_logger_format_Default) >= 0;
+	case SinkSetup::Async:
+		g_logger_set_sink_level(g_logger_console_sink, g_logger_level_None);
+		g_logger_enable_async(1 << 16, g_logger_overflow_Block);
+		return g_logger_add_file_sink("logBench.log", g_logger_level_All, g_logger_format_Default) >= 0;
+	case SinkSetup::Binary:
+#ifdef USE_GABE_CPP_PRINT
+		g_logger_set_sink_level(g_logger_console_sink, g_logger_level_None);
+		g_logger_enable_async(1 << 16, g_logger_overflow_Block);
+		g_logger_set_deferred_formatting(true);
+		return g_logger_set_binary_log_file("logBench.glog");
+#else
+		return false;
+#endif
+	}
+
+	return false;
+}
+
+static uint64 percentile(const std::vector<uint64>& sortedLatencies, double fraction)
+{
+	size_t index = (size_t)(fraction * (double)(sortedLatencies.size() - 1));
+	return sortedLatencies[index];
+}
+
+static BenchResult runBench(uint32 numThreads, uint32 messagesPerThread)
+{
+	std::vector<std::vector<uint64>> latencies(numThreads);
+	std::vector<std::thread> threads;
+	std::atomic<uint32> numReady{ 0 };
+	std::atomic<bool> go{ false };
+
+	for (uint32 t = 0; t < numThreads; t++)
+	{
+		latencies[t].resize(messagesPerThread);
+		threads.emplace_back([&, t]()
+		{
+			uint64* threadLatencies = latencies[t].data();
+			numReady++;
+			while (!go.load(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+
+			for (uint32 i = 0; i < messagesPerThread; i++)
+			{
+				BenchClock::time_point start = BenchClock::now();
+				logMessage(t, i);
+				BenchClock::time_point end = BenchClock::now();
+				threadLatencies[i] = (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+			}
+		});
+	}
+
+	while (numReady.load() < numThreads)
+	{
+		std::this_thread::yield();
+	}
+
+	BenchClock::time_point start = BenchClock::now();
+	go.store(true, std::memory_order_release);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	// Throughput counts the time it takes to get everything written, not just queued
+	g_logger_flush();
+	double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	std::vector<uint64> allLatencies;
+	allLatencies.reserve((size_t)numThreads * messagesPerThread);
+	for (const std::vector<uint64>& threadLatencies : latencies)
+	{
+		allLatencies.insert(allLatencies.end(), threadLatencies.begin(), threadLatencies.end());
+	}
+	std::sort(allLatencies.begin(), allLatencies.end());
+
+	BenchResult result;
+	result.messagesPerSecond = (double)allLatencies.size() / seconds;
+	result.p50 = percentile(allLatencies, 0.5);
+	result.p99 = percentile(allLatencies, 0.99);
+	result.p999 = percentile(allLatencies, 0.999);
+	result.max = allLatencies.back();
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	uint32 messagesPerThread = argc > 1 ? (uint32)strtoul(argv[1], nullptr, 10) : 100000;
+	uint32 maxThreads = argc > 2 ? (uint32)strtoul(argv[2], nullptr, 10) : (uint32)std::thread::hardware_concurrency();
+	if (messagesPerThread == 0 || maxThreads == 0)
+	{
+		fprintf(stderr, "Usage: %s [messagesPerThread] [maxThreads] > /dev/null\n", argv[0]);
+		return 1;
+	}
+
+	fprintf(stderr, "%u messages per thread, up to %u threads. Latencies are in nanoseconds.\n\n", messagesPerThread, maxThreads);
+	fprintf(stderr, "%-8s %7s %14s %10s %10s %10s %12s\n", "sink", "threads", "msgs/sec", "p50", "p99", "p999", "max");
+
+#ifdef GABE_LOG_BENCH_BINARY
+	const SinkSetup setups[] = { SinkSetup::Binary };
+#else
+	const SinkSetup setups[] = { SinkSetup::Console, SinkSetup::File, SinkSetup::Async };
+#endif
+	for (SinkSetup setup : setups)
+	{
+		// 1, 2, 4, ... and always maxThreads itself
+		for (uint32 numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+		{
+			if (!setupSinks(setup))
+			{
+				g_logger_free();
+				fprintf(stderr, "%-8s skipped, this sink isn't available here\n", sinkSetupName(setup));
+				break;
+			}
+
+			BenchResult result = runBench(numThreads, messagesPerThread);
+			g_logger_free();
+
+			fprintf(stderr, "%-8s %7u %14.0f %10llu %10llu %10llu %12llu\n", sinkSetupName(setup), numThreads, result.messagesPerSecond,
+				(unsigned long long)result.p50, (unsigned long long)result.p99, (unsigned long long)result.p999, (unsigned long long)result.max);
+
+			if (numThreads == maxThreads)
+			{
+				break;
+			}
+		}
+	}
+
+	remove("logBench.log");
+	remove("logBench.glog");
+	return 0;
+}
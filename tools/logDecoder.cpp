@@ -0,0 +1,321 @@
+// ===================================================================================
+// Binary log decoder
+// Formats a binary log written with g_logger_set_binary_log_file(...) back into the
+// same text the logger would have printed in the first place.
+//
+// Usage: CppUtilsLogDecoder <path/to/binary/log>
+//
+// NOTE: Pointers are stored with the size they had in the process that wrote the log,
+//       so decode logs on the same architecture they were written on.
+// ===================================================================================
+#define GABE_CPP_PRINT_IMPL
+#include <cppUtils/cppPrint.hpp>
+#undef GABE_CPP_PRINT_IMPL
+
+#define GABE_CPP_UTILS_IMPL
+#include <cppUtils/cppUtils.hpp>
+#undef GABE_CPP_UTILS_IMPL
+
+#define GABE_CPP_STRING_IMPL
+#include <cppUtils/cppStrings.hpp>
+#undef GABE_CPP_STRING_IMPL
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace CppUtils;
+
+struct DecodedSite
+{
+	uint32 id;
+	uint32 level;
+	uint32 line;
+	uint8 color;
+	std::string filename;
+	std::string format;
+	std::vector<uint8> argTypes;
+};
+
+struct Reader
+{
+	const uint8* data;
+	size_t size;
+	size_t cursor;
+
+	bool read(void* dst, size_t numBytes)
+	{
+		if (cursor + numBytes > size)
+		{
+			return false;
+		}
+
+		memcpy(dst, data + cursor, numBytes);
+		cursor += numBytes;
+		return true;
+	}
+
+	bool readString(std::string& dst, size_t numBytes)
+	{
+		if (cursor + numBytes > size)
+		{
+			return false;
+		}
+
+		dst.assign((const char*)(data + cursor), numBytes);
+		cursor += numBytes;
+		return true;
+	}
+};
+
+template<typename T>
+static bool printArg(Reader& payload, const char* modifiers, size_t modifiersLength)
+{
+	T value;
+	if (!payload.read(&value, sizeof(T)))
+	{
+		return false;
+	}
+
+	IO::stdoutStream.parseModifiers(modifiers, modifiersLength);
+	IO::stdoutStream << value;
+	IO::stdoutStream.resetModifiers();
+	return true;
+}
+
+static bool printNextArg(Reader& payload, _g_logger_ArgType type, const char* modifiers, size_t modifiersLength)
+{
+	switch (type)
+	{
+	case _g_logger_ArgType::I8: return printArg<int8>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::I16: return printArg<int16>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::I32: return printArg<int32>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::I64: return printArg<int64>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::U8: return printArg<uint8>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::U16: return printArg<uint16>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::U32: return printArg<uint32>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::U64: return printArg<uint64>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::F32: return printArg<float>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::F64: return printArg<double>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::Char: return printArg<char>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::Pointer: return printArg<void*>(payload, modifiers, modifiersLength);
+	case _g_logger_ArgType::Bool:
+	{
+		bool value;
+		if (!payload.read(&value, sizeof(bool)))
+		{
+			return false;
+		}
+
+		const char* str = value ? "true" : "false";
+		IO::stdoutStream.parseModifiers(modifiers, modifiersLength);
+		IO::stdoutStream << str;
+		IO::stdoutStream.resetModifiers();
+		return true;
+	}
+	case _g_logger_ArgType::String:
+	{
+		uint32 length;
+		std::string str;
+		if (!payload.read(&length, sizeof(uint32)) || !payload.readString(str, length + 1))
+		{
+			return false;
+		}
+
+		const char* cStr = str.c_str();
+		IO::stdoutStream.parseModifiers(modifiers, modifiersLength);
+		IO::stdoutStream << cStr;
+		IO::stdoutStream.resetModifiers();
+		return true;
+	}
+	case _g_logger_ArgType::Unsupported:
+		break;
+	}
+
+	return false;
+}
+
+// Walks the format string exactly like IO::printf does, pulling one argument per {} pair
+static bool printMessage(const DecodedSite& site, Reader& payload)
+{
+	const std::string& format = site.format;
+	size_t argIndex = 0;
+	size_t literalStart = 0;
+	for (size_t i = 0; i < format.size(); i++)
+	{
+		if (format[i] != '{')
+		{
+			continue;
+		}
+
+		IO::_printfInternal(format.c_str() + literalStart, i - literalStart);
+		if (i + 1 < format.size() && format[i + 1] == '{')
+		{
+			IO::_printfInternal("{", 1);
+			i++;
+			literalStart = i + 1;
+			continue;
+		}
+
+		size_t closingBracket = format.find('}', i + 1);
+		if (closingBracket == std::string::npos || argIndex >= site.argTypes.size())
+		{
+			return false;
+		}
+
+		if (!printNextArg(payload, (_g_logger_ArgType)site.argTypes[argIndex], format.c_str() + i + 1, closingBracket - i - 1))
+		{
+			return false;
+		}
+
+		argIndex++;
+		i = closingBracket;
+		literalStart = i + 1;
+	}
+
+	IO::_printfInternal(format.c_str() + literalStart, format.size() - literalStart);
+	return true;
+}
+
+static bool readSite(Reader& reader, std::vector<DecodedSite>& sites)
+{
+	DecodedSite site = {};
+	uint16 filenameLength;
+	uint16 formatLength;
+	uint8 numArgs;
+	if (!reader.read(&site.id, sizeof(site.id))
+		|| !reader.read(&site.level, sizeof(site.level))
+		|| !reader.read(&site.line, sizeof(site.line))
+		|| !reader.read(&site.color, sizeof(site.color))
+		|| !reader.read(&filenameLength, sizeof(filenameLength))
+		|| !reader.readString(site.filename, filenameLength)
+		|| !reader.read(&formatLength, sizeof(formatLength))
+		|| !reader.readString(site.format, formatLength)
+		|| !reader.read(&numArgs, sizeof(numArgs)))
+	{
+		return false;
+	}
+
+	site.argTypes.resize(numArgs);
+	if (numArgs > 0 && !reader.read(site.argTypes.data(), numArgs))
+	{
+		return false;
+	}
+
+	if (site.id == 0)
+	{
+		return false;
+	}
+
+	if (sites.size() < site.id)
+	{
+		sites.resize(site.id);
+	}
+	sites[site.id - 1] = std::move(site);
+	return true;
+}
+
+static bool readRecord(Reader& reader, const std::vector<DecodedSite>& sites, uint32 version)
+{
+	uint32 siteId;
+	int64 unixTime;
+	// Version 1 files only stored whole seconds
+	uint32 microseconds = 0;
+	uint32 payloadLength;
+	if (!reader.read(&siteId, sizeof(siteId))
+		|| !reader.read(&unixTime, sizeof(unixTime))
+		|| (version >= 2 && !reader.read(&microseconds, sizeof(microseconds)))
+		|| !reader.read(&payloadLength, sizeof(payloadLength))
+		|| reader.cursor + payloadLength > reader.size
+		|| siteId == 0
+		|| siteId > sites.size())
+	{
+		return false;
+	}
+
+	const DecodedSite& site = sites[siteId - 1];
+	Reader payload = { reader.data + reader.cursor, payloadLength, 0 };
+	reader.cursor += payloadLength;
+
+	time_t time = (time_t)unixTime;
+	char buf[32] = { 0 };
+	size_t length = strftime(buf, sizeof(buf), "%Y-%m-%d %I:%M:%S", localtime(&time));
+	if (version >= 2)
+	{
+		snprintf(buf + length, sizeof(buf) - length, ".%06u", microseconds);
+	}
+
+	IO::setForegroundColor((ConsoleColor)site.color);
+	IO::printf("{} (line {}) Log: \n", site.filename.c_str(), site.line);
+	IO::resetColor();
+	IO::printf("[{}]: ", (const char*)buf);
+	if (!printMessage(site, payload))
+	{
+		IO::printf("\n");
+		return false;
+	}
+	IO::printf("\n");
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		printf("Usage: %s <path/to/binary/log>\n", argv[0]);
+		return 1;
+	}
+
+	FILE* file = fopen(argv[1], "rb");
+	if (!file)
+	{
+		printf("Failed to open '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<uint8> data;
+	uint8 chunk[4096];
+	size_t numRead;
+	while ((numRead = fread(chunk, 1, sizeof(chunk), file)) > 0)
+	{
+		data.insert(data.end(), chunk, chunk + numRead);
+	}
+	fclose(file);
+
+	Reader reader = { data.data(), data.size(), 0 };
+	char magic[8];
+	uint32 version;
+	if (!reader.read(magic, sizeof(magic)) || memcmp(magic, "GLOGBIN1", sizeof(magic)) != 0
+		|| !reader.read(&version, sizeof(version)) || version == 0 || version > 2)
+	{
+		printf("'%s' is not a binary log file.\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<DecodedSite> sites;
+	while (reader.cursor < reader.size)
+	{
+		uint8 tag;
+		reader.read(&tag, sizeof(tag));
+
+		bool success = false;
+		if (tag == 1)
+		{
+			success = readSite(reader, sites);
+		}
+		else if (tag == 2)
+		{
+			success = readRecord(reader, sites, version);
+		}
+
+		if (!success)
+		{
+			// A crash can leave a half written record at the end, everything before it is still good
+			printf("Stopped decoding at corrupt or truncated data (byte offset %zu).\n", reader.cursor);
+			return 1;
+		}
+	}
+
+	return 0;
+}
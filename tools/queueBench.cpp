@@ -0,0 +1,278 @@
+// ===================================================================================
+// Queue benchmark
+// Measures throughput (items handed from producers to consumers per second) of the
+// cppQueues.hpp queues against a std::mutex + std::deque baseline, for 1 to N
+// producer/consumer pairs.
+//
+// Usage: CppUtilsQueueBench [itemsPerProducer] [maxPairs]
+//
+// Build in release, the numbers from a debug build are meaningless.
+//
+// NOTE: SpscQueue only allows one producer and one consumer, so it only runs with a
+//       single pair.
+// ===================================================================================
+#define GABE_CPP_UTILS_IMPL
+#include <cppUtils/cppUtils.hpp>
+#undef GABE_CPP_UTILS_IMPL
+
+#include <cppUtils/cppQueues.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace CppUtils;
+
+using BenchClock = std::chrono::steady_clock;
+
+static constexpr size_t queueCapacity = 4096;
+static constexpr size_t batchSize = 32;
+
+// What a lot of programs do today, and the thing the lock free queues have to beat
+struct MutexQueue
+{
+	std::mutex mutex;
+	std::deque<uint64> items;
+
+	bool push(uint64 item)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (items.size() >= queueCapacity)
+		{
+			return false;
+		}
+		items.push_back(item);
+		return true;
+	}
+
+	bool pop(uint64& out)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (items.empty())
+		{
+			return false;
+		}
+		out = items.front();
+		items.pop_front();
+		return true;
+	}
+};
+
+enum class QueueSetup
+{
+	Mutex,
+	Spsc,
+	Mpmc,
+	MpmcBatch,
+};
+
+static const char* queueSetupName(QueueSetup setup)
+{
+	switch (setup)
+	{
+	case QueueSetup::Mutex: return "mutex";
+	case QueueSetup::Spsc: return "spsc";
+	case QueueSetup::Mpmc: return "mpmc";
+	case QueueSetup::MpmcBatch: return "mpmc-batch";
+	}
+
+	return "unknown";
+}
+
+template<bool Batched, typename Queue>
+static void produce(Queue& queue, uint64 first, uint32 count)
+{
+	if constexpr (Batched)
+	{
+		uint64 items[batchSize];
+		uint32 numPushed = 0;
+		while (numPushed < count)
+		{
+			size_t numItems = std::min((size_t)(count - numPushed), batchSize);
+			for (size_t i = 0; i < numItems; i++)
+			{
+				items[i] = first + numPushed + i;
+			}
+
+			size_t numInBatch = 0;
+			while (numInBatch < numItems)
+			{
+				size_t numAdded = queue.pushBatch(items + numInBatch, numItems - numInBatch);
+				if (numAdded == 0)
+				{
+					std::this_thread::yield();
+				}
+				numInBatch += numAdded;
+			}
+			numPushed += (uint32)numItems;
+		}
+		return;
+	}
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		while (!queue.push(first + i))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+// Keeps popping until every producer's items have been taken out by someone, returns the sum so
+// the compiler can't throw the work away
+template<bool Batched, typename Queue>
+static uint64 consume(Queue& queue, std::atomic<uint64>& numLeft)
+{
+	uint64 sum = 0;
+	uint64 items[batchSize];
+	while (numLeft.load(std::memory_order_relaxed) > 0)
+	{
+		size_t numPopped = 0;
+		if constexpr (Batched)
+		{
+			numPopped = queue.popBatch(items, batchSize);
+		}
+		else if (queue.pop(items[0]))
+		{
+			numPopped = 1;
+		}
+
+		if (numPopped == 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		for (size_t i = 0; i < numPopped; i++)
+		{
+			sum += items[i];
+		}
+		numLeft.fetch_sub(numPopped, std::memory_order_relaxed);
+	}
+	return sum;
+}
+
+template<bool Batched, typename Queue>
+static double runBench(Queue& queue, uint32 numPairs, uint32 itemsPerProducer)
+{
+	std::vector<std::thread> threads;
+	std::atomic<uint64> numLeft{ (uint64)numPairs * itemsPerProducer };
+	std::atomic<uint64> totalSum{ 0 };
+	std::atomic<uint32> numReady{ 0 };
+	std::atomic<bool> go{ false };
+
+	auto waitForGo = [&]()
+	{
+		numReady++;
+		while (!go.load(std::memory_order_acquire))
+		{
+			std::this_thread::yield();
+		}
+	};
+
+	for (uint32 p = 0; p < numPairs; p++)
+	{
+		threads.emplace_back([&, p]()
+		{
+			waitForGo();
+			produce<Batched>(queue, (uint64)p * itemsPerProducer, itemsPerProducer);
+		});
+		threads.emplace_back([&]()
+		{
+			waitForGo();
+			totalSum += consume<Batched>(queue, numLeft);
+		});
+	}
+
+	while (numReady.load() < numPairs * 2)
+	{
+		std::this_thread::yield();
+	}
+
+	BenchClock::time_point start = BenchClock::now();
+	go.store(true, std::memory_order_release);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	uint64 numItems = (uint64)numPairs * itemsPerProducer;
+	if (totalSum.load() != numItems * (numItems - 1) / 2)
+	{
+		fprintf(stderr, "Items were lost or duplicated, the numbers below are wrong\n");
+	}
+
+	return (double)numItems / seconds;
+}
+
+static double runSetup(QueueSetup setup, uint32 numPairs, uint32 itemsPerProducer)
+{
+	switch (setup)
+	{
+	case QueueSetup::Mutex:
+	{
+		MutexQueue queue;
+		return runBench<false>(queue, numPairs, itemsPerProducer);
+	}
+	case QueueSetup::Spsc:
+	{
+		SpscQueue<uint64> queue = {};
+		queue.init(queueCapacity);
+		double result = runBench<false>(queue, numPairs, itemsPerProducer);
+		queue.free();
+		return result;
+	}
+	case QueueSetup::Mpmc:
+	case QueueSetup::MpmcBatch:
+	{
+		MpmcQueue<uint64> queue = {};
+		queue.init(queueCapacity);
+		double result = setup == QueueSetup::MpmcBatch
+			? runBench<true>(queue, numPairs, itemsPerProducer)
+			: runBench<false>(queue, numPairs, itemsPerProducer);
+		queue.free();
+		return result;
+	}
+	}
+
+	return 0.0;
+}
+
+int main(int argc, char** argv)
+{
+	uint32 itemsPerProducer = argc > 1 ? (uint32)strtoul(argv[1], nullptr, 10) : 1000000;
+	uint32 maxPairs = argc > 2 ? (uint32)strtoul(argv[2], nullptr, 10) : std::max((uint32)std::thread::hardware_concurrency() / 2, (uint32)1);
+	if (itemsPerProducer == 0 || maxPairs == 0)
+	{
+		fprintf(stderr, "Usage: %s [itemsPerProducer] [maxPairs]\n", argv[0]);
+		return 1;
+	}
+
+	fprintf(stderr, "%u items per producer, up to %u producer/consumer pairs, queue capacity %zu.\n\n", itemsPerProducer, maxPairs, queueCapacity);
+	fprintf(stderr, "%-10s %7s %14s\n", "queue", "pairs", "items/sec");
+
+	const QueueSetup setups[] = { QueueSetup::Mutex, QueueSetup::Spsc, QueueSetup::Mpmc, QueueSetup::MpmcBatch };
+	for (QueueSetup setup : setups)
+	{
+		// 1, 2, 4, ... and always maxPairs itself
+		for (uint32 numPairs = 1; ; numPairs = std::min(numPairs * 2, maxPairs))
+		{
+			double itemsPerSecond = runSetup(setup, numPairs, itemsPerProducer);
+			fprintf(stderr, "%-10s %7u %14.0f\n", queueSetupName(setup), numPairs, itemsPerSecond);
+
+			if (numPairs == maxPairs || setup == QueueSetup::Spsc)
+			{
+				break;
+			}
+		}
+	}
+
+	return 0;
+}